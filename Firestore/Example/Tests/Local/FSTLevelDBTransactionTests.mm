@@ -222,6 +222,7 @@ using firebase::firestore::local::LevelDbTransaction;
     transaction.Delete(key);
     it->Next();
   }
+  XCTAssertFalse(it->Valid());
 }
 
 - (void)testCanIterateFromDeletionToCommitted {
@@ -272,6 +273,104 @@ using firebase::firestore::local::LevelDbTransaction;
   XCTAssertFalse(it->Valid());
 }
 
+- (void)testKeyAndValueSurviveChanges {
+  for (int i = 0; i < 2; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  // Iterate to a pending mutation, then change it. The iterator should still see the entry it
+  // was at, and carry on from there.
+  LevelDbTransaction transaction(_db.get());
+  transaction.Put("key_0", "new_value");
+  auto it = transaction.NewIterator();
+  it->Seek("key_0");
+  XCTAssertTrue(it->Valid());
+  transaction.Put("key_0", "a value that's too long to fit in a short string");
+  transaction.Delete("key_0");
+  transaction.Put("key_00", "inserted");
+  XCTAssertEqual("key_0", it->key());
+  XCTAssertEqual("new_value", it->value());
+  it->Next();
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("key_00", it->key());
+  XCTAssertEqual("inserted", it->value());
+  it->Next();
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("key_1", it->key());
+  XCTAssertEqual("value_1", it->value());
+  it->Next();
+  XCTAssertFalse(it->Valid());
+}
+
+- (void)testIteratesMergedView {
+  // Commit every second key, then update every third and delete every fifth in a transaction.
+  for (int i = 0; i < 100; i += 2) {
+    Status status =
+        _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(100 + i), "db");
+    XCTAssertTrue(status.ok());
+  }
+  LevelDbTransaction transaction(_db.get());
+  for (int i = 0; i < 100; i += 3) {
+    transaction.Put("key_" + std::to_string(100 + i), "txn");
+  }
+  for (int i = 0; i < 100; i += 5) {
+    transaction.Delete("key_" + std::to_string(100 + i));
+  }
+
+  auto it = transaction.NewIterator();
+  it->Seek("");
+  for (int i = 0; i < 100; ++i) {
+    bool inTransaction = i % 3 == 0;
+    bool inDb = i % 2 == 0;
+    if (i % 5 == 0 || !(inTransaction || inDb)) {
+      continue;
+    }
+    XCTAssertTrue(it->Valid());
+    XCTAssertEqual("key_" + std::to_string(100 + i), it->key());
+    XCTAssertEqual(inTransaction ? "txn" : "db", it->value());
+    it->Next();
+  }
+  XCTAssertFalse(it->Valid());
+}
+
+- (void)testScan {
+  for (const std::string &key : {"a", "b/1", "b/2", "b/4", "b0"}) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), key, key);
+    XCTAssertTrue(status.ok());
+  }
+  LevelDbTransaction transaction(_db.get());
+  transaction.Put("b/3", "value");
+  transaction.Delete("b/2");
+
+  // Scanning a prefix visits only the keys that start with it.
+  auto it = transaction.Scan("b/");
+  XCTAssertEqual("b/1", it->key());
+  it->Next();
+  XCTAssertEqual("b/3", it->key());
+  it->Next();
+  XCTAssertEqual("b/4", it->key());
+  it->Next();
+  XCTAssertFalse(it->Valid());
+
+  // Scanning a range stops before the limit.
+  LevelDbTransaction::ScanOptions options;
+  options.fill_cache = false;
+  it = transaction.Scan("b/2", "b/4", options);
+  XCTAssertEqual("b/3", it->key());
+  it->Next();
+  XCTAssertFalse(it->Valid());
+
+  // An empty limit scans to the end.
+  it = transaction.Scan("b/4", "");
+  XCTAssertEqual("b/4", it->key());
+  it->Next();
+  XCTAssertEqual("b0", it->key());
+  it->Next();
+  XCTAssertFalse(it->Valid());
+}
+
 - (void)testToString {
   std::string key = LevelDbMutationKey::Key("user1", 42);
   FSTPBWriteBatch *message = [FSTPBWriteBatch message];
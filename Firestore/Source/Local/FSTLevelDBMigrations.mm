@@ -16,7 +16,6 @@
 
 #include "Firestore/Source/Local/FSTLevelDBMigrations.h"
 
-#include <absl/strings/match.h>
 #include "leveldb/write_batch.h"
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
@@ -66,14 +65,14 @@ static void SaveVersion(FSTLevelDBSchemaVersion version, LevelDbTransaction *tra
  * It assumes the metadata has already been written and is able to be read in this transaction.
  */
 static void AddTargetCount(LevelDbTransaction *transaction) {
-  auto it = transaction->NewIterator();
-  std::string start_key = [FSTLevelDBTargetKey keyPrefix];
-  it->Seek(start_key);
+  // This only runs once, so there's no point caching the targets it reads.
+  LevelDbTransaction::ScanOptions options;
+  options.fill_cache = false;
+  auto it = transaction->Scan([FSTLevelDBTargetKey keyPrefix], options);
 
   int32_t count = 0;
-  while (it->Valid() && absl::StartsWith(it->key(), start_key)) {
+  for (; it->Valid(); it->Next()) {
     count++;
-    it->Next();
   }
 
   FSTPBTargetGlobal *targetGlobal =
@@ -24,7 +24,6 @@
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
 #import "Firestore/Source/Util/FSTAssert.h"
-#include "absl/strings/match.h"
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 
@@ -236,9 +235,8 @@ using leveldb::Status;
   // Note that this is a scan rather than a get because canonicalIDs are not required to be unique
   // per target.
   Slice canonicalID = StringView(query.canonicalID);
-  auto indexItererator = _db.currentTransaction->NewIterator();
   std::string indexPrefix = [FSTLevelDBQueryTargetKey keyPrefixWithCanonicalID:canonicalID];
-  indexItererator->Seek(indexPrefix);
+  auto indexItererator = _db.currentTransaction->Scan(indexPrefix);
 
   // Simultaneously scan the targets table. This works because each (canonicalID, targetID) pair is
   // unique and ordered, so when scanning a table prefixed by exactly one canonicalID, all the
@@ -249,8 +247,7 @@ using leveldb::Status;
   FSTLevelDBQueryTargetKey *rowKey = [[FSTLevelDBQueryTargetKey alloc] init];
   for (; indexItererator->Valid(); indexItererator->Next()) {
     // Only consider rows matching exactly the specific canonicalID of interest.
-    if (!absl::StartsWith(indexItererator->key(), indexPrefix) ||
-        ![rowKey decodeKey:indexItererator->key()] || canonicalID != rowKey.canonicalID) {
+    if (![rowKey decodeKey:indexItererator->key()] || canonicalID != rowKey.canonicalID) {
       // End of this canonicalID's possible targets.
       break;
     }
@@ -314,8 +311,7 @@ using leveldb::Status;
 
 - (void)removeMatchingKeysForTargetID:(FSTTargetID)targetID group:(FSTWriteGroup *)group {
   std::string indexPrefix = [FSTLevelDBTargetDocumentKey keyPrefixWithTargetID:targetID];
-  auto indexIterator = _db.currentTransaction->NewIterator();
-  indexIterator->Seek(indexPrefix);
+  auto indexIterator = _db.currentTransaction->Scan(indexPrefix);
 
   FSTLevelDBTargetDocumentKey *rowKey = [[FSTLevelDBTargetDocumentKey alloc] init];
   for (; indexIterator->Valid(); indexIterator->Next()) {
@@ -337,8 +333,7 @@ using leveldb::Status;
 
 - (FSTDocumentKeySet *)matchingKeysForTargetID:(FSTTargetID)targetID {
   std::string indexPrefix = [FSTLevelDBTargetDocumentKey keyPrefixWithTargetID:targetID];
-  auto indexIterator = _db.currentTransaction->NewIterator();
-  indexIterator->Seek(indexPrefix);
+  auto indexIterator = _db.currentTransaction->Scan(indexPrefix);
 
   FSTDocumentKeySet *result = [FSTDocumentKeySet keySet];
   FSTLevelDBTargetDocumentKey *rowKey = [[FSTLevelDBTargetDocumentKey alloc] init];
@@ -360,8 +355,7 @@ using leveldb::Status;
 
 - (BOOL)containsKey:(const DocumentKey &)key {
   std::string indexPrefix = [FSTLevelDBDocumentTargetKey keyPrefixWithResourcePath:key.path()];
-  auto indexIterator = _db.currentTransaction->NewIterator();
-  indexIterator->Seek(indexPrefix);
+  auto indexIterator = _db.currentTransaction->Scan(indexPrefix);
 
   if (indexIterator->Valid()) {
     FSTLevelDBDocumentTargetKey *rowKey = [[FSTLevelDBDocumentTargetKey alloc] init];
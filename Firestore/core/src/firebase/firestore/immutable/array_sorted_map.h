@@ -18,140 +18,29 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_ARRAY_SORTED_MAP_H_
 
 #include <algorithm>
-#include <array>
 #include <cassert>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/map_entry.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
 
 namespace firebase {
 namespace firestore {
 namespace immutable {
 
-namespace impl {
-
-/**
- * A base class for implementing ArraySortedMap, containing types and constants
- * that don't depend upon the template parameters to the main class.
- *
- * Note that this exists as a base class rather than as just a namespace in
- * order to make it possible for users of ArraySortedMap to avoid needing to
- * declare storage for each instantiation of the template.
- */
-class ArraySortedMapBase {
- public:
-  /**
-   * The type of size() methods on immutable collections. Note that this is not
-   * size_t specifically to save space in the TreeSortedMap implementation.
-   */
-  using size_type = uint32_t;
-
-  /**
-   * The maximum size of an ArraySortedMap.
-   *
-   * This is the size threshold where we use a tree backed sorted map instead of
-   * an array backed sorted map. This is a more or less arbitrary chosen value,
-   * that was chosen to be large enough to fit most of object kind of Firebase
-   * data, but small enough to not notice degradation in performance for
-   * inserting and lookups. Feel free to empirically determine this constant,
-   * but don't expect much gain in real world performance.
-   */
-  // TODO(wilhuff): actually use this for switching implementations.
-  static constexpr size_type kFixedSize = 25;
-};
-
-/**
- * A bounded-size array that allocates its contents directly in itself. This
- * saves a heap allocation when compared with std::vector (though std::vector
- * can resize itself while FixedArray cannot).
- *
- * Unlike std::array, FixedArray keeps track of its size and grows up to the
- * fixed_size limit. Inserting more elements than fixed_size will trigger an
- * assertion failure.
- *
- * ArraySortedMap does not actually contain its array: it contains a shared_ptr
- * to a FixedArray.
- *
- * @tparam T The type of an element in the array.
- * @tparam fixed_size the fixed size to use in creating the FixedArray.
- */
-template <typename T, ArraySortedMapBase::size_type fixed_size>
-class FixedArray {
- public:
-  using size_type = ArraySortedMapBase::size_type;
-  using array_type = std::array<T, fixed_size>;
-  using iterator = typename array_type::iterator;
-  using const_iterator = typename array_type::const_iterator;
-
-  FixedArray() {
-  }
-
-  template <typename SourceIterator>
-  FixedArray(SourceIterator src_begin, SourceIterator src_end) {
-    append(src_begin, src_end);
-  }
-
-  /**
-   * Appends to this array, copying from the given src_begin up to but not
-   * including the src_end.
-   */
-  template <typename SourceIterator>
-  void append(SourceIterator src_begin, SourceIterator src_end) {
-    size_type appending = static_cast<size_type>(src_end - src_begin);
-    size_type new_size = size_ + appending;
-    FIREBASE_ASSERT(new_size <= fixed_size);
-
-    std::copy(src_begin, src_end, end());
-    size_ = new_size;
-  }
-
-  /**
-   * Appends a single value to the array.
-   */
-  void append(T&& value) {
-    size_type new_size = size_ + 1;
-    FIREBASE_ASSERT(new_size <= fixed_size);
-
-    *end() = std::move(value);
-    size_ = new_size;
-  }
-
-  const_iterator begin() const {
-    return contents_.begin();
-  }
-
-  const_iterator end() const {
-    return begin() + size_;
-  }
-
-  size_type size() const {
-    return size_;
-  }
-
- private:
-  iterator begin() {
-    return contents_.begin();
-  }
-
-  iterator end() {
-    return begin() + size_;
-  }
-
-  array_type contents_;
-  size_type size_ = 0;
-};
-
-}  // namespace impl
-
 /**
  * ArraySortedMap is a value type containing a map. It is immutable, but has
  * methods to efficiently create new maps that are mutations of it.
  */
 template <typename K, typename V, typename C = std::less<K>>
-class ArraySortedMap : public impl::ArraySortedMapBase {
+class ArraySortedMap : public impl::SortedMapBase {
  public:
   using key_comparator_type = KeyComparator<K, V, C>;
 
@@ -161,13 +50,18 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
   using value_type = std::pair<K, V>;
 
   /**
-   * The type of the fixed-size array containing entries of value_type.
+   * The type of the array containing entries of value_type. Each map's array
+   * is allocated to hold just its own entries, of which there are at most
+   * kFixedSize, so that small maps stay small.
    */
-  using array_type = impl::FixedArray<value_type, kFixedSize>;
+  using array_type = std::vector<value_type, util::ArenaAllocator<value_type>>;
   using const_iterator = typename array_type::const_iterator;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
   using array_pointer = std::shared_ptr<const array_type>;
 
+  class Builder;
+
   /**
    * Creates an empty ArraySortedMap.
    */
@@ -182,6 +76,43 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
                  const C& comparator = C())
       : array_(std::make_shared<array_type>(entries.begin(), entries.end())),
         key_comparator_(comparator) {
+    FIREBASE_ASSERT(entries.size() <= kFixedSize);
+  }
+
+  /**
+   * Creates an ArraySortedMap containing the entries in the range
+   * [begin, end), which must be sorted by key with no duplicates, in O(n)
+   * time. There must be no more than kFixedSize entries.
+   */
+  template <typename SourceIterator>
+  static ArraySortedMap FromSorted(SourceIterator begin,
+                                   SourceIterator end,
+                                   const C& comparator = C()) {
+    return FromSorted(begin, end, comparator,
+                      util::ArenaAllocator<value_type>{});
+  }
+
+  /**
+   * As above, but allocates the array (along with its reference count and
+   * entries) with the given allocator, e.g. in an Arena. Maps derived from the
+   * result allocate on the heap.
+   */
+  template <typename SourceIterator>
+  static ArraySortedMap FromSorted(
+      SourceIterator begin,
+      SourceIterator end,
+      const C& comparator,
+      const util::ArenaAllocator<value_type>& allocator) {
+    array_pointer array =
+        std::allocate_shared<array_type>(allocator, begin, end, allocator);
+    FIREBASE_ASSERT(array->size() <= kFixedSize);
+    key_comparator_type key_comparator{comparator};
+    FIREBASE_DEV_ASSERT(std::adjacent_find(array->begin(), array->end(),
+                                           [&](const value_type& lhs,
+                                               const value_type& rhs) {
+                                             return !key_comparator(lhs, rhs);
+                                           }) == array->end());
+    return ArraySortedMap{array, key_comparator};
   }
 
   /**
@@ -206,18 +137,22 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
       }
     }
 
+    size_type new_size = replacing_entry ? size() : size() + 1;
+    FIREBASE_ASSERT(new_size <= kFixedSize);
+    auto copy = NewArray(new_size);
+
     // Copy the segment before the found position. If not found, this is
     // everything.
-    auto copy = std::make_shared<array_type>(begin(), pos);
+    copy->insert(copy->end(), begin(), pos);
 
     // Copy the value to be inserted.
-    copy->append(value_type(key, value));
+    copy->emplace_back(key, value);
 
     if (replacing_entry) {
       // Skip the thing at pos because it compares the same as the pair above.
-      copy->append(pos + 1, current_end);
+      copy->insert(copy->end(), pos + 1, current_end);
     } else {
-      copy->append(pos, current_end);
+      copy->insert(copy->end(), pos, current_end);
     }
     return wrap(copy);
   }
@@ -238,12 +173,38 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
       // the result empty.
       return wrap(EmptyArray());
     } else {
-      auto copy = std::make_shared<array_type>(begin(), pos);
-      copy->append(pos + 1, current_end);
+      auto copy = NewArray(size() - 1);
+      copy->insert(copy->end(), begin(), pos);
+      copy->insert(copy->end(), pos + 1, current_end);
       return wrap(copy);
     }
   }
 
+  /**
+   * Creates a new map containing the entries of both this map and the given
+   * one, which must use the same comparator, in O(n + m) time. Where both
+   * maps have an entry with the same key, the one from the other map wins.
+   * The result must fit in kFixedSize entries.
+   */
+  ArraySortedMap merge(const ArraySortedMap& other) const {
+    if (other.empty()) {
+      return *this;
+    } else if (empty()) {
+      return other;
+    }
+
+    // Reserve for the case where the maps share no keys.
+    auto merged = NewArray(size() + other.size());
+    bool changed = impl::MergeEntries(
+        begin(), end(), other.begin(), other.end(), comparator(),
+        [&merged](const value_type& entry) { merged->push_back(entry); });
+    FIREBASE_ASSERT(merged->size() <= kFixedSize);
+    if (!changed) {
+      return *this;
+    }
+    return wrap(merged);
+  }
+
   /**
    * Finds a value in the map.
    *
@@ -261,7 +222,34 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
     }
   }
 
-  // TODO(wilhuff): indexof
+  /**
+   * Returns the index of the entry with the given key in the map, in key
+   * order, or npos if the map doesn't contain the key.
+   */
+  size_type find_index(const K& key) const {
+    const_iterator found = find(key);
+    if (found == end()) {
+      return npos;
+    }
+    return static_cast<size_type>(found - begin());
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry whose key is not less
+   * than the given key, or end() if there is none. Iterating from there
+   * visits the entries from the key onward.
+   */
+  const_iterator lower_bound(const K& key) const {
+    return LowerBound(key);
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry whose key is greater than
+   * the given key, or end() if there is none.
+   */
+  const_iterator upper_bound(const K& key) const {
+    return std::upper_bound(begin(), end(), key, key_comparator_);
+  }
 
   /** Returns true if the map contains no elements. */
   bool empty() const {
@@ -288,6 +276,45 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
     return array_->end();
   }
 
+  /**
+   * Returns an iterator pointing to the last entry in the map, for iterating
+   * in reverse order. If there are no entries, rbegin() == rend().
+   */
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator{end()};
+  }
+
+  /**
+   * Returns an iterator pointing before the first entry in the map.
+   */
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator{begin()};
+  }
+
+  /** Returns the comparator used to order the keys of this map. */
+  const C& comparator() const {
+    return key_comparator_.comparator();
+  }
+
+  /**
+   * Returns an estimate of the memory retained by this map: the map itself
+   * and its array of entries, which it may share with other maps. Any heap
+   * memory owned by the keys and values themselves is not included.
+   *
+   * @param counted If not null, the array is only counted if it isn't already
+   *     in this set, and is then added to it. Passing the same set for several
+   *     maps counts arrays they share only once.
+   */
+  size_t MemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    size_t result = sizeof(*this);
+    // The shared empty array isn't retained by any one map.
+    if (array_ != EmptyArray() && util::CountOnce(array_.get(), counted)) {
+      result += sizeof(array_type) + util::kSharedControlBlockSize +
+                array_->capacity() * sizeof(value_type);
+    }
+    return result;
+  }
+
  private:
   static array_pointer EmptyArray() {
     static const array_pointer kEmptyArray =
@@ -295,6 +322,13 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
     return kEmptyArray;
   }
 
+  /** Returns a new, empty array with room for the given number of entries. */
+  static std::shared_ptr<array_type> NewArray(size_type capacity) {
+    auto array = std::make_shared<array_type>();
+    array->reserve(capacity);
+    return array;
+  }
+
   ArraySortedMap(const array_pointer& array,
                  const key_comparator_type& key_comparator) noexcept
       : array_(array), key_comparator_(key_comparator) {
@@ -312,6 +346,140 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
   key_comparator_type key_comparator_;
 };
 
+/**
+ * A mutable ArraySortedMap under construction, for making many changes to a
+ * map at once. Updating an ArraySortedMap allocates a new array for each
+ * change; a Builder copies the array once, on its first change, and then
+ * updates its copy in place.
+ *
+ * Build() returns the result as an ArraySortedMap, which shares the array
+ * with the Builder. The Builder can be used again after that, but copies the
+ * array again on its next change so that the map is unaffected.
+ */
+template <typename K, typename V, typename C>
+class ArraySortedMap<K, V, C>::Builder {
+ public:
+  /** Creates a Builder for an empty map. */
+  explicit Builder(const C& comparator = C())
+      : Builder{ArraySortedMap{comparator}} {
+  }
+
+  /** Creates a Builder that starts out with the entries of the given map. */
+  explicit Builder(const ArraySortedMap& map)
+      : array_(map.array_), key_comparator_(map.key_comparator_) {
+  }
+
+  /**
+   * Adds a key-value pair to the map or updates the value of an existing key.
+   * There must be no more than kFixedSize entries in the map.
+   */
+  Builder& insert(const K& key, const V& value) {
+    const_iterator pos = LowerBound(key);
+    if (pos != end() && !key_comparator_(key, *pos)) {
+      if (!(value == pos->second)) {
+        MutableArray(&pos, size())->second = value;
+      }
+    } else {
+      FIREBASE_ASSERT(size() < kFixedSize);
+      MutableArray(&pos, size() + 1);
+      owned_->emplace(pos, key, value);
+    }
+    return *this;
+  }
+
+  /** Removes a key from the map, if it's there. */
+  Builder& erase(const K& key) {
+    const_iterator pos = find(key);
+    if (pos != end()) {
+      MutableArray(&pos, size());
+      owned_->erase(pos);
+    }
+    return *this;
+  }
+
+  /**
+   * Finds a value in the map. Any change to the Builder invalidates the
+   * result.
+   */
+  const_iterator find(const K& key) const {
+    const_iterator lower_bound = LowerBound(key);
+    if (lower_bound != end() && !key_comparator_(key, *lower_bound)) {
+      return lower_bound;
+    } else {
+      return end();
+    }
+  }
+
+  /** Returns true if the map contains no elements. */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /** Returns the number of items in the map. */
+  size_type size() const {
+    return array_->size();
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the map. Any change to
+   * the Builder invalidates it.
+   */
+  const_iterator begin() const {
+    return array_->begin();
+  }
+
+  /** Returns an iterator pointing past the last entry in the map. */
+  const_iterator end() const {
+    return array_->end();
+  }
+
+  /** Returns the comparator used to order the keys of the map. */
+  const C& comparator() const {
+    return key_comparator_.comparator();
+  }
+
+  /**
+   * Returns the map built so far, without copying its entries unless the
+   * array has room to spare.
+   */
+  ArraySortedMap Build() {
+    if (owned_ && owned_->capacity() != owned_->size()) {
+      owned_->shrink_to_fit();
+    }
+    owned_.reset();
+    return ArraySortedMap{array_, key_comparator_};
+  }
+
+ private:
+  /**
+   * Makes sure the Builder owns its array, so that it can be updated in place,
+   * by copying it into one with room for the given number of entries if need
+   * be. Updates *pos to point at the same entry in the array owned, and
+   * returns a mutable iterator to that entry.
+   */
+  typename array_type::iterator MutableArray(const_iterator* pos,
+                                             size_type capacity) {
+    auto offset = *pos - array_->begin();
+    if (!owned_) {
+      owned_ = NewArray(capacity);
+      owned_->insert(owned_->end(), array_->begin(), array_->end());
+      array_ = owned_;
+      *pos = array_->begin() + offset;
+    }
+    return owned_->begin() + offset;
+  }
+
+  const_iterator LowerBound(const K& key) const {
+    return std::lower_bound(begin(), end(), key, key_comparator_);
+  }
+
+  // The entries of the map. If owned_ is set it points to the same array,
+  // which no ArraySortedMap shares, so it can be changed in place.
+  array_pointer array_;
+  std::shared_ptr<array_type> owned_;
+  key_comparator_type key_comparator_;
+};
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
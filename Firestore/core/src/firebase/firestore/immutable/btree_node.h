@@ -0,0 +1,552 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/fixed_array.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A node in a B-tree. Each node holds between kMinEntries and kMaxEntries
+ * entries in a single array (only the root may have fewer), and an internal
+ * node has one more child than it has entries. All leaves are at the same
+ * depth.
+ *
+ * Like LlrbNode, BTreeNode is an immutable value type that refers to its
+ * contents through a shared_ptr, and operations that change the tree return a
+ * new root that shares all the nodes it didn't change with the original. Since
+ * each node holds many entries, a tree is far shallower than a binary one:
+ * a search or update visits a handful of contiguous arrays instead of
+ * following a pointer per comparison, and an update copies a handful of nodes.
+ *
+ * The comparator is passed to the operations that need it rather than stored
+ * in every node; it must be the same for all operations on the same tree.
+ */
+template <typename K, typename V>
+class BTreeNode : public SortedMapBase {
+ public:
+  using first_type = K;
+  using second_type = V;
+
+  /**
+   * The type of the entries stored in the tree.
+   */
+  using value_type = std::pair<K, V>;
+
+  static constexpr size_type kMinEntries = 16;
+  static constexpr size_type kMaxEntries = kMinEntries * 2;
+
+  using entries_type = FixedArray<value_type, kMaxEntries>;
+
+  /**
+   * Constructs an empty node.
+   */
+  BTreeNode() = default;
+
+  /** Returns the number of entries in this node and its subtrees. */
+  size_type size() const {
+    return rep_ ? rep_->size_ : 0;
+  }
+
+  /** Returns true if this is an empty node: an empty tree. */
+  bool empty() const {
+    return rep_ == nullptr;
+  }
+
+  /** Returns true if this node has no children. */
+  bool leaf() const {
+    return rep_ == nullptr || rep_->children_.empty();
+  }
+
+  /** Returns the entries in this node, which must not be empty. */
+  const entries_type& entries() const {
+    return rep_->entries_;
+  }
+
+  /**
+   * Returns the child containing the entries between entries()[index - 1]
+   * and entries()[index]. This node must not be a leaf.
+   */
+  const BTreeNode& child(size_type index) const {
+    return rep_->children_[index];
+  }
+
+  /**
+   * Returns the index of the first entry in this node whose key is not less
+   * than the given key, or entries().size() if there is none.
+   */
+  template <typename C>
+  size_type LowerBound(const K& key, const C& comparator) const {
+    auto found = std::lower_bound(
+        entries().begin(), entries().end(), key,
+        [&comparator](const value_type& entry, const K& key) {
+          return comparator(entry.first, key);
+        });
+    return static_cast<size_type>(found - entries().begin());
+  }
+
+  /**
+   * Returns the index of the first entry in this node whose key is greater
+   * than the given key, or entries().size() if there is none.
+   */
+  template <typename C>
+  size_type UpperBound(const K& key, const C& comparator) const {
+    auto found = std::upper_bound(
+        entries().begin(), entries().end(), key,
+        [&comparator](const K& key, const value_type& entry) {
+          return comparator(key, entry.first);
+        });
+    return static_cast<size_type>(found - entries().begin());
+  }
+
+  /**
+   * Returns the index of the entry with the given key among all the entries
+   * in this tree, in key order, or npos if there is none.
+   */
+  template <typename C>
+  size_type FindIndex(const K& key, const C& comparator) const {
+    size_type index = 0;
+    const BTreeNode* node = this;
+    while (!node->empty()) {
+      size_type pos = node->LowerBound(key, comparator);
+      // Count the entries to the left of pos, in this node and its children.
+      index += pos;
+      if (!node->leaf()) {
+        for (size_type i = 0; i < pos; i++) {
+          index += node->child(i).size();
+        }
+      }
+      if (pos < node->entries().size() &&
+          !comparator(key, node->entries()[pos].first)) {
+        return node->leaf() ? index : index + node->child(pos).size();
+      }
+      if (node->leaf()) {
+        break;
+      }
+      node = &node->child(pos);
+    }
+    return npos;
+  }
+
+  /**
+   * Returns a tree with the given key-value pair added or updated. If the
+   * tree already has the pair, returns this tree itself.
+   */
+  template <typename C>
+  BTreeNode insert(const K& key, const V& value, const C& comparator) const {
+    if (empty()) {
+      Builder leaf;
+      leaf.entries_.append(value_type{key, value});
+      return leaf.Build();
+    }
+
+    Split split;
+    BTreeNode result = InnerInsert(key, value, comparator, &split);
+    if (result.empty()) {
+      return *this;
+    } else if (!split.right.empty()) {
+      // The root was split: add a level above it.
+      Builder root;
+      root.entries_.append(std::move(split.median));
+      root.children_.push_back(std::move(result));
+      root.children_.push_back(std::move(split.right));
+      return root.Build();
+    } else {
+      return result;
+    }
+  }
+
+  /**
+   * Returns a tree with the given key removed. If the tree doesn't contain the
+   * key, returns this tree itself.
+   */
+  template <typename C>
+  BTreeNode erase(const K& key, const C& comparator) const {
+    if (empty()) {
+      return *this;
+    }
+
+    BTreeNode result = InnerErase(key, comparator);
+    if (result.empty()) {
+      return *this;
+    } else if (result.entries().size() == 0) {
+      // The root ran out of entries: remove a level, or the last leaf.
+      return result.leaf() ? BTreeNode{} : result.child(0);
+    } else {
+      return result;
+    }
+  }
+
+  /**
+   * Builds a tree from the given number of entries starting at begin, which
+   * must be sorted by key with no duplicates, in O(n) time.
+   *
+   * The tree has the smallest height that can hold the entries, and at each
+   * level the entries are spread evenly among as few nodes as possible.
+   */
+  template <typename Iter>
+  static BTreeNode FromSorted(Iter begin, size_type size) {
+    if (size == 0) {
+      return BTreeNode{};
+    }
+    int height = 1;
+    while (Capacity(height) < size) {
+      height++;
+    }
+    return BuildFromSorted(&begin, size, height);
+  }
+
+  /**
+   * Returns an estimate of the heap memory retained by this tree: all its
+   * nodes, which it may share with other trees.
+   *
+   * @param counted If not null, nodes are only counted if they aren't already
+   *     in this set, and are then added to it.
+   */
+  size_t HeapMemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    if (empty() || !util::CountOnce(rep_.get(), counted)) {
+      return 0;
+    }
+    size_t result = sizeof(Rep) + util::kSharedControlBlockSize +
+                    rep_->children_.capacity() * sizeof(BTreeNode);
+    for (const BTreeNode& child : rep_->children_) {
+      result += child.HeapMemoryUsage(counted);
+    }
+    return result;
+  }
+
+ private:
+  struct Rep {
+    entries_type entries_;
+    std::vector<BTreeNode> children_;
+    size_type size_ = 0;
+  };
+
+  /**
+   * A node under construction, which can be changed in place until Build()
+   * shares it.
+   */
+  struct Builder : public Rep {
+    Builder() = default;
+
+    explicit Builder(const BTreeNode& node) : Rep(*node.rep_) {
+    }
+
+    BTreeNode Build() {
+      size_type size = this->entries_.size();
+      for (const BTreeNode& child : this->children_) {
+        size += child.size();
+      }
+      this->size_ = size;
+      return BTreeNode{std::make_shared<const Rep>(std::move(*this))};
+    }
+
+    typename entries_type::const_iterator entry(size_type index) const {
+      return this->entries_.begin() + index;
+    }
+
+    /**
+     * Fixes the child at the given index if it has fewer than kMinEntries
+     * entries, by moving an entry over from a sibling that has more than
+     * enough, or else by merging it with a sibling.
+     */
+    void Rebalance(size_type index) {
+      std::vector<BTreeNode>& children = this->children_;
+      if (children[index].entries().size() >= kMinEntries) {
+        return;
+      }
+
+      if (index > 0 &&
+          children[index - 1].entries().size() > kMinEntries) {
+        // Rotate the last entry of the left sibling through this node.
+        Builder left{children[index - 1]};
+        Builder right{children[index]};
+        size_type last = left.entries_.size() - 1;
+        right.entries_.insert(right.entry(0), *entry(index - 1));
+        this->entries_.replace(entry(index - 1), *left.entry(last));
+        left.entries_.erase(left.entry(last));
+        if (!left.children_.empty()) {
+          right.children_.insert(right.children_.begin(),
+                                 std::move(left.children_.back()));
+          left.children_.pop_back();
+        }
+        children[index - 1] = left.Build();
+        children[index] = right.Build();
+
+      } else if (index + 1 < children.size() &&
+                 children[index + 1].entries().size() > kMinEntries) {
+        // Rotate the first entry of the right sibling through this node.
+        Builder left{children[index]};
+        Builder right{children[index + 1]};
+        left.entries_.append(*entry(index));
+        this->entries_.replace(entry(index), *right.entry(0));
+        right.entries_.erase(right.entry(0));
+        if (!right.children_.empty()) {
+          left.children_.push_back(std::move(right.children_.front()));
+          right.children_.erase(right.children_.begin());
+        }
+        children[index] = left.Build();
+        children[index + 1] = right.Build();
+
+      } else {
+        // Neither sibling can spare an entry, so together with the separator
+        // they fit in one node.
+        size_type first = index > 0 ? index - 1 : index;
+        Builder merged{children[first]};
+        const BTreeNode& right = children[first + 1];
+        merged.entries_.append(*entry(first));
+        merged.entries_.append(right.entries().begin(), right.entries().end());
+        merged.children_.insert(merged.children_.end(),
+                                right.rep_->children_.begin(),
+                                right.rep_->children_.end());
+        children[first] = merged.Build();
+        children.erase(children.begin() + first + 1);
+        this->entries_.erase(entry(first));
+      }
+    }
+  };
+
+  /**
+   * Where an insertion split a node in two: the entry between the halves and
+   * the right half. The right half is empty if the node wasn't split.
+   */
+  struct Split {
+    value_type median;
+    BTreeNode right;
+  };
+
+  explicit BTreeNode(std::shared_ptr<const Rep>&& rep) : rep_{std::move(rep)} {
+  }
+
+  /**
+   * Inserts into the subtree below this node, which must not be empty.
+   *
+   * @return The node that replaces this one, or an empty node if the subtree
+   *     already has the pair. If the node overflowed, the result is the left
+   *     half of it and the rest is in *split.
+   */
+  template <typename C>
+  BTreeNode InnerInsert(const K& key,
+                        const V& value,
+                        const C& comparator,
+                        Split* split) const {
+    size_type pos = LowerBound(key, comparator);
+    if (pos < entries().size() && !comparator(key, entries()[pos].first)) {
+      if (value == entries()[pos].second) {
+        return BTreeNode{};
+      }
+      Builder result{*this};
+      result.entries_.replace(result.entry(pos), value_type{key, value});
+      return result.Build();
+    }
+
+    if (leaf()) {
+      return InsertAt(pos, value_type{key, value}, BTreeNode{}, BTreeNode{},
+                      split);
+    }
+
+    Split child_split;
+    BTreeNode new_child =
+        child(pos).InnerInsert(key, value, comparator, &child_split);
+    if (new_child.empty()) {
+      return BTreeNode{};
+    } else if (child_split.right.empty()) {
+      Builder result{*this};
+      result.children_[pos] = std::move(new_child);
+      return result.Build();
+    } else {
+      return InsertAt(pos, std::move(child_split.median), std::move(new_child),
+                      std::move(child_split.right), split);
+    }
+  }
+
+  /**
+   * Returns a copy of this node with the given entry inserted at pos. In an
+   * internal node, the child at pos is replaced by the given left and right
+   * children, which were split around the entry.
+   */
+  BTreeNode InsertAt(size_type pos,
+                     value_type&& entry,
+                     BTreeNode&& left,
+                     BTreeNode&& right,
+                     Split* split) const {
+    if (entries().size() < kMaxEntries) {
+      Builder result{*this};
+      result.entries_.insert(result.entry(pos), entry);
+      if (!leaf()) {
+        result.children_[pos] = std::move(left);
+        result.children_.insert(result.children_.begin() + pos + 1,
+                                std::move(right));
+      }
+      return result.Build();
+    }
+
+    // The node is full: split it into two halves of kMinEntries entries, and
+    // pass the entry between them up to the parent.
+    std::vector<value_type> all_entries(entries().begin(), entries().end());
+    all_entries.insert(all_entries.begin() + pos, std::move(entry));
+    std::vector<BTreeNode> all_children;
+    if (!leaf()) {
+      all_children = rep_->children_;
+      all_children[pos] = std::move(left);
+      all_children.insert(all_children.begin() + pos + 1, std::move(right));
+    }
+
+    Builder left_half;
+    Builder right_half;
+    left_half.entries_.append(all_entries.begin(),
+                              all_entries.begin() + kMinEntries);
+    right_half.entries_.append(all_entries.begin() + kMinEntries + 1,
+                               all_entries.end());
+    if (!all_children.empty()) {
+      auto middle = all_children.begin() + kMinEntries + 1;
+      left_half.children_.assign(all_children.begin(), middle);
+      right_half.children_.assign(middle, all_children.end());
+    }
+    split->median = std::move(all_entries[kMinEntries]);
+    split->right = right_half.Build();
+    return left_half.Build();
+  }
+
+  /**
+   * Erases from the subtree below this node, which must not be empty.
+   *
+   * @return The node that replaces this one, which may have fewer than
+   *     kMinEntries entries, or an empty node if the subtree doesn't contain
+   *     the key.
+   */
+  template <typename C>
+  BTreeNode InnerErase(const K& key, const C& comparator) const {
+    size_type pos = LowerBound(key, comparator);
+    bool found =
+        pos < entries().size() && !comparator(key, entries()[pos].first);
+
+    if (leaf()) {
+      if (!found) {
+        return BTreeNode{};
+      }
+      Builder result{*this};
+      result.entries_.erase(result.entry(pos));
+      return result.Build();
+    }
+
+    BTreeNode new_child;
+    value_type predecessor;
+    if (found) {
+      // Replace the entry with the largest one to the left of it.
+      new_child = child(pos).EraseMax(&predecessor);
+    } else {
+      new_child = child(pos).InnerErase(key, comparator);
+      if (new_child.empty()) {
+        return BTreeNode{};
+      }
+    }
+
+    Builder result{*this};
+    result.children_[pos] = std::move(new_child);
+    if (found) {
+      result.entries_.replace(result.entry(pos), predecessor);
+    }
+    result.Rebalance(pos);
+    return result.Build();
+  }
+
+  /**
+   * Removes the largest entry from the subtree below this node, which must
+   * not be empty, and stores it in *max.
+   */
+  BTreeNode EraseMax(value_type* max) const {
+    Builder result{*this};
+    if (leaf()) {
+      size_type last = entries().size() - 1;
+      *max = entries()[last];
+      result.entries_.erase(result.entry(last));
+    } else {
+      size_type last = static_cast<size_type>(rep_->children_.size()) - 1;
+      result.children_[last] = child(last).EraseMax(max);
+      result.Rebalance(last);
+    }
+    return result.Build();
+  }
+
+  /** Returns the number of entries a tree of the given height can hold. */
+  static uint64_t Capacity(int height) {
+    uint64_t result = kMaxEntries;
+    for (int i = 1; i < height; i++) {
+      result = kMaxEntries + (kMaxEntries + 1) * result;
+    }
+    return result;
+  }
+
+  template <typename Iter>
+  static BTreeNode BuildFromSorted(Iter* iter, size_type size, int height) {
+    Builder result;
+    if (height == 1) {
+      for (size_type i = 0; i < size; i++, ++*iter) {
+        result.entries_.append(**iter);
+      }
+      return result.Build();
+    }
+
+    // Use as few children as can hold the entries, and split the entries
+    // between the separators evenly among them.
+    uint64_t child_capacity = Capacity(height - 1);
+    auto children = static_cast<size_type>((size + child_capacity + 1) /
+                                           (child_capacity + 1));
+    size_type child_entries = size - (children - 1);
+    for (size_type i = 0; i < children; i++) {
+      size_type child_size =
+          child_entries / children + (i < child_entries % children ? 1 : 0);
+      result.children_.push_back(BuildFromSorted(iter, child_size, height - 1));
+      if (i + 1 < children) {
+        result.entries_.append(**iter);
+        ++*iter;
+      }
+    }
+    return result.Build();
+  }
+
+  std::shared_ptr<const Rep> rep_;
+};
+
+template <typename K, typename V>
+constexpr SortedMapBase::size_type BTreeNode<K, V>::kMinEntries;
+
+template <typename K, typename V>
+constexpr SortedMapBase::size_type BTreeNode<K, V>::kMaxEntries;
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+
+#include <stddef.h>
+
+#include <array>
+#include <iterator>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A forward iterator over the entries of a BTreeNode tree, in order, or in
+ * reverse order if Reverse is true.
+ *
+ * The iterator keeps the path from the root to the current entry: for each
+ * node on it, the index of the child that the path goes through, which is also
+ * the index of the entry to visit in that node once the child is done. The
+ * last element is the current entry. (In reverse, the entry to visit after
+ * child i is entry i - 1.) Since B-trees are shallow, the path is stored in
+ * the iterator itself, so creating and copying iterators doesn't allocate.
+ *
+ * The path points into the tree, so an iterator is only valid while the tree
+ * (or the map holding its root) it came from is.
+ *
+ * @tparam N The type of the nodes: an instantiation of BTreeNode.
+ * @tparam Reverse Whether to iterate in descending order.
+ */
+template <typename N, bool Reverse = false>
+class BTreeNodeIterator {
+ public:
+  using node_type = N;
+  using key_type = typename N::first_type;
+  using size_type = typename N::size_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename N::value_type;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  /** Constructs an end iterator. */
+  BTreeNodeIterator() = default;
+
+  /** Returns an iterator pointing to the first entry in the given tree. */
+  static BTreeNodeIterator Begin(const node_type* root) {
+    BTreeNodeIterator result;
+    if (!root->empty()) {
+      result.PushSpine(root);
+    }
+    return result;
+  }
+
+  /** Returns an iterator pointing past the last entry of any tree. */
+  static BTreeNodeIterator End() {
+    return BTreeNodeIterator{};
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the given tree whose
+   * key is not less than the given key, or End() if there is none.
+   *
+   * @param comparator A less-than comparator on keys.
+   */
+  template <typename C>
+  static BTreeNodeIterator LowerBound(const node_type* root,
+                                      const key_type& key,
+                                      const C& comparator) {
+    static_assert(!Reverse, "LowerBound is only for forward iterators");
+    BTreeNodeIterator result;
+    if (root->empty()) {
+      return result;
+    }
+    const node_type* node = root;
+    while (true) {
+      size_type index = node->LowerBound(key, comparator);
+      result.Push(node, index);
+      if (node->leaf() || (index < node->entries().size() &&
+                           !comparator(key, node->entries()[index].first))) {
+        break;
+      }
+      node = &node->child(index);
+    }
+    result.PopFinished();
+    return result;
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the given tree whose
+   * key is greater than the given key, or End() if there is none.
+   *
+   * @param comparator A less-than comparator on keys.
+   */
+  template <typename C>
+  static BTreeNodeIterator UpperBound(const node_type* root,
+                                      const key_type& key,
+                                      const C& comparator) {
+    static_assert(!Reverse, "UpperBound is only for forward iterators");
+    BTreeNodeIterator result;
+    if (root->empty()) {
+      return result;
+    }
+    const node_type* node = root;
+    while (true) {
+      size_type index = node->UpperBound(key, comparator);
+      result.Push(node, index);
+      if (node->leaf()) {
+        break;
+      }
+      node = &node->child(index);
+    }
+    result.PopFinished();
+    return result;
+  }
+
+  reference operator*() const {
+    return current();
+  }
+
+  pointer operator->() const {
+    return &current();
+  }
+
+  BTreeNodeIterator& operator++() {
+    FIREBASE_ASSERT_MESSAGE(depth_ > 0, "Can't advance past the end");
+    Frame& top = path_[depth_ - 1];
+    if (Reverse) {
+      top.index--;
+    } else {
+      top.index++;
+    }
+    if (!top.node->leaf()) {
+      PushSpine(&top.node->child(top.index));
+    }
+    PopFinished();
+    return *this;
+  }
+
+  BTreeNodeIterator operator++(int) {
+    BTreeNodeIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const BTreeNodeIterator& lhs,
+                         const BTreeNodeIterator& rhs) {
+    if (lhs.depth_ == 0 || rhs.depth_ == 0) {
+      return lhs.depth_ == rhs.depth_;
+    }
+    const Frame& left = lhs.path_[lhs.depth_ - 1];
+    const Frame& right = rhs.path_[rhs.depth_ - 1];
+    return left.node == right.node && left.index == right.index;
+  }
+
+  friend bool operator!=(const BTreeNodeIterator& lhs,
+                         const BTreeNodeIterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  struct Frame {
+    const node_type* node;
+    size_type index;
+  };
+
+  // Nodes have at least kMinEntries + 1 children below the root, so this is
+  // enough for any tree that a size_type can count.
+  static constexpr size_t kMaxDepth = 16;
+
+  reference current() const {
+    FIREBASE_ASSERT_MESSAGE(depth_ > 0, "Can't dereference the end");
+    const Frame& top = path_[depth_ - 1];
+    return top.node->entries()[Reverse ? top.index - 1 : top.index];
+  }
+
+  void Push(const node_type* node, size_type index) {
+    FIREBASE_ASSERT_MESSAGE(depth_ < kMaxDepth, "Tree is too deep");
+    path_[depth_++] = Frame{node, index};
+  }
+
+  /**
+   * Pushes the path from the given node to the first entry below it: its
+   * leftmost entry, or its rightmost one in reverse.
+   */
+  void PushSpine(const node_type* node) {
+    while (true) {
+      size_type index = Reverse ? node->entries().size() : 0;
+      Push(node, index);
+      if (node->leaf()) {
+        break;
+      }
+      node = &node->child(index);
+    }
+  }
+
+  /** Pops the nodes whose entries have all been visited. */
+  void PopFinished() {
+    for (; depth_ > 0; depth_--) {
+      const Frame& top = path_[depth_ - 1];
+      if (Reverse ? top.index > 0 : top.index < top.node->entries().size()) {
+        break;
+      }
+    }
+  }
+
+  std::array<Frame, kMaxDepth> path_{};
+  size_t depth_ = 0;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_FIXED_ARRAY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_FIXED_ARRAY_H_
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A bounded-size array that allocates its contents directly in itself. This
+ * saves a heap allocation when compared with std::vector (though std::vector
+ * can resize itself while FixedArray cannot).
+ *
+ * Unlike std::array, FixedArray keeps track of its size and grows up to the
+ * fixed_size limit. Inserting more elements than fixed_size will trigger an
+ * assertion failure. Only the elements in use are constructed, so an array
+ * that isn't full doesn't pay for default-constructing (or copying) the rest.
+ *
+ * ArraySortedMap does not actually contain its array: it contains a shared_ptr
+ * to a FixedArray. Each node of a BTreeSortedMap holds its entries in one.
+ *
+ * @tparam T The type of an element in the array.
+ * @tparam fixed_size the fixed size to use in creating the FixedArray.
+ */
+template <typename T, SortedMapBase::size_type fixed_size>
+class FixedArray {
+ public:
+  using size_type = SortedMapBase::size_type;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  FixedArray() {
+  }
+
+  template <typename SourceIterator>
+  FixedArray(SourceIterator src_begin, SourceIterator src_end) {
+    append(src_begin, src_end);
+  }
+
+  FixedArray(const FixedArray& other) {
+    append(other.begin(), other.end());
+  }
+
+  FixedArray(FixedArray&& other) {
+    for (T& value : other) {
+      append(std::move(value));
+    }
+  }
+
+  FixedArray& operator=(const FixedArray& other) {
+    if (this != &other) {
+      clear();
+      append(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  FixedArray& operator=(FixedArray&& other) {
+    if (this != &other) {
+      clear();
+      for (T& value : other) {
+        append(std::move(value));
+      }
+    }
+    return *this;
+  }
+
+  ~FixedArray() {
+    clear();
+  }
+
+  /**
+   * Appends to this array, copying from the given src_begin up to but not
+   * including the src_end.
+   */
+  template <typename SourceIterator>
+  void append(SourceIterator src_begin, SourceIterator src_end) {
+    size_type appending =
+        static_cast<size_type>(std::distance(src_begin, src_end));
+    size_type new_size = size_ + appending;
+    FIREBASE_ASSERT(new_size <= fixed_size);
+
+    std::uninitialized_copy(src_begin, src_end, end());
+    size_ = new_size;
+  }
+
+  /**
+   * Appends a single value to the array.
+   */
+  void append(const T& value) {
+    size_type new_size = size_ + 1;
+    FIREBASE_ASSERT(new_size <= fixed_size);
+
+    new (end()) T(value);
+    size_ = new_size;
+  }
+
+  /**
+   * Appends a single value to the array.
+   */
+  void append(T&& value) {
+    size_type new_size = size_ + 1;
+    FIREBASE_ASSERT(new_size <= fixed_size);
+
+    new (end()) T(std::move(value));
+    size_ = new_size;
+  }
+
+  /**
+   * Inserts a single value before the given position, moving the values after
+   * it up by one.
+   */
+  void insert(const_iterator pos, const T& value) {
+    FIREBASE_ASSERT(size_ < fixed_size);
+
+    iterator dest = mutable_iterator(pos);
+    if (dest == end()) {
+      append(value);
+      return;
+    }
+    iterator last = end() - 1;
+    new (end()) T(std::move(*last));
+    std::move_backward(dest, last, end());
+    *dest = value;
+    size_ += 1;
+  }
+
+  /**
+   * Replaces the value at the given position.
+   */
+  void replace(const_iterator pos, const T& value) {
+    *mutable_iterator(pos) = value;
+  }
+
+  /**
+   * Removes the value at the given position, moving the values after it down
+   * by one.
+   */
+  void erase(const_iterator pos) {
+    iterator dest = mutable_iterator(pos);
+    std::move(dest + 1, end(), dest);
+    size_ -= 1;
+    end()->~T();
+  }
+
+  /**
+   * Removes all the values from the array.
+   */
+  void clear() {
+    for (iterator iter = begin(); iter != end(); ++iter) {
+      iter->~T();
+    }
+    size_ = 0;
+  }
+
+  const_iterator begin() const {
+    return reinterpret_cast<const T*>(contents_);
+  }
+
+  const_iterator end() const {
+    return begin() + size_;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+
+  const T& operator[](size_type index) const {
+    return begin()[index];
+  }
+
+ private:
+  iterator begin() {
+    return reinterpret_cast<T*>(contents_);
+  }
+
+  iterator end() {
+    return begin() + size_;
+  }
+
+  iterator mutable_iterator(const_iterator pos) {
+    return begin() + (pos - static_cast<const FixedArray*>(this)->begin());
+  }
+
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type
+      contents_[fixed_size];
+  size_type size_ = 0;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_FIXED_ARRAY_H_
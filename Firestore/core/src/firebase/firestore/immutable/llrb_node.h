@@ -0,0 +1,403 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
+
+#include <stdint.h>
+
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A node in a left-leaning red-black tree, as described by Sedgewick in
+ * "Left-leaning Red-Black Trees". Nodes are immutable: operations that change
+ * the tree return a new root, which shares all the subtrees it didn't change
+ * with the original.
+ *
+ * LlrbNode is a value type that refers to its contents through a shared_ptr,
+ * so copying a node (and the whole tree below it) is cheap. An empty node
+ * doesn't allocate anything.
+ *
+ * The comparator is passed to the operations that need it rather than stored
+ * in every node; it must be the same for all operations on the same tree.
+ */
+template <typename K, typename V>
+class LlrbNode : public SortedMapBase {
+ public:
+  using first_type = K;
+  using second_type = V;
+
+  /**
+   * The type of the entries stored in the tree.
+   */
+  using value_type = std::pair<K, V>;
+
+  enum class Color { Red, Black };
+
+  /**
+   * Constructs an empty node.
+   */
+  LlrbNode() = default;
+
+  /** Returns the number of entries in this node and its subtrees. */
+  size_type size() const {
+    return rep_ ? rep_->size_ : 0;
+  }
+
+  /** Returns true if this is an empty node: the end of a branch. */
+  bool empty() const {
+    return rep_ == nullptr;
+  }
+
+  /** Returns the color of this node; empty nodes are black. */
+  Color color() const {
+    return rep_ ? rep_->color_ : Color::Black;
+  }
+
+  bool red() const {
+    return color() == Color::Red;
+  }
+
+  /** Returns the entry in this node, which must not be empty. */
+  const value_type& entry() const {
+    return rep_->entry_;
+  }
+  const K& key() const {
+    return entry().first;
+  }
+  const V& value() const {
+    return entry().second;
+  }
+
+  /** Returns the left subtree, which is empty if this node is. */
+  const LlrbNode& left() const {
+    return rep_ ? rep_->left_ : Empty();
+  }
+
+  /** Returns the right subtree, which is empty if this node is. */
+  const LlrbNode& right() const {
+    return rep_ ? rep_->right_ : Empty();
+  }
+
+  /** Returns the node with the smallest key in this tree. */
+  const LlrbNode& min() const {
+    const LlrbNode* node = this;
+    while (!node->left().empty()) {
+      node = &node->left();
+    }
+    return *node;
+  }
+
+  /** Returns the node with the largest key in this tree. */
+  const LlrbNode& max() const {
+    const LlrbNode* node = this;
+    while (!node->right().empty()) {
+      node = &node->right();
+    }
+    return *node;
+  }
+
+  /**
+   * Builds a tree from the given number of entries starting at begin, which
+   * must be sorted by key with no duplicates, in O(n) time.
+   *
+   * This uses the algorithm from "Constructing Red-Black Trees" by Hinze: the
+   * entries are split into chunks whose sizes follow the digits of n + 1 in
+   * a base-{1,2} number system, and each chunk becomes a "pennant" (a node
+   * whose right subtree is a perfectly balanced, all-black tree) on the left
+   * spine of the result.
+   */
+  template <typename Iter>
+  static LlrbNode FromSorted(Iter begin, size_type size) {
+    // The number of base-{1,2} digits in size: floor(log2(size + 1)).
+    int digits = 0;
+    for (uint64_t n = uint64_t{size} + 1; n > 1; n >>= 1) {
+      digits++;
+    }
+    uint64_t bits = (uint64_t{size} + 1) & ((uint64_t{1} << digits) - 1);
+
+    // Chunks are taken from the end of the range: each pennant is the left
+    // child of the one before it, so the first chunk holds the largest keys.
+    struct Pennant {
+      size_type index;
+      size_type chunk_size;
+      Color color;
+    };
+    Pennant pennants[2 * 32];
+    int count = 0;
+    size_type index = size;
+    for (int digit = digits - 1; digit >= 0; digit--) {
+      size_type chunk_size = size_type{1} << digit;
+      bool is_one = (bits & (uint64_t{1} << digit)) == 0;
+      index -= chunk_size;
+      pennants[count++] = {index, chunk_size, Color::Black};
+      if (!is_one) {
+        index -= chunk_size;
+        pennants[count++] = {index, chunk_size, Color::Red};
+      }
+    }
+
+    LlrbNode result;
+    for (int i = count - 1; i >= 0; i--) {
+      const Pennant& pennant = pennants[i];
+      Iter entry = std::next(begin, pennant.index);
+      LlrbNode right = BuildBlack(std::next(entry), pennant.chunk_size - 1);
+      result = Create(*entry, pennant.color, result, right);
+    }
+    return result;
+  }
+
+  /**
+   * Returns a tree like this one, which must be the root of its tree, but with
+   * the given key associated with the given value.
+   *
+   * @param comparator A less-than comparator on keys.
+   */
+  template <typename C>
+  LlrbNode insert(const K& key, const V& value, const C& comparator) const {
+    // The root is always black.
+    return InnerInsert(key, value, comparator).WithColor(Color::Black);
+  }
+
+  /**
+   * Returns a tree like this one, which must be the root of its tree, but
+   * without the entry with the given key, which must be in the tree.
+   *
+   * @param comparator A less-than comparator on keys.
+   */
+  template <typename C>
+  LlrbNode erase(const K& key, const C& comparator) const {
+    return InnerErase(key, comparator).WithColor(Color::Black);
+  }
+
+  /**
+   * Returns an estimate of the heap memory retained by this tree: its nodes,
+   * which it may share with other trees. Any heap memory owned by the keys and
+   * values themselves is not included.
+   *
+   * @param counted If not null, each node is only counted (along with its
+   *     subtrees) if it isn't already in this set, and is then added to it.
+   */
+  size_t HeapMemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    if (empty() || !util::CountOnce(rep_.get(), counted)) {
+      return 0;
+    }
+    return sizeof(Rep) + util::kSharedControlBlockSize +
+           left().HeapMemoryUsage(counted) + right().HeapMemoryUsage(counted);
+  }
+
+ private:
+  struct Rep;
+
+  explicit LlrbNode(std::shared_ptr<const Rep>&& rep) : rep_{std::move(rep)} {
+  }
+
+  static const LlrbNode& Empty() {
+    static const LlrbNode kEmpty;
+    return kEmpty;
+  }
+
+  static LlrbNode Create(const value_type& entry,
+                         Color color,
+                         const LlrbNode& left,
+                         const LlrbNode& right) {
+    return LlrbNode{std::make_shared<const Rep>(entry, color, left, right)};
+  }
+
+  static Color Opposite(Color color) {
+    return color == Color::Red ? Color::Black : Color::Red;
+  }
+
+  /**
+   * Builds a perfectly balanced tree of black nodes from the given number of
+   * sorted entries, which must be one less than a power of two.
+   */
+  template <typename Iter>
+  static LlrbNode BuildBlack(Iter begin, size_type size) {
+    if (size == 0) {
+      return LlrbNode{};
+    }
+    size_type half = size / 2;
+    Iter middle = std::next(begin, half);
+    return Create(*middle, Color::Black, BuildBlack(begin, half),
+                  BuildBlack(std::next(middle), half));
+  }
+
+  /** Returns this node with its color changed. Empty nodes stay empty. */
+  LlrbNode WithColor(Color color) const {
+    if (empty() || color == this->color()) {
+      return *this;
+    }
+    return Create(entry(), color, left(), right());
+  }
+
+  template <typename C>
+  LlrbNode InnerInsert(const K& key,
+                       const V& value,
+                       const C& comparator) const {
+    if (empty()) {
+      return Create(value_type{key, value}, Color::Red, LlrbNode{}, LlrbNode{});
+    }
+
+    LlrbNode result;
+    if (comparator(key, this->key())) {
+      result = Create(entry(), color(),
+                      left().InnerInsert(key, value, comparator), right());
+    } else if (comparator(this->key(), key)) {
+      result = Create(entry(), color(), left(),
+                      right().InnerInsert(key, value, comparator));
+    } else {
+      result = Create(value_type{key, value}, color(), left(), right());
+    }
+    return result.FixUp();
+  }
+
+  template <typename C>
+  LlrbNode InnerErase(const K& key, const C& comparator) const {
+    if (empty()) {
+      return *this;
+    }
+
+    LlrbNode n = *this;
+    if (comparator(key, n.key())) {
+      if (!n.left().empty() && !n.left().red() && !n.left().left().red()) {
+        n = n.MoveRedLeft();
+      }
+      n = Create(n.entry(), n.color(), n.left().InnerErase(key, comparator),
+                 n.right());
+    } else {
+      if (n.left().red()) {
+        n = n.RotateRight();
+      }
+      if (!n.right().empty() && !n.right().red() && !n.right().left().red()) {
+        n = n.MoveRedRight();
+      }
+
+      if (!comparator(n.key(), key) && !comparator(key, n.key())) {
+        if (n.right().empty()) {
+          return LlrbNode{};
+        }
+        // Replace this node's entry with its successor's.
+        n = Create(n.right().min().entry(), n.color(), n.left(),
+                   n.right().RemoveMin());
+      } else {
+        n = Create(n.entry(), n.color(), n.left(),
+                   n.right().InnerErase(key, comparator));
+      }
+    }
+    return n.FixUp();
+  }
+
+  LlrbNode RemoveMin() const {
+    if (left().empty()) {
+      return LlrbNode{};
+    }
+
+    LlrbNode n = *this;
+    if (!n.left().red() && !n.left().left().red()) {
+      n = n.MoveRedLeft();
+    }
+    n = Create(n.entry(), n.color(), n.left().RemoveMin(), n.right());
+    return n.FixUp();
+  }
+
+  /** Restores the invariants of a left-leaning red-black tree at this node. */
+  LlrbNode FixUp() const {
+    LlrbNode n = *this;
+    if (n.right().red() && !n.left().red()) {
+      n = n.RotateLeft();
+    }
+    if (n.left().red() && n.left().left().red()) {
+      n = n.RotateRight();
+    }
+    if (n.left().red() && n.right().red()) {
+      n = n.FlipColor();
+    }
+    return n;
+  }
+
+  LlrbNode MoveRedLeft() const {
+    LlrbNode n = FlipColor();
+    if (n.right().left().red()) {
+      n = Create(n.entry(), n.color(), n.left(), n.right().RotateRight());
+      n = n.RotateLeft().FlipColor();
+    }
+    return n;
+  }
+
+  LlrbNode MoveRedRight() const {
+    LlrbNode n = FlipColor();
+    if (n.left().left().red()) {
+      n = n.RotateRight().FlipColor();
+    }
+    return n;
+  }
+
+  LlrbNode RotateLeft() const {
+    LlrbNode new_left = Create(entry(), Color::Red, left(), right().left());
+    return Create(right().entry(), color(), new_left, right().right());
+  }
+
+  LlrbNode RotateRight() const {
+    LlrbNode new_right = Create(entry(), Color::Red, left().right(), right());
+    return Create(left().entry(), color(), left().left(), new_right);
+  }
+
+  LlrbNode FlipColor() const {
+    LlrbNode new_left = left().WithColor(Opposite(left().color()));
+    LlrbNode new_right = right().WithColor(Opposite(right().color()));
+    return Create(entry(), Opposite(color()), new_left, new_right);
+  }
+
+  std::shared_ptr<const Rep> rep_;
+};
+
+template <typename K, typename V>
+struct LlrbNode<K, V>::Rep {
+  Rep(const value_type& entry,
+      Color color,
+      const LlrbNode& left,
+      const LlrbNode& right)
+      : entry_{entry},
+        size_{left.size() + 1 + right.size()},
+        color_{color},
+        left_{left},
+        right_{right} {
+  }
+
+  value_type entry_;
+  size_type size_;
+  Color color_;
+  LlrbNode left_;
+  LlrbNode right_;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
+
+#include <stddef.h>
+
+#include <iterator>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A forward iterator over the entries of an LlrbNode tree, in order, or in
+ * reverse order if Reverse is true.
+ *
+ * The iterator keeps a stack of the nodes on the path from the root whose
+ * entries are still to be visited: the current node is on top, and below it
+ * are the ancestors whose left subtrees contain it. Advancing pops the
+ * current node and pushes the left spine of its right subtree. (In reverse,
+ * left and right swap places.)
+ *
+ * The stack points into the tree, so an iterator is only valid while the
+ * tree (or the map holding its root) it came from is.
+ *
+ * @tparam N The type of the nodes: an instantiation of LlrbNode.
+ * @tparam Reverse Whether to iterate in descending order.
+ */
+template <typename N, bool Reverse = false>
+class LlrbNodeIterator {
+ public:
+  using node_type = N;
+  using key_type = typename N::first_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename N::value_type;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  /** Constructs an end iterator. */
+  LlrbNodeIterator() = default;
+
+  /** Returns an iterator pointing to the first entry in the given tree. */
+  static LlrbNodeIterator Begin(const node_type* root) {
+    LlrbNodeIterator result;
+    result.Reserve(root);
+    result.PushSpine(root);
+    return result;
+  }
+
+  /** Returns an iterator pointing past the last entry of any tree. */
+  static LlrbNodeIterator End() {
+    return LlrbNodeIterator{};
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the given tree whose
+   * key is not less than the given key, or End() if there is none.
+   *
+   * @param comparator A less-than comparator on keys.
+   */
+  template <typename C>
+  static LlrbNodeIterator LowerBound(const node_type* root,
+                                     const key_type& key,
+                                     const C& comparator) {
+    static_assert(!Reverse, "LowerBound is only for forward iterators");
+    LlrbNodeIterator result;
+    result.Reserve(root);
+    const node_type* node = root;
+    while (!node->empty()) {
+      if (comparator(node->key(), key)) {
+        // The node and its left subtree are before the key.
+        node = &node->right();
+      } else {
+        // The node is a candidate, but there may be a closer one on the left.
+        result.stack_.push_back(node);
+        node = &node->left();
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the given tree whose
+   * key is greater than the given key, or End() if there is none.
+   *
+   * @param comparator A less-than comparator on keys.
+   */
+  template <typename C>
+  static LlrbNodeIterator UpperBound(const node_type* root,
+                                     const key_type& key,
+                                     const C& comparator) {
+    static_assert(!Reverse, "UpperBound is only for forward iterators");
+    LlrbNodeIterator result;
+    result.Reserve(root);
+    const node_type* node = root;
+    while (!node->empty()) {
+      if (comparator(key, node->key())) {
+        // The node is a candidate, but there may be a closer one on the left.
+        result.stack_.push_back(node);
+        node = &node->left();
+      } else {
+        // The node and its left subtree are not after the key.
+        node = &node->right();
+      }
+    }
+    return result;
+  }
+
+  reference operator*() const {
+    return current()->entry();
+  }
+
+  pointer operator->() const {
+    return &current()->entry();
+  }
+
+  LlrbNodeIterator& operator++() {
+    FIREBASE_ASSERT_MESSAGE(!stack_.empty(), "Can't advance past the end");
+    const node_type* node = stack_.back();
+    stack_.pop_back();
+    PushSpine(Reverse ? &node->left() : &node->right());
+    return *this;
+  }
+
+  LlrbNodeIterator operator++(int) {
+    LlrbNodeIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const LlrbNodeIterator& lhs,
+                         const LlrbNodeIterator& rhs) {
+    return lhs.current_or_null() == rhs.current_or_null();
+  }
+
+  friend bool operator!=(const LlrbNodeIterator& lhs,
+                         const LlrbNodeIterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  const node_type* current() const {
+    FIREBASE_ASSERT_MESSAGE(!stack_.empty(), "Can't dereference the end");
+    return stack_.back();
+  }
+
+  const node_type* current_or_null() const {
+    return stack_.empty() ? nullptr : stack_.back();
+  }
+
+  /**
+   * Reserves room for a path from the root to a leaf. A left-leaning
+   * red-black tree with n entries is at most 2 * log2(n + 1) deep.
+   */
+  void Reserve(const node_type* root) {
+    size_t depth = 0;
+    for (size_t size = root->size(); size > 0; size >>= 1) {
+      depth += 2;
+    }
+    stack_.reserve(depth);
+  }
+
+  /**
+   * Pushes the path from the given node to the first entry below it: its
+   * leftmost descendant, or its rightmost one in reverse.
+   */
+  void PushSpine(const node_type* node) {
+    while (!node->empty()) {
+      stack_.push_back(node);
+      node = Reverse ? &node->right() : &node->left();
+    }
+  }
+
+  std::vector<const node_type*> stack_;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
@@ -17,8 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_MAP_ENTRY_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_MAP_ENTRY_H_
 
+#include <stdint.h>
+
 #include <functional>
 #include <utility>
+#include <vector>
 
 namespace firebase {
 namespace firestore {
@@ -51,10 +54,126 @@ struct KeyComparator {
     return key_comparator_(lhs.first, rhs.first);
   }
 
+  const C& comparator() const {
+    return key_comparator_;
+  }
+
  private:
   C key_comparator_;
 };
 
+namespace impl {
+
+/**
+ * Merges two ranges of entries, each sorted by key with no duplicates, passing
+ * the combined entries to emit in order. Where both ranges have an entry with
+ * the same key, only the one from the second range is emitted. Takes
+ * O(n + m) time.
+ *
+ * @param key_less A less-than comparator on keys.
+ * @param emit A function that takes each merged entry.
+ * @return true if the result differs from the first range, i.e. the second
+ *     range has a key missing from the first, or a different value for one.
+ */
+template <typename Iter1, typename Iter2, typename Less, typename Emit>
+bool MergeEntries(Iter1 first1,
+                  Iter1 last1,
+                  Iter2 first2,
+                  Iter2 last2,
+                  const Less& key_less,
+                  const Emit& emit) {
+  bool changed = false;
+  while (first1 != last1 && first2 != last2) {
+    if (key_less(first1->first, first2->first)) {
+      emit(*first1);
+      ++first1;
+    } else if (key_less(first2->first, first1->first)) {
+      emit(*first2);
+      ++first2;
+      changed = true;
+    } else {
+      changed = changed || !(first1->second == first2->second);
+      emit(*first2);
+      ++first1;
+      ++first2;
+    }
+  }
+  for (; first1 != last1; ++first1) {
+    emit(*first1);
+  }
+  for (; first2 != last2; ++first2) {
+    emit(*first2);
+    changed = true;
+  }
+  return changed;
+}
+
+/**
+ * Returns a copy of map with the entries in the range [begin, end) inserted
+ * one at a time, so that later entries replace earlier ones with the same key.
+ */
+template <typename Map, typename SourceIterator>
+Map InsertEntries(Map map, SourceIterator begin, SourceIterator end) {
+  for (; begin != end; ++begin) {
+    map = map.insert(begin->first, begin->second);
+  }
+  return map;
+}
+
+/** Returns an upper bound on the depth of a balanced tree of the given size. */
+inline uint64_t TreeDepth(size_t size) {
+  uint64_t result = 1;
+  for (; size > 1; size >>= 1) {
+    result++;
+  }
+  return result;
+}
+
+/**
+ * Implements merge for the persistent tree maps (TreeSortedMap and
+ * BTreeSortedMap), returning a map with the entries of both, where entries in
+ * right replace those in left with the same key.
+ *
+ * When one map is much smaller than the other, its entries are inserted into
+ * the larger one, so that the result shares most of its nodes with the larger
+ * map. Otherwise both maps are merged into a new tree in O(n + m) time.
+ */
+template <typename Map>
+Map MergeTrees(const Map& left, const Map& right) {
+  using value_type = typename Map::value_type;
+
+  if (right.empty()) {
+    return left;
+  } else if (left.empty()) {
+    return right;
+  }
+
+  uint64_t n = left.size();
+  uint64_t m = right.size();
+  if (m * TreeDepth(n) < n + m) {
+    return InsertEntries(left, right.begin(), right.end());
+  } else if (n * TreeDepth(m) < n + m) {
+    Map result = right;
+    for (const value_type& entry : left) {
+      if (result.find(entry.first) == result.end()) {
+        result = result.insert(entry.first, entry.second);
+      }
+    }
+    return result;
+  }
+
+  std::vector<value_type> merged;
+  merged.reserve(n + m);
+  bool changed = MergeEntries(
+      left.begin(), left.end(), right.begin(), right.end(), left.comparator(),
+      [&merged](const value_type& entry) { merged.push_back(entry); });
+  if (!changed) {
+    return left;
+  }
+  return Map::FromSorted(merged.begin(), merged.end(), left.comparator());
+}
+
+}  // namespace impl
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,471 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
+
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/map_entry.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_iterator.h"
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+/**
+ * SortedMap is a value type containing a map. It is immutable, but has methods
+ * to efficiently create new maps that are mutations of it.
+ *
+ * Small maps are backed by an ArraySortedMap, which is compact and fast to
+ * search. Once a map grows beyond kFixedSize entries it switches to a
+ * TreeSortedMap, so that large maps still take O(log n) time to modify instead
+ * of copying (or overflowing) an array. The switch is transparent to users.
+ */
+template <typename K, typename V, typename C = std::less<K>>
+class SortedMap : public impl::SortedMapBase {
+ public:
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+
+  using array_type = ArraySortedMap<K, V, C>;
+  using tree_type = TreeSortedMap<K, V, C>;
+
+  using const_iterator =
+      impl::SortedMapIterator<value_type,
+                              typename array_type::const_iterator,
+                              typename tree_type::const_iterator>;
+  using const_reverse_iterator =
+      impl::SortedMapIterator<value_type,
+                              typename array_type::const_reverse_iterator,
+                              typename tree_type::const_reverse_iterator>;
+
+  class Builder;
+
+  /**
+   * Creates an empty SortedMap.
+   */
+  explicit SortedMap(const C& comparator = C())
+      : SortedMap{array_type{comparator}} {
+  }
+
+  /**
+   * Creates a SortedMap containing the given entries, which must be in order
+   * if there are no more than kFixedSize of them.
+   */
+  SortedMap(std::initializer_list<value_type> entries,
+            const C& comparator = C())
+      : SortedMap{entries.size() <= kFixedSize
+                      ? SortedMap{array_type{entries, comparator}}
+                      : SortedMap{tree_type{entries, comparator}}} {
+  }
+
+  /**
+   * Creates a SortedMap containing the entries in the range [begin, end),
+   * which must be sorted by key with no duplicates, in O(n) time.
+   */
+  template <typename SourceIterator>
+  static SortedMap FromSorted(SourceIterator begin,
+                              SourceIterator end,
+                              const C& comparator = C()) {
+    if (static_cast<size_t>(std::distance(begin, end)) <= kFixedSize) {
+      return SortedMap{array_type::FromSorted(begin, end, comparator)};
+    } else {
+      return SortedMap{tree_type::FromSorted(begin, end, comparator)};
+    }
+  }
+
+  /**
+   * As above, but a map small enough to be stored in an array allocates the
+   * array and its entries with the given allocator. Larger maps, and maps
+   * derived from the result, allocate on the heap.
+   */
+  template <typename SourceIterator>
+  static SortedMap FromSorted(
+      SourceIterator begin,
+      SourceIterator end,
+      const C& comparator,
+      const util::ArenaAllocator<value_type>& allocator) {
+    if (static_cast<size_t>(std::distance(begin, end)) <= kFixedSize) {
+      return SortedMap{
+          array_type::FromSorted(begin, end, comparator, allocator)};
+    } else {
+      return SortedMap{tree_type::FromSorted(begin, end, comparator)};
+    }
+  }
+
+  SortedMap(const SortedMap& other) : tag_{other.tag_} {
+    if (tag_ == Tag::Array) {
+      new (&array_) array_type(other.array_);
+    } else {
+      new (&tree_) tree_type(other.tree_);
+    }
+  }
+
+  SortedMap(SortedMap&& other) noexcept : tag_{other.tag_} {
+    if (tag_ == Tag::Array) {
+      new (&array_) array_type(std::move(other.array_));
+    } else {
+      new (&tree_) tree_type(std::move(other.tree_));
+    }
+  }
+
+  ~SortedMap() {
+    Destroy();
+  }
+
+  SortedMap& operator=(const SortedMap& other) {
+    if (this != &other) {
+      Destroy();
+      new (this) SortedMap(other);
+    }
+    return *this;
+  }
+
+  SortedMap& operator=(SortedMap&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      new (this) SortedMap(std::move(other));
+    }
+    return *this;
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated.
+   *
+   * @param key The key to insert/update.
+   * @param value The value to associate with the key.
+   * @return A new dictionary with the added/updated value.
+   */
+  SortedMap insert(const K& key, const V& value) const {
+    if (tag_ == Tag::Tree) {
+      return SortedMap{tree_.insert(key, value)};
+    }
+    if (array_.size() >= kFixedSize && array_.find(key) == array_.end()) {
+      // The array is full: switch to a tree.
+      tree_type tree = tree_type::FromSorted(array_.begin(), array_.end(),
+                                             array_.comparator());
+      return SortedMap{tree.insert(key, value)};
+    }
+    return SortedMap{array_.insert(key, value)};
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key removed from it.
+   *
+   * @param key The key to remove.
+   * @return A new dictionary without that value.
+   */
+  SortedMap erase(const K& key) const {
+    if (tag_ == Tag::Array) {
+      return SortedMap{array_.erase(key)};
+    } else {
+      return SortedMap{tree_.erase(key)};
+    }
+  }
+
+  /**
+   * Creates a new map containing the entries of both this map and the given
+   * one, which must use the same comparator, in at most O(n + m) time. Where
+   * both maps have an entry with the same key, the one from the other map
+   * wins. The result shares as much of its storage with the inputs as
+   * TreeSortedMap::merge allows.
+   */
+  SortedMap merge(const SortedMap& other) const {
+    if (tag_ == Tag::Tree || other.tag_ == Tag::Tree) {
+      return SortedMap{AsTree().merge(other.AsTree())};
+    }
+    if (size() + other.size() <= kFixedSize) {
+      return SortedMap{array_.merge(other.array_)};
+    }
+
+    std::vector<value_type> merged;
+    merged.reserve(size() + other.size());
+    bool changed = impl::MergeEntries(
+        array_.begin(), array_.end(), other.array_.begin(),
+        other.array_.end(), comparator(),
+        [&merged](const value_type& entry) { merged.push_back(entry); });
+    if (!changed) {
+      return *this;
+    }
+    return FromSorted(merged.begin(), merged.end(), comparator());
+  }
+
+  /**
+   * Finds a value in the map.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key, or end() if
+   *     not found.
+   */
+  const_iterator find(const K& key) const {
+    if (tag_ == Tag::Array) {
+      return const_iterator{array_.find(key)};
+    } else {
+      return const_iterator{tree_.find(key)};
+    }
+  }
+
+  /**
+   * Returns the index of the entry with the given key in the map, in key
+   * order, or npos if the map doesn't contain the key.
+   */
+  size_type find_index(const K& key) const {
+    if (tag_ == Tag::Array) {
+      return array_.find_index(key);
+    } else {
+      return tree_.find_index(key);
+    }
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry whose key is not less
+   * than the given key, or end() if there is none. Iterating from there
+   * visits the entries from the key onward.
+   */
+  const_iterator lower_bound(const K& key) const {
+    if (tag_ == Tag::Array) {
+      return const_iterator{array_.lower_bound(key)};
+    } else {
+      return const_iterator{tree_.lower_bound(key)};
+    }
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry whose key is greater than
+   * the given key, or end() if there is none.
+   */
+  const_iterator upper_bound(const K& key) const {
+    if (tag_ == Tag::Array) {
+      return const_iterator{array_.upper_bound(key)};
+    } else {
+      return const_iterator{tree_.upper_bound(key)};
+    }
+  }
+
+  /** Returns true if the map contains no elements. */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /** Returns the number of items in this map. */
+  size_type size() const {
+    return tag_ == Tag::Array ? array_.size() : tree_.size();
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the map. If there are
+   * no entries in the map, begin() == end().
+   */
+  const_iterator begin() const {
+    if (tag_ == Tag::Array) {
+      return const_iterator{array_.begin()};
+    } else {
+      return const_iterator{tree_.begin()};
+    }
+  }
+
+  /**
+   * Returns an iterator pointing past the last entry in the map.
+   */
+  const_iterator end() const {
+    if (tag_ == Tag::Array) {
+      return const_iterator{array_.end()};
+    } else {
+      return const_iterator{tree_.end()};
+    }
+  }
+
+  /**
+   * Returns an iterator pointing to the last entry in the map, for iterating
+   * in reverse order. If there are no entries, rbegin() == rend().
+   */
+  const_reverse_iterator rbegin() const {
+    if (tag_ == Tag::Array) {
+      return const_reverse_iterator{array_.rbegin()};
+    } else {
+      return const_reverse_iterator{tree_.rbegin()};
+    }
+  }
+
+  /**
+   * Returns an iterator pointing before the first entry in the map.
+   */
+  const_reverse_iterator rend() const {
+    if (tag_ == Tag::Array) {
+      return const_reverse_iterator{array_.rend()};
+    } else {
+      return const_reverse_iterator{tree_.rend()};
+    }
+  }
+
+  /** Returns the comparator used to order the keys of this map. */
+  const C& comparator() const {
+    return tag_ == Tag::Array ? array_.comparator() : tree_.comparator();
+  }
+
+  /**
+   * Returns an estimate of the memory retained by this map: the map itself
+   * and the array or tree holding its entries, which it may share with other
+   * maps. Any heap memory owned by the keys and values themselves is not
+   * included.
+   *
+   * @param counted If not null, shared storage is only counted if it isn't
+   *     already in this set, and is then added to it.
+   */
+  size_t MemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    if (tag_ == Tag::Array) {
+      return sizeof(*this) - sizeof(array_type) + array_.MemoryUsage(counted);
+    } else {
+      return sizeof(*this) - sizeof(tree_type) + tree_.MemoryUsage(counted);
+    }
+  }
+
+ private:
+  enum class Tag {
+    Array,
+    Tree,
+  };
+
+  explicit SortedMap(array_type&& array) : tag_{Tag::Array} {
+    new (&array_) array_type(std::move(array));
+  }
+
+  explicit SortedMap(tree_type&& tree) : tag_{Tag::Tree} {
+    new (&tree_) tree_type(std::move(tree));
+  }
+
+  /**
+   * Returns the entries of this map as a tree, converting them in O(n) time
+   * if they are in an array.
+   */
+  tree_type AsTree() const {
+    if (tag_ == Tag::Array) {
+      return tree_type::FromSorted(array_.begin(), array_.end(),
+                                   array_.comparator());
+    } else {
+      return tree_;
+    }
+  }
+
+  void Destroy() {
+    if (tag_ == Tag::Array) {
+      array_.~array_type();
+    } else {
+      tree_.~tree_type();
+    }
+  }
+
+  Tag tag_;
+  union {
+    array_type array_;
+    tree_type tree_;
+  };
+};
+
+/**
+ * A mutable SortedMap under construction, for making many changes to a map at
+ * once. While the map fits in an array, the Builder updates a single copy of
+ * the array in place (see ArraySortedMap::Builder). Once it grows beyond
+ * kFixedSize entries it switches to a TreeSortedMap, which only copies the
+ * O(log n) nodes on the path to each change.
+ */
+template <typename K, typename V, typename C>
+class SortedMap<K, V, C>::Builder {
+ public:
+  /** Creates a Builder for an empty map. */
+  explicit Builder(const C& comparator = C())
+      : array_builder_{comparator}, tree_{comparator} {
+  }
+
+  /** Creates a Builder that starts out with the entries of the given map. */
+  explicit Builder(const SortedMap& map)
+      : array_builder_{map.tag_ == Tag::Array ? map.array_
+                                              : array_type{map.comparator()}},
+        tree_{map.tag_ == Tag::Tree ? map.tree_ : tree_type{map.comparator()}},
+        tag_{map.tag_} {
+  }
+
+  /** Adds a key-value pair to the map or updates the value of a key. */
+  Builder& insert(const K& key, const V& value) {
+    if (tag_ == Tag::Tree) {
+      tree_ = tree_.insert(key, value);
+    } else if (array_builder_.size() >= kFixedSize &&
+               array_builder_.find(key) == array_builder_.end()) {
+      // The array is full: switch to a tree.
+      tree_ = tree_type::FromSorted(array_builder_.begin(),
+                                    array_builder_.end(),
+                                    array_builder_.comparator())
+                  .insert(key, value);
+      array_builder_ = typename array_type::Builder{tree_.comparator()};
+      tag_ = Tag::Tree;
+    } else {
+      array_builder_.insert(key, value);
+    }
+    return *this;
+  }
+
+  /** Removes a key from the map, if it's there. */
+  Builder& erase(const K& key) {
+    if (tag_ == Tag::Array) {
+      array_builder_.erase(key);
+    } else {
+      tree_ = tree_.erase(key);
+    }
+    return *this;
+  }
+
+  /** Returns the number of items in the map. */
+  size_type size() const {
+    return tag_ == Tag::Array ? array_builder_.size() : tree_.size();
+  }
+
+  /**
+   * Returns the map built so far. The Builder can be used again afterwards
+   * without affecting the result.
+   */
+  SortedMap Build() {
+    if (tag_ == Tag::Array) {
+      return SortedMap{array_builder_.Build()};
+    } else {
+      return SortedMap{tree_type{tree_}};
+    }
+  }
+
+ private:
+  typename array_type::Builder array_builder_;
+  tree_type tree_;
+  Tag tag_ = Tag::Array;
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
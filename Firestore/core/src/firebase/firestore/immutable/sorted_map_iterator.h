@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_ITERATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_ITERATOR_H_
+
+#include <stddef.h>
+
+#include <iterator>
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A forward iterator over a SortedMap, which wraps the iterator of whichever
+ * implementation currently backs the map.
+ *
+ * @tparam V The type of the entries in the map.
+ * @tparam ArrayIter The iterator type of the array-backed implementation.
+ * @tparam TreeIter The iterator type of the tree-backed implementation.
+ */
+template <typename V, typename ArrayIter, typename TreeIter>
+class SortedMapIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = V;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  explicit SortedMapIterator(ArrayIter array_iter)
+      : tag_{Tag::Array}, array_iter_{array_iter} {
+  }
+
+  explicit SortedMapIterator(TreeIter tree_iter)
+      : tag_{Tag::Tree}, tree_iter_{std::move(tree_iter)} {
+  }
+
+  reference operator*() const {
+    return tag_ == Tag::Array ? *array_iter_ : *tree_iter_;
+  }
+
+  pointer operator->() const {
+    return &**this;
+  }
+
+  SortedMapIterator& operator++() {
+    if (tag_ == Tag::Array) {
+      ++array_iter_;
+    } else {
+      ++tree_iter_;
+    }
+    return *this;
+  }
+
+  SortedMapIterator operator++(int) {
+    SortedMapIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const SortedMapIterator& lhs,
+                         const SortedMapIterator& rhs) {
+    if (lhs.tag_ != rhs.tag_) {
+      return false;
+    }
+    return lhs.tag_ == Tag::Array ? lhs.array_iter_ == rhs.array_iter_
+                                  : lhs.tree_iter_ == rhs.tree_iter_;
+  }
+
+  friend bool operator!=(const SortedMapIterator& lhs,
+                         const SortedMapIterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  enum class Tag { Array, Tree };
+
+  Tag tag_;
+  // Only the iterator matching the tag is meaningful. Unlike the maps, the
+  // iterators are cheap to default-construct, so there's no need for a union.
+  ArrayIter array_iter_{};
+  TreeIter tree_iter_{};
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_ITERATOR_H_
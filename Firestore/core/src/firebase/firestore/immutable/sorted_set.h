@@ -0,0 +1,353 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+namespace impl {
+
+/** The value type of the SortedMap underlying a SortedSet. */
+struct Empty {
+  friend bool operator==(Empty, Empty) {
+    return true;
+  }
+};
+
+/**
+ * A forward iterator over the keys of a SortedSet, which wraps an iterator
+ * over the entries of its map.
+ */
+template <typename K, typename MapIter>
+class SortedSetIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = K;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  explicit SortedSetIterator(MapIter iter) : iter_{std::move(iter)} {
+  }
+
+  reference operator*() const {
+    return iter_->first;
+  }
+
+  pointer operator->() const {
+    return &iter_->first;
+  }
+
+  SortedSetIterator& operator++() {
+    ++iter_;
+    return *this;
+  }
+
+  SortedSetIterator operator++(int) {
+    SortedSetIterator result = *this;
+    ++iter_;
+    return result;
+  }
+
+  friend bool operator==(const SortedSetIterator& lhs,
+                         const SortedSetIterator& rhs) {
+    return lhs.iter_ == rhs.iter_;
+  }
+
+  friend bool operator!=(const SortedSetIterator& lhs,
+                         const SortedSetIterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  MapIter iter_;
+};
+
+}  // namespace impl
+
+/**
+ * SortedSet is a value type containing a set of keys. Like SortedMap, which
+ * backs it, it is immutable, but has methods to efficiently create new sets
+ * that are mutations of it.
+ *
+ * The set algebra operations (Union, Intersection and Difference) each walk
+ * both sets once, taking O(n + m) time instead of the O(m log(n + m)) of
+ * adding or removing one key at a time, and return this set itself when the
+ * result would be equal to it.
+ */
+template <typename K, typename C = std::less<K>>
+class SortedSet : public impl::SortedMapBase {
+ public:
+  using value_type = K;
+  using map_type = SortedMap<K, impl::Empty, C>;
+  using const_iterator =
+      impl::SortedSetIterator<K, typename map_type::const_iterator>;
+  using const_reverse_iterator =
+      impl::SortedSetIterator<K, typename map_type::const_reverse_iterator>;
+
+  /**
+   * Creates an empty SortedSet.
+   */
+  explicit SortedSet(const C& comparator = C()) : map_{comparator} {
+  }
+
+  /**
+   * Creates a SortedSet containing the given keys, in any order.
+   */
+  SortedSet(std::initializer_list<K> keys, const C& comparator = C())
+      : map_{comparator} {
+    typename map_type::Builder builder{comparator};
+    for (const K& key : keys) {
+      builder.insert(key, impl::Empty{});
+    }
+    map_ = builder.Build();
+  }
+
+  /**
+   * Creates a SortedSet containing the keys in the range [begin, end), which
+   * must be sorted with no duplicates, in O(n) time.
+   */
+  template <typename SourceIterator>
+  static SortedSet FromSorted(SourceIterator begin,
+                              SourceIterator end,
+                              const C& comparator = C()) {
+    std::vector<std::pair<K, impl::Empty>> entries;
+    for (; begin != end; ++begin) {
+      entries.emplace_back(*begin, impl::Empty{});
+    }
+    return SortedSet{
+        map_type::FromSorted(entries.begin(), entries.end(), comparator)};
+  }
+
+  /**
+   * Creates a new set identical to this one, but with the given key added.
+   */
+  SortedSet insert(const K& key) const {
+    return SortedSet{map_.insert(key, impl::Empty{})};
+  }
+
+  /**
+   * Creates a new set identical to this one, but with the given key removed.
+   */
+  SortedSet erase(const K& key) const {
+    return SortedSet{map_.erase(key)};
+  }
+
+  /** Returns true if the set contains the given key. */
+  bool contains(const K& key) const {
+    return map_.find(key) != map_.end();
+  }
+
+  /**
+   * Finds a key in the set.
+   *
+   * @return An iterator pointing to the key, or end() if not found.
+   */
+  const_iterator find(const K& key) const {
+    return const_iterator{map_.find(key)};
+  }
+
+  /**
+   * Returns the index of the given key in the set, in order, or npos if the
+   * set doesn't contain it.
+   */
+  size_type find_index(const K& key) const {
+    return map_.find_index(key);
+  }
+
+  /**
+   * Returns an iterator pointing to the first key that is not less than the
+   * given key, or end() if there is none.
+   */
+  const_iterator lower_bound(const K& key) const {
+    return const_iterator{map_.lower_bound(key)};
+  }
+
+  /**
+   * Returns an iterator pointing to the first key that is greater than the
+   * given key, or end() if there is none.
+   */
+  const_iterator upper_bound(const K& key) const {
+    return const_iterator{map_.upper_bound(key)};
+  }
+
+  /**
+   * Returns a set containing the keys in either this set or the given one,
+   * which must use the same comparator.
+   */
+  SortedSet Union(const SortedSet& other) const {
+    return SortedSet{map_.merge(other.map_)};
+  }
+
+  /**
+   * Returns a set containing the keys in both this set and the given one,
+   * which must use the same comparator.
+   */
+  SortedSet Intersection(const SortedSet& other) const {
+    std::vector<K> result;
+    size_type found = Walk(other, [&result](const K& key, bool in_other) {
+      if (in_other) {
+        result.push_back(key);
+      }
+    });
+    return Rebuild(result, size() - found);
+  }
+
+  /**
+   * Returns a set containing the keys in this set but not in the given one,
+   * which must use the same comparator.
+   */
+  SortedSet Difference(const SortedSet& other) const {
+    std::vector<K> result;
+    size_type found = Walk(other, [&result](const K& key, bool in_other) {
+      if (!in_other) {
+        result.push_back(key);
+      }
+    });
+    return Rebuild(result, found);
+  }
+
+  /** Returns true if the set contains no keys. */
+  bool empty() const {
+    return map_.empty();
+  }
+
+  /** Returns the number of keys in this set. */
+  size_type size() const {
+    return map_.size();
+  }
+
+  /**
+   * Returns an iterator pointing to the first key in the set. If the set is
+   * empty, begin() == end().
+   */
+  const_iterator begin() const {
+    return const_iterator{map_.begin()};
+  }
+
+  /**
+   * Returns an iterator pointing past the last key in the set.
+   */
+  const_iterator end() const {
+    return const_iterator{map_.end()};
+  }
+
+  /**
+   * Returns an iterator pointing to the last key in the set, for iterating in
+   * reverse order. If the set is empty, rbegin() == rend().
+   */
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator{map_.rbegin()};
+  }
+
+  /**
+   * Returns an iterator pointing before the first key in the set.
+   */
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator{map_.rend()};
+  }
+
+  /** Returns the comparator used to order the keys of this set. */
+  const C& comparator() const {
+    return map_.comparator();
+  }
+
+  /**
+   * Returns an estimate of the memory retained by this set, as described by
+   * SortedMap::MemoryUsage.
+   */
+  size_t MemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    return sizeof(*this) - sizeof(map_type) + map_.MemoryUsage(counted);
+  }
+
+  friend bool operator==(const SortedSet& lhs, const SortedSet& rhs) {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                      [&lhs](const K& left, const K& right) {
+                        return !lhs.comparator()(left, right) &&
+                               !lhs.comparator()(right, left);
+                      });
+  }
+
+  friend bool operator!=(const SortedSet& lhs, const SortedSet& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  explicit SortedSet(map_type&& map) : map_{std::move(map)} {
+  }
+
+  /**
+   * Passes each key of this set to visit in order, along with whether the
+   * other set contains it, in a single pass over both sets.
+   *
+   * @return The number of keys of this set that the other set contains.
+   */
+  template <typename Visit>
+  size_type Walk(const SortedSet& other, const Visit& visit) const {
+    const C& less = comparator();
+    size_type found = 0;
+    const_iterator other_iter = other.begin();
+    const_iterator other_end = other.end();
+    for (const K& key : *this) {
+      while (other_iter != other_end && less(*other_iter, key)) {
+        ++other_iter;
+      }
+      bool in_other = other_iter != other_end && !less(key, *other_iter);
+      if (in_other) {
+        found++;
+      }
+      visit(key, in_other);
+    }
+    return found;
+  }
+
+  /**
+   * Returns a set of the given sorted keys, which are a subset of this set's
+   * keys, or this set itself if removed is zero.
+   */
+  SortedSet Rebuild(const std::vector<K>& keys, size_type removed) const {
+    if (removed == 0) {
+      return *this;
+    }
+    return FromSorted(keys.begin(), keys.end(), comparator());
+  }
+
+  map_type map_;
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_TREE_SORTED_MAP_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_TREE_SORTED_MAP_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/llrb_node.h"
+#include "Firestore/core/src/firebase/firestore/immutable/llrb_node_iterator.h"
+#include "Firestore/core/src/firebase/firestore/immutable/map_entry.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+/**
+ * TreeSortedMap is a value type containing a map. It is immutable, but has
+ * methods to efficiently create new maps that are mutations of it.
+ *
+ * TreeSortedMap is backed by a left-leaning red-black tree, so insertions,
+ * removals and lookups take O(log n) time, and a new map shares all but
+ * O(log n) of its nodes with the map it was made from.
+ */
+template <typename K, typename V, typename C = std::less<K>>
+class TreeSortedMap : public impl::SortedMapBase {
+ public:
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+
+  /**
+   * The type of the nodes of the tree backing the map.
+   */
+  using node_type = impl::LlrbNode<K, V>;
+  using const_iterator = impl::LlrbNodeIterator<node_type>;
+  using const_reverse_iterator = impl::LlrbNodeIterator<node_type, true>;
+
+  /**
+   * Creates an empty TreeSortedMap.
+   */
+  explicit TreeSortedMap(const C& comparator = C()) : comparator_(comparator) {
+  }
+
+  /**
+   * Creates a TreeSortedMap containing the given entries.
+   */
+  TreeSortedMap(std::initializer_list<value_type> entries,
+                const C& comparator = C())
+      : TreeSortedMap{Create(entries.begin(), entries.end(), comparator)} {
+  }
+
+  /**
+   * Creates a TreeSortedMap containing the entries in the range [begin, end),
+   * e.g. the contents of an ArraySortedMap. Later entries replace earlier ones
+   * with the same key.
+   */
+  template <typename SourceIterator>
+  static TreeSortedMap Create(SourceIterator begin,
+                              SourceIterator end,
+                              const C& comparator = C()) {
+    return impl::InsertEntries(TreeSortedMap{comparator}, begin, end);
+  }
+
+  /**
+   * Creates a TreeSortedMap containing the entries in the range [begin, end),
+   * which must be sorted by key with no duplicates, in O(n) time.
+   */
+  template <typename SourceIterator>
+  static TreeSortedMap FromSorted(SourceIterator begin,
+                                  SourceIterator end,
+                                  const C& comparator = C()) {
+    auto size = static_cast<size_type>(std::distance(begin, end));
+    return TreeSortedMap{node_type::FromSorted(begin, size), comparator};
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated.
+   *
+   * @param key The key to insert/update.
+   * @param value The value to associate with the key.
+   * @return A new dictionary with the added/updated value.
+   */
+  TreeSortedMap insert(const K& key, const V& value) const {
+    const node_type* existing = FindNode(key);
+    if (existing && existing->value() == value) {
+      return *this;
+    }
+    return TreeSortedMap{root_.insert(key, value, comparator_), comparator_};
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key removed from it.
+   *
+   * @param key The key to remove.
+   * @return A new dictionary without that value.
+   */
+  TreeSortedMap erase(const K& key) const {
+    // Removing is somewhat expensive even if the key doesn't exist (the tree
+    // is rebalanced along the way), so check first.
+    if (!FindNode(key)) {
+      return *this;
+    }
+    return TreeSortedMap{root_.erase(key, comparator_), comparator_};
+  }
+
+  /**
+   * Creates a new map containing the entries of both this map and the given
+   * one, which must use the same comparator. Where both maps have an entry
+   * with the same key, the one from the other map wins.
+   *
+   * When one map is much smaller than the other, the result shares most of
+   * its nodes with the larger one; see impl::MergeTrees.
+   */
+  TreeSortedMap merge(const TreeSortedMap& other) const {
+    return impl::MergeTrees(*this, other);
+  }
+
+  /**
+   * Finds a value in the map.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key, or end() if
+   *     not found.
+   */
+  const_iterator find(const K& key) const {
+    const_iterator result = lower_bound(key);
+    if (result != end() && !comparator_(key, result->first)) {
+      return result;
+    }
+    return end();
+  }
+
+  /**
+   * Returns the index of the entry with the given key in the map, in key
+   * order, or npos if the map doesn't contain the key. Takes O(log n) time.
+   */
+  size_type find_index(const K& key) const {
+    size_type index = 0;
+    const node_type* node = &root_;
+    while (!node->empty()) {
+      if (comparator_(key, node->key())) {
+        node = &node->left();
+      } else if (comparator_(node->key(), key)) {
+        index += node->left().size() + 1;
+        node = &node->right();
+      } else {
+        return index + node->left().size();
+      }
+    }
+    return npos;
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry whose key is not less
+   * than the given key, or end() if there is none. Iterating from there
+   * visits the entries from the key onward.
+   */
+  const_iterator lower_bound(const K& key) const {
+    return const_iterator::LowerBound(&root_, key, comparator_);
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry whose key is greater than
+   * the given key, or end() if there is none.
+   */
+  const_iterator upper_bound(const K& key) const {
+    return const_iterator::UpperBound(&root_, key, comparator_);
+  }
+
+  /** Returns true if the map contains no elements. */
+  bool empty() const {
+    return root_.empty();
+  }
+
+  /** Returns the number of items in this map. */
+  size_type size() const {
+    return root_.size();
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the map. If there are
+   * no entries in the map, begin() == end().
+   */
+  const_iterator begin() const {
+    return const_iterator::Begin(&root_);
+  }
+
+  /**
+   * Returns an iterator pointing past the last entry in the map.
+   */
+  const_iterator end() const {
+    return const_iterator::End();
+  }
+
+  /**
+   * Returns an iterator pointing to the last entry in the map, for iterating
+   * in reverse order. If there are no entries, rbegin() == rend().
+   */
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator::Begin(&root_);
+  }
+
+  /**
+   * Returns an iterator pointing before the first entry in the map.
+   */
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator::End();
+  }
+
+  /** Returns the comparator used to order the keys of this map. */
+  const C& comparator() const {
+    return comparator_;
+  }
+
+  /** Returns the root of the tree backing the map. */
+  const node_type& root() const {
+    return root_;
+  }
+
+  /**
+   * Returns an estimate of the memory retained by this map: the map itself
+   * and the nodes of its tree, which it may share with other maps. Any heap
+   * memory owned by the keys and values themselves is not included.
+   *
+   * @param counted If not null, each node is only counted if it isn't already
+   *     in this set, and is then added to it. Passing the same set for several
+   *     maps counts nodes they share only once.
+   */
+  size_t MemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    return sizeof(*this) + root_.HeapMemoryUsage(counted);
+  }
+
+ private:
+  TreeSortedMap(node_type&& root, const C& comparator) noexcept
+      : comparator_(comparator), root_(std::move(root)) {
+  }
+
+  /** Returns the node with the given key, or nullptr if there is none. */
+  const node_type* FindNode(const K& key) const {
+    const node_type* node = &root_;
+    while (!node->empty()) {
+      if (comparator_(key, node->key())) {
+        node = &node->left();
+      } else if (comparator_(node->key(), key)) {
+        node = &node->right();
+      } else {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  C comparator_;
+  node_type root_;
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_TREE_SORTED_MAP_H_
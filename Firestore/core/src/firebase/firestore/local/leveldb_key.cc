@@ -24,6 +24,7 @@
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 
+using firebase::firestore::model::CompactDocumentKey;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::util::OrderedCode;
@@ -350,6 +351,38 @@ bool ReadDocumentKey(leveldb::Slice *contents, DocumentKey *result) {
   return false;
 }
 
+/**
+ * Reads a document key like ReadDocumentKey() does, but decodes the path
+ * segments straight into the buffer of a compact key.
+ */
+bool ReadCompactDocumentKey(leveldb::Slice *contents,
+                            CompactDocumentKey *result) {
+  leveldb::Slice complete_segments = *contents;
+
+  CompactDocumentKey::Builder builder;
+  for (;;) {
+    leveldb::Slice read_position = complete_segments;
+    if (!ReadComponentLabelMatching(&read_position,
+                                    ComponentLabel::PathSegment)) {
+      break;
+    }
+    if (!ReadString(&read_position, builder.bytes())) {
+      return false;
+    }
+    builder.EndSegment();
+
+    complete_segments = read_position;
+  }
+
+  if (builder.size() > 0 && builder.size() % 2 == 0) {
+    *contents = complete_segments;
+    *result = builder.Build();
+    return true;
+  }
+
+  return false;
+}
+
 // Trivial shortcuts that make reading and writing components type-safe.
 
 inline void WriteTerminator(std::string *dest) {
@@ -764,6 +797,12 @@ bool LevelDbRemoteDocumentKey::Decode(leveldb::Slice key) {
          ReadDocumentKey(&key, &document_key_) && ReadTerminator(&key);
 }
 
+bool LevelDbRemoteDocumentKey::DecodeCompact(leveldb::Slice key,
+                                             CompactDocumentKey *result) {
+  return ReadTableNameMatching(&key, kRemoteDocumentsTable) &&
+         ReadCompactDocumentKey(&key, result) && ReadTerminator(&key);
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
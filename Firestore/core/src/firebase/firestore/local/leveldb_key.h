@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include "Firestore/core/src/firebase/firestore/model/compact_document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
@@ -468,6 +469,17 @@ class LevelDbRemoteDocumentKey {
    */
   bool Decode(leveldb::Slice key);
 
+  /**
+   * Decodes just the document key from a complete remote document key, into
+   * its compact form. The segments are decoded straight into the key's
+   * storage, without building a ResourcePath first.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, result is left unchanged.
+   */
+  static bool DecodeCompact(leveldb::Slice key,
+                            model::CompactDocumentKey* result);
+
   /** The path to the document, as encoded in the key. */
   const model::DocumentKey& document_key() const {
     return document_key_;
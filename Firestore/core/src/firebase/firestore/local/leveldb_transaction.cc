@@ -19,8 +19,10 @@
 #include <leveldb/write_batch.h>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
 
 using leveldb::DB;
 using leveldb::ReadOptions;
@@ -34,98 +36,112 @@ namespace firestore {
 namespace local {
 
 LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
-    : db_iter_(txn->db_->NewIterator(txn->read_options_)),
+    : Iterator(txn, txn->read_options_, absl::string_view{}) {
+}
+
+LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn,
+                                       const ReadOptions& read_options,
+                                       absl::string_view limit)
+    : db_iter_(txn->db_->NewIterator(read_options)),
+      limit_(limit),
       last_version_(txn->version_),
       txn_(txn),
-      mutations_iter_(txn->mutations_.begin()),
-      current_(),
-      is_mutation_(false),
+      buffer_iter_(&txn->writes_),
+      key_(),
+      value_(),
       // Iterator doesn't really point to anything yet, so is
       // invalid
       is_valid_(false) {
 }
 
 void LevelDbTransaction::Iterator::UpdateCurrent() {
-  bool mutation_is_valid = mutations_iter_ != txn_->mutations_.end();
-  is_valid_ = mutation_is_valid || db_iter_->Valid();
-
-  if (is_valid_) {
-    if (!mutation_is_valid) {
-      is_mutation_ = false;
-    } else if (!db_iter_->Valid()) {
-      is_mutation_ = true;
-    } else {
-      // Both iterators are valid. If the leveldb key is equal to or greater
-      // than the current mutation key, we are looking at a mutation next. It's
-      // either sooner in the iteration or directly shadowing the underlying
-      // committed value in leveldb.
-      is_mutation_ = db_iter_->key().compare(mutations_iter_->first) >= 0;
+  while (true) {
+    bool buffer_is_valid = buffer_iter_.Valid();
+    bool db_is_valid = db_iter_->Valid();
+    is_valid_ = buffer_is_valid || db_is_valid;
+    if (!is_valid_) {
+      return;
     }
-    if (is_mutation_) {
-      current_ = *mutations_iter_;
+
+    int comparison;
+    if (!buffer_is_valid) {
+      comparison = -1;
+    } else if (!db_is_valid) {
+      comparison = 1;
     } else {
-      current_ = {db_iter_->key().ToString(), db_iter_->value().ToString()};
+      comparison = MakeStringView(db_iter_->key()).compare(buffer_iter_.key());
     }
+
+    absl::string_view key = comparison < 0 ? MakeStringView(db_iter_->key())
+                                           : buffer_iter_.key();
+    if (!limit_.empty() && key >= limit_) {
+      is_valid_ = false;
+      return;
+    }
+
+    if (comparison < 0) {
+      key_ = key;
+      value_ = MakeStringView(db_iter_->value());
+      return;
+    }
+
+    // The pending change comes next. It's either sooner in the iteration or
+    // directly shadowing the underlying committed value in leveldb.
+    if (!buffer_iter_.is_delete()) {
+      key_ = buffer_iter_.key();
+      value_ = buffer_iter_.value();
+      return;
+    }
+
+    // Skip the deletion, along with the committed value it deletes, if any.
+    if (comparison == 0) {
+      db_iter_->Next();
+    }
+    buffer_iter_.Next();
   }
 }
 
-void LevelDbTransaction::Iterator::Seek(const std::string& key) {
-  db_iter_->Seek(key);
-  for (; db_iter_->Valid() && IsDeleted(db_iter_->key()); db_iter_->Next()) {
-  }
-  mutations_iter_ = txn_->mutations_.lower_bound(key);
+void LevelDbTransaction::Iterator::Seek(absl::string_view key) {
+  // The key may point into db_iter_'s current entry, which seeking
+  // invalidates, so look it up in the pending changes first.
+  buffer_iter_.Seek(key);
+  db_iter_->Seek(MakeSlice(key));
   UpdateCurrent();
   last_version_ = txn_->version_;
 }
 
 absl::string_view LevelDbTransaction::Iterator::key() {
   FIREBASE_ASSERT_MESSAGE(Valid(), "key() called on invalid iterator");
-  return current_.first;
+  return key_;
 }
 
 absl::string_view LevelDbTransaction::Iterator::value() {
   FIREBASE_ASSERT_MESSAGE(Valid(), "value() called on invalid iterator");
-  return current_.second;
+  return value_;
 }
 
-bool LevelDbTransaction::Iterator::IsDeleted(leveldb::Slice slice) {
-  return txn_->deletions_.find(slice.ToString()) != txn_->deletions_.end();
-}
-
-bool LevelDbTransaction::Iterator::SyncToTransaction() {
+void LevelDbTransaction::Iterator::SyncToTransaction() {
   if (last_version_ < txn_->version_) {
-    // Intentionally copying here since Seek() may update current_. We need the
-    // copy to do the comparison below.
-    const std::string current_key = current_.first;
-    Seek(current_key);
-    // If we advanced, we don't need to advance again.
-    return is_valid_ && current_.first > current_key;
-  } else {
-    return false;
+    // db_iter_ reads a snapshot of leveldb, so it's still in the right place.
+    buffer_iter_.Seek(key_);
+    last_version_ = txn_->version_;
   }
 }
 
-void LevelDbTransaction::Iterator::AdvanceLDB() {
-  do {
-    db_iter_->Next();
-  } while (db_iter_->Valid() && IsDeleted(db_iter_->key()));
-}
-
 void LevelDbTransaction::Iterator::Next() {
   FIREBASE_ASSERT_MESSAGE(Valid(), "Next() called on invalid iterator");
-  bool advanced = SyncToTransaction();
-  if (!advanced) {
-    if (is_mutation_) {
-      // A mutation might be shadowing leveldb. If so, advance both.
-      if (db_iter_->Valid() && db_iter_->key() == mutations_iter_->first) {
-        AdvanceLDB();
-      }
-      ++mutations_iter_;
-    } else {
-      AdvanceLDB();
-    }
-    UpdateCurrent();
+  SyncToTransaction();
+
+  // Both iterators are at or after the current key. Move past it any that are
+  // on it (i.e. both, if a pending change shadows a committed value). key_
+  // may point into db_iter_'s entry, so db_iter_ has to move last.
+  if (buffer_iter_.Valid() && buffer_iter_.key() == key_) {
+    buffer_iter_.Next();
+  }
+  if (db_iter_->Valid() && MakeStringView(db_iter_->key()) == key_) {
+    db_iter_->Next();
   }
+  UpdateCurrent();
 }
 
 bool LevelDbTransaction::Iterator::Valid() {
@@ -136,8 +152,7 @@ LevelDbTransaction::LevelDbTransaction(DB* db,
                                        const ReadOptions& read_options,
                                        const WriteOptions& write_options)
     : db_(db),
-      mutations_(),
-      deletions_(),
+      writes_(),
       read_options_(read_options),
       write_options_(write_options),
       version_(0) {
@@ -159,49 +174,60 @@ const WriteOptions& LevelDbTransaction::DefaultWriteOptions() {
 
 void LevelDbTransaction::Put(const absl::string_view& key,
                              const absl::string_view& value) {
-  std::string key_string(key);
-  std::string value_string(value);
-  mutations_[key_string] = value_string;
-  deletions_.erase(key_string);
+  writes_.Put(key, value);
   version_++;
 }
 
 std::unique_ptr<LevelDbTransaction::Iterator>
 LevelDbTransaction::NewIterator() {
-  return std::make_unique<LevelDbTransaction::Iterator>(this);
+  return std::unique_ptr<Iterator>(new Iterator(this));
+}
+
+std::unique_ptr<LevelDbTransaction::Iterator> LevelDbTransaction::Scan(
+    absl::string_view prefix, const ScanOptions& options) {
+  return Scan(prefix, util::PrefixSuccessor(prefix), options);
+}
+
+std::unique_ptr<LevelDbTransaction::Iterator> LevelDbTransaction::Scan(
+    absl::string_view start,
+    absl::string_view limit,
+    const ScanOptions& options) {
+  ReadOptions read_options = read_options_;
+  read_options.fill_cache = options.fill_cache;
+  std::unique_ptr<Iterator> result{new Iterator(this, read_options, limit)};
+  result->Seek(start);
+  return result;
 }
 
 Status LevelDbTransaction::Get(const absl::string_view& key,
                                std::string* value) {
-  std::string key_string(key);
-  if (deletions_.find(key_string) != deletions_.end()) {
-    return Status::NotFound(key_string + " is not present in the transaction");
+  WriteBuffer::Iterator write = writes_.Find(key);
+  if (!write.Valid()) {
+    return db_->Get(read_options_, MakeSlice(key), value);
+  } else if (write.is_delete()) {
+    return Status::NotFound(std::string(key) +
+                            " is not present in the transaction");
   } else {
-    Mutations::iterator iter(mutations_.find(key_string));
-    if (iter != mutations_.end()) {
-      *value = iter->second;
-      return Status::OK();
-    } else {
-      return db_->Get(read_options_, key_string, value);
-    }
+    value->assign(write.value().data(), write.value().size());
+    return Status::OK();
   }
 }
 
 void LevelDbTransaction::Delete(const absl::string_view& key) {
-  std::string to_delete(key);
-  deletions_.insert(to_delete);
-  mutations_.erase(to_delete);
+  writes_.Delete(key);
   version_++;
 }
 
 void LevelDbTransaction::Commit() {
+  // The WriteBatch reads the keys and values straight out of the buffer.
   WriteBatch batch;
-  for (auto it = deletions_.begin(); it != deletions_.end(); it++) {
-    batch.Delete(*it);
-  }
-
-  for (auto it = mutations_.begin(); it != mutations_.end(); it++) {
-    batch.Put(it->first, it->second);
+  WriteBuffer::Iterator it(&writes_);
+  for (it.SeekToFirst(); it.Valid(); it.Next()) {
+    if (it.is_delete()) {
+      batch.Delete(MakeSlice(it.key()));
+    } else {
+      batch.Put(MakeSlice(it.key()), MakeSlice(it.value()));
+    }
   }
 
   if (util::LogGetLevel() <= util::kLogLevelDebug) {
@@ -216,18 +242,24 @@ void LevelDbTransaction::Commit() {
 
 std::string LevelDbTransaction::ToString() {
   std::string dest("<LevelDbTransaction: ");
-  int64_t changes = deletions_.size() + mutations_.size();
+  int64_t changes = writes_.size();
   int64_t bytes = 0;  // accumulator for size of individual mutations.
   dest += std::to_string(changes) + " changes ";
   std::string items;  // accumulator for individual changes.
-  for (auto it = deletions_.begin(); it != deletions_.end(); it++) {
-    items += "\n  - Delete " + Describe(*it);
+  // List the deletions first, then the puts.
+  WriteBuffer::Iterator it(&writes_);
+  for (it.SeekToFirst(); it.Valid(); it.Next()) {
+    if (it.is_delete()) {
+      items += "\n  - Delete " + Describe(MakeSlice(it.key()));
+    }
   }
-  for (auto it = mutations_.begin(); it != mutations_.end(); it++) {
-    int64_t change_bytes = it->second.length();
-    bytes += change_bytes;
-    items += "\n  - Put " + Describe(it->first) + " (" +
-             std::to_string(change_bytes) + " bytes)";
+  for (it.SeekToFirst(); it.Valid(); it.Next()) {
+    if (!it.is_delete()) {
+      int64_t change_bytes = it.value().size();
+      bytes += change_bytes;
+      items += "\n  - Put " + Describe(MakeSlice(it.key())) + " (" +
+               std::to_string(change_bytes) + " bytes)";
+    }
   }
   dest += "(" + std::to_string(bytes) + " bytes):" + items + ">";
   return dest;
@@ -21,11 +21,10 @@
 #include <leveldb/db.h>
 
 #include <stdint.h>
-#include <map>
 #include <memory>
-#include <set>
 #include <string>
-#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/local/write_buffer.h"
 
 #if __OBJC__
 #import <Protobuf/GPBProtocolBuffers.h>
@@ -41,10 +40,22 @@ namespace local {
  * changes and committed values.
  */
 class LevelDbTransaction {
-  using Deletions = std::set<std::string>;
-  using Mutations = std::map<std::string, std::string>;
-
  public:
+  /**
+   * Options controlling how a Scan() reads from leveldb.
+   */
+  struct ScanOptions {
+    ScanOptions() : fill_cache(true) {
+    }
+
+    /**
+     * Whether the blocks leveldb reads for the scan should be kept in its
+     * cache. Turn this off for large one-off scans so that they don't evict
+     * the blocks in regular use.
+     */
+    bool fill_cache;
+  };
+
   /**
    * Iterator iterates over a merged view of pending changes from the
    * transaction and any unchanged values in the underlying leveldb instance.
@@ -62,7 +73,7 @@ class LevelDbTransaction {
      * Seeks this iterator to the first key equal to or greater than the given
      * key
      */
-    void Seek(const std::string& key);
+    void Seek(absl::string_view key);
 
     /**
      * Advances the iterator to the next entry
@@ -70,55 +81,56 @@ class LevelDbTransaction {
     void Next();
 
     /**
-     * Returns the key of the current entry
+     * Returns the key of the current entry. The view remains valid until the
+     * next call to Seek() or Next().
      */
     absl::string_view key();
 
     /**
-     * Returns the value of the current entry
+     * Returns the value of the current entry. The view remains valid until the
+     * next call to Seek() or Next().
      */
     absl::string_view value();
 
    private:
-    /**
-     * Advances to the next non-deleted key in leveldb.
-     */
-    void AdvanceLDB();
+    friend class LevelDbTransaction;
 
-    /**
-     * Returns true if the given slice matches a key present in the deletions_
-     * set.
-     */
-    bool IsDeleted(leveldb::Slice slice);
+    Iterator(LevelDbTransaction* txn,
+             const leveldb::ReadOptions& read_options,
+             absl::string_view limit);
 
     /**
      * Syncs with the underlying transaction. If the transaction has been
-     * updated, the mutation iterator may need to be reset. Returns true if this
-     * resulted in moving to a new underlying entry (i.e. the entry represented
-     * by current_ was deleted).
+     * updated, changes may have been written ahead of the current entry, so
+     * buffer_iter_ needs to be repositioned.
      */
-    bool SyncToTransaction();
+    void SyncToTransaction();
 
     /**
-     * Given the current state of the internal iterators, set is_valid_,
-     * is_mutation_, and current_.
+     * Given the current state of the internal iterators, skip past any
+     * deletions and set is_valid_, key_ and value_. Stops at limit_ without
+     * reading any further.
      */
     void UpdateCurrent();
 
     std::unique_ptr<leveldb::Iterator> db_iter_;
 
+    // The key at which iteration stops, or empty if it doesn't.
+    std::string limit_;
+
     // The last observed version of the underlying transaction
     int32_t last_version_;
     // The underlying transaction.
     LevelDbTransaction* txn_;
-    Mutations::iterator mutations_iter_;
-    // We save the current key and value so that once an iterator is Valid(), it
+    // The first pending change whose key is not less than the current key.
+    WriteBuffer::Iterator buffer_iter_;
+    // The key and value of the current entry. Once an iterator is Valid(), it
     // remains so at least until the next call to Seek() or Next(), even if the
-    // underlying data is deleted.
-    std::pair<std::string, std::string> current_;
-    // True if current_ represents an entry in the mutations_ map, rather than
-    // committed data.
-    bool is_mutation_;
+    // underlying data is deleted: committed entries are read from db_iter_,
+    // which doesn't see changes to the transaction, and pending ones from the
+    // WriteBuffer, which keeps everything written to it.
+    absl::string_view key_;
+    absl::string_view value_;
     // True if the iterator pointed to a valid entry the last time Next() or
     // Seek() was called.
     bool is_valid_;
@@ -156,9 +168,8 @@ class LevelDbTransaction {
    */
   void Put(const absl::string_view& key, GPBMessage* message) {
     NSData* data = [message data];
-    std::string key_string(key);
-    mutations_[key_string] = std::string((const char*)data.bytes, data.length);
-    version_++;
+    Put(key, absl::string_view{static_cast<const char*>(data.bytes),
+                               data.length});
   }
 #endif
 
@@ -182,6 +193,23 @@ class LevelDbTransaction {
    */
   std::unique_ptr<Iterator> NewIterator();
 
+  /**
+   * Returns a new Iterator over the entries whose keys start with the given
+   * prefix, positioned at the first of them. The iterator becomes invalid
+   * after the last one, without reading past it.
+   */
+  std::unique_ptr<Iterator> Scan(absl::string_view prefix,
+                                 const ScanOptions& options = ScanOptions());
+
+  /**
+   * Returns a new Iterator over the entries whose keys are in the range
+   * [start, limit), positioned at the first of them. An empty limit leaves the
+   * range unbounded.
+   */
+  std::unique_ptr<Iterator> Scan(absl::string_view start,
+                                 absl::string_view limit,
+                                 const ScanOptions& options = ScanOptions());
+
   /**
    * Commits the transaction. All pending changes are written. The transaction
    * should not be used after calling this method.
@@ -192,8 +220,8 @@ class LevelDbTransaction {
 
  private:
   leveldb::DB* db_;
-  Mutations mutations_;
-  Deletions deletions_;
+  // The pending changes, both puts and deletions.
+  WriteBuffer writes_;
   leveldb::ReadOptions read_options_;
   leveldb::WriteOptions write_options_;
   int32_t version_;
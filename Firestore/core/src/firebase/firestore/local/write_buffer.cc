@@ -0,0 +1,169 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/write_buffer.h"
+
+#include <string.h>
+
+#include <new>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A node of the skip list. Nodes are allocated with room for as many next
+ * pointers as their height, so next must be the last member.
+ */
+struct WriteBuffer::Node {
+  absl::string_view key;
+  absl::string_view value;
+  bool deleted;
+  Node* next[1];
+};
+
+constexpr int WriteBuffer::kMaxHeight;
+
+void WriteBuffer::Iterator::SeekToFirst() {
+  node_ = buffer_->head_->next[0];
+}
+
+void WriteBuffer::Iterator::Seek(absl::string_view key) {
+  node_ = buffer_->FindGreaterOrEqual(key, nullptr);
+}
+
+void WriteBuffer::Iterator::Next() {
+  FIREBASE_ASSERT_MESSAGE(Valid(), "Next() called on invalid iterator");
+  node_ = node_->next[0];
+}
+
+absl::string_view WriteBuffer::Iterator::key() const {
+  FIREBASE_ASSERT_MESSAGE(Valid(), "key() called on invalid iterator");
+  return node_->key;
+}
+
+absl::string_view WriteBuffer::Iterator::value() const {
+  FIREBASE_ASSERT_MESSAGE(Valid(), "value() called on invalid iterator");
+  return node_->value;
+}
+
+bool WriteBuffer::Iterator::is_delete() const {
+  FIREBASE_ASSERT_MESSAGE(Valid(), "is_delete() called on invalid iterator");
+  return node_->deleted;
+}
+
+WriteBuffer::WriteBuffer() : head_(NewNode(absl::string_view{}, kMaxHeight)) {
+}
+
+void WriteBuffer::Put(absl::string_view key, absl::string_view value) {
+  Node* node = FindOrInsert(key);
+  node->value = Copy(value);
+  node->deleted = false;
+}
+
+void WriteBuffer::Delete(absl::string_view key) {
+  Node* node = FindOrInsert(key);
+  node->value = absl::string_view{};
+  node->deleted = true;
+}
+
+WriteBuffer::Iterator WriteBuffer::Find(absl::string_view key) const {
+  Iterator result{this};
+  Node* node = FindGreaterOrEqual(key, nullptr);
+  if (node && node->key == key) {
+    result.node_ = node;
+  }
+  return result;
+}
+
+WriteBuffer::Node* WriteBuffer::FindOrInsert(absl::string_view key) {
+  Node* prev[kMaxHeight];
+  Node* node = FindGreaterOrEqual(key, prev);
+  if (node && node->key == key) {
+    return node;
+  }
+
+  int height = RandomHeight();
+  for (; height_ < height; height_++) {
+    prev[height_] = head_;
+  }
+
+  node = NewNode(Copy(key), height);
+  for (int level = 0; level < height; level++) {
+    node->next[level] = prev[level]->next[level];
+    prev[level]->next[level] = node;
+  }
+  size_++;
+  return node;
+}
+
+WriteBuffer::Node* WriteBuffer::FindGreaterOrEqual(absl::string_view key,
+                                                   Node** prev) const {
+  Node* node = head_;
+  int level = height_ - 1;
+  while (true) {
+    Node* next = node->next[level];
+    if (next && next->key < key) {
+      node = next;
+    } else {
+      if (prev) {
+        prev[level] = node;
+      }
+      if (level == 0) {
+        return next;
+      }
+      level--;
+    }
+  }
+}
+
+WriteBuffer::Node* WriteBuffer::NewNode(absl::string_view key, int height) {
+  size_t size = sizeof(Node) + sizeof(Node*) * (height - 1);
+  Node* node = new (arena_.Allocate(size, alignof(Node))) Node();
+  node->key = key;
+  for (int level = 0; level < height; level++) {
+    node->next[level] = nullptr;
+  }
+  return node;
+}
+
+absl::string_view WriteBuffer::Copy(absl::string_view bytes) {
+  if (bytes.empty()) {
+    return absl::string_view{};
+  }
+  auto data = static_cast<char*>(arena_.Allocate(bytes.size(), 1));
+  memcpy(data, bytes.data(), bytes.size());
+  return absl::string_view{data, bytes.size()};
+}
+
+int WriteBuffer::RandomHeight() {
+  // Each level holds about a quarter of the nodes of the one below it.
+  int height = 1;
+  while (height < kMaxHeight) {
+    random_ = static_cast<uint32_t>(uint64_t{random_} * 48271 % 2147483647);
+    if (random_ % 4 != 0) {
+      break;
+    }
+    height++;
+  }
+  return height;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_WRITE_BUFFER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_WRITE_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * WriteBuffer holds the pending writes of a LevelDbTransaction: for each key
+ * written, either the value it's to be set to or a deletion, ordered by key.
+ *
+ * The entries are kept in a skip list whose nodes, keys and values are all
+ * allocated in an Arena and never freed before the WriteBuffer itself. A key is
+ * only copied the first time it's written, and each value once, so that
+ * buffering a write costs a couple of copies into the arena rather than a few
+ * heap allocations. It also means that the keys and values returned by an
+ * Iterator stay valid as long as the WriteBuffer does, even if the entry is
+ * written again in the meantime.
+ *
+ * Inserting into the list doesn't move existing nodes, so an Iterator remains
+ * usable across writes, though it won't notice entries inserted before its
+ * current position.
+ */
+class WriteBuffer {
+ private:
+  struct Node;
+
+ public:
+  /**
+   * Iterates over the entries of a WriteBuffer in key order.
+   */
+  class Iterator {
+   public:
+    /** Creates an iterator over the given buffer, not yet pointing anywhere. */
+    explicit Iterator(const WriteBuffer* buffer) : buffer_(buffer) {
+    }
+
+    /** Returns true if this iterator points to an entry. */
+    bool Valid() const {
+      return node_ != nullptr;
+    }
+
+    /** Seeks to the first entry in the buffer. */
+    void SeekToFirst();
+
+    /** Seeks to the first entry whose key is not less than the given key. */
+    void Seek(absl::string_view key);
+
+    /** Advances to the next entry. */
+    void Next();
+
+    /** Returns the key of the current entry. */
+    absl::string_view key() const;
+
+    /**
+     * Returns the value the current entry's key is to be set to, or an empty
+     * string if the key is to be deleted.
+     */
+    absl::string_view value() const;
+
+    /** Returns true if the current entry's key is to be deleted. */
+    bool is_delete() const;
+
+   private:
+    friend class WriteBuffer;
+
+    const WriteBuffer* buffer_;
+    const Node* node_ = nullptr;
+  };
+
+  WriteBuffer();
+
+  WriteBuffer(const WriteBuffer& other) = delete;
+
+  WriteBuffer& operator=(const WriteBuffer& other) = delete;
+
+  /** Buffers setting the given key to the given value. */
+  void Put(absl::string_view key, absl::string_view value);
+
+  /** Buffers deleting the given key. */
+  void Delete(absl::string_view key);
+
+  /**
+   * Returns an iterator pointing to the entry with the given key, or an invalid
+   * one if the key hasn't been written.
+   */
+  Iterator Find(absl::string_view key) const;
+
+  /** Returns true if no keys have been written. */
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /** Returns the number of distinct keys written. */
+  size_t size() const {
+    return size_;
+  }
+
+  /** Returns the number of bytes of memory used to hold the entries. */
+  size_t bytes_allocated() const {
+    return arena_.bytes_allocated();
+  }
+
+ private:
+  static constexpr int kMaxHeight = 12;
+
+  /**
+   * Returns the node with the given key, inserting a new one for it if there
+   * isn't one already.
+   */
+  Node* FindOrInsert(absl::string_view key);
+
+  /**
+   * Returns the first node whose key is not less than the given key, or
+   * nullptr if there is none. If prev is not null, fills it in with the last
+   * node at each level whose key is less than the given key.
+   */
+  Node* FindGreaterOrEqual(absl::string_view key, Node** prev) const;
+
+  Node* NewNode(absl::string_view key, int height);
+
+  /** Copies the given bytes into the arena. */
+  absl::string_view Copy(absl::string_view bytes);
+
+  int RandomHeight();
+
+  util::Arena arena_;
+  Node* head_;
+  int height_ = 1;
+  size_t size_ = 0;
+  uint32_t random_ = 0xdeadbeef;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_WRITE_BUFFER_H_
@@ -17,14 +17,23 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_BASE_PATH_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_BASE_PATH_H_
 
+#include <stdint.h>
+
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/model/segment_pool.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/iterator_adaptors.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
 
 namespace firebase {
 namespace firestore {
@@ -38,6 +47,26 @@ namespace impl {
  * BasePath is reassignable and movable. Apart from those, all other mutating
  * operations return new independent instances.
  *
+ * ## Representation
+ *
+ * Paths are persistent: a path refers to a contiguous range of segments in
+ * storage that it shares with the paths derived from it. PopFirst() and
+ * PopLast() narrow the range without allocating, and copying a path only
+ * copies a reference to the storage.
+ *
+ * The storage has room to grow beyond the segments in use. The first path to
+ * Append() to the end of the segments in use claims the next free slots, so a
+ * chain of appends (e.g. collection, document, subcollection) fills a single
+ * buffer in place. Appending when those slots are already taken, or full,
+ * copies the path's segments into new storage with room to spare. Claims are
+ * atomic, so paths sharing storage may be used from multiple threads.
+ *
+ * The storage holds reference-counted handles to the segments rather than
+ * the segments themselves, so copying a path's segments into new storage
+ * doesn't copy any strings. While a SegmentPool is installed, new segments
+ * are interned in it, and equal segments in different paths are then usually
+ * the same object.
+ *
  * ## Subclassing Notes
  *
  * BasePath is strictly meant as a base class for concrete implementations. It
@@ -51,39 +80,43 @@ class BasePath {
  protected:
   using SegmentsT = std::vector<std::string>;
 
+ private:
+  /** A shared handle to a segment, which may be interned. */
+  using Segment = std::shared_ptr<const std::string>;
+
  public:
-  using const_iterator = SegmentsT::const_iterator;
+  using const_iterator = util::iterator_ptr<const Segment*>;
 
   /** Returns i-th segment of the path. */
   const std::string& operator[](const size_t i) const {
-    FIREBASE_ASSERT_MESSAGE(i < segments_.size(), "index %u out of range", i);
-    return segments_[i];
+    FIREBASE_ASSERT_MESSAGE(i < size(), "index %u out of range", i);
+    return *begin_[i];
   }
 
   /** Returns the first segment of the path. */
   const std::string& first_segment() const {
     FIREBASE_ASSERT_MESSAGE(!empty(),
                             "Cannot call first_segment on empty path");
-    return segments_[0];
+    return *begin_[0];
   }
   /** Returns the last segment of the path. */
   const std::string& last_segment() const {
     FIREBASE_ASSERT_MESSAGE(!empty(), "Cannot call last_segment on empty path");
-    return segments_[size() - 1];
+    return *end_[-1];
   }
 
   size_t size() const {
-    return segments_.size();
+    return static_cast<size_t>(end_ - begin_);
   }
   bool empty() const {
-    return segments_.empty();
+    return begin_ == end_;
   }
 
   const_iterator begin() const {
-    return segments_.begin();
+    return const_iterator{begin_};
   }
   const_iterator end() const {
-    return segments_.end();
+    return const_iterator{end_};
   }
 
   /**
@@ -91,14 +124,12 @@ class BasePath {
    * additional segment.
    */
   T Append(const std::string& segment) const {
-    auto appended = segments_;
-    appended.push_back(segment);
-    return T{std::move(appended)};
+    return Append(std::string{segment});
   }
   T Append(std::string&& segment) const {
-    auto appended = segments_;
-    appended.push_back(std::move(segment));
-    return T{std::move(appended)};
+    Segment handle = MakeSegment(std::move(segment));
+    return AppendRange(std::make_move_iterator(&handle),
+                       std::make_move_iterator(&handle + 1));
   }
 
   /**
@@ -106,9 +137,8 @@ class BasePath {
    * another path.
    */
   T Append(const T& path) const {
-    auto appended = segments_;
-    appended.insert(appended.end(), path.begin(), path.end());
-    return T{std::move(appended)};
+    const BasePath& other = path;
+    return AppendRange(other.begin_, other.end_);
   }
 
   /**
@@ -119,7 +149,13 @@ class BasePath {
     FIREBASE_ASSERT_MESSAGE(n <= size(),
                             "Cannot call PopFirst(%u) on path of length %u", n,
                             size());
-    return T{begin() + n, end()};
+    // Remove the first n segments' terms from the hash. The hash of the
+    // segments [0, n) is multiplied up once for each remaining segment.
+    uint64_t popped = ExtendHash(0, begin_, begin_ + n);
+    for (size_t i = n; i < size(); i++) {
+      popped *= kHashMultiplier;
+    }
+    return MakePath(storage_, begin_ + n, end_, hash_ - popped);
   }
 
   /**
@@ -128,7 +164,9 @@ class BasePath {
    */
   T PopLast() const {
     FIREBASE_ASSERT_MESSAGE(!empty(), "Cannot call PopLast() on empty path");
-    return T{begin(), end() - 1};
+    return MakePath(storage_, begin_, end_ - 1,
+                    (hash_ - HashSegment(last_segment())) *
+                        kHashMultiplierInverse);
   }
 
   /**
@@ -137,53 +175,290 @@ class BasePath {
    * Empty path is a prefix of any path. Any path is a prefix of itself.
    */
   bool IsPrefixOf(const T& rhs) const {
-    return size() <= rhs.size() && std::equal(begin(), end(), rhs.begin());
+    const BasePath& other = rhs;
+    return size() <= other.size() &&
+           (begin_ == other.begin_ ||
+            std::equal(begin_, end_, other.begin_, SegmentsEqual));
   }
 
   bool operator==(const BasePath& rhs) const {
-    return segments_ == rhs.segments_;
+    return size() == rhs.size() && hash_ == rhs.hash_ &&
+           (begin_ == rhs.begin_ ||
+            std::equal(begin_, end_, rhs.begin_, SegmentsEqual));
   }
   bool operator!=(const BasePath& rhs) const {
-    return segments_ != rhs.segments_;
+    return !(*this == rhs);
   }
   bool operator<(const BasePath& rhs) const {
-    return segments_ < rhs.segments_;
+    return std::lexicographical_compare(begin_, end_, rhs.begin_, rhs.end_,
+                                        SegmentLessThan);
   }
   bool operator>(const BasePath& rhs) const {
-    return segments_ > rhs.segments_;
+    return rhs < *this;
   }
   bool operator<=(const BasePath& rhs) const {
-    return segments_ <= rhs.segments_;
+    return !(rhs < *this);
   }
   bool operator>=(const BasePath& rhs) const {
-    return segments_ >= rhs.segments_;
+    return !(*this < rhs);
   }
 
-#if defined(__OBJC__)
-  // For Objective-C++ hash; to be removed after migration.
-  // Do NOT use in C++ code.
+  /**
+   * Returns a hash of the segments of this path. The hash is computed as the
+   * path is created, so this is O(1).
+   */
   uint64_t Hash() const {
-    std::hash<std::string> hash_fn;
-    uint64_t hash_result = 0;
-    for (const std::string& segment : segments_) {
-      hash_result = hash_result * 31u + hash_fn(segment);
+    return hash_;
+  }
+
+  /**
+   * Returns an estimate of the heap memory retained by this path, not counting
+   * the path object itself. This includes the storage the path shares and its
+   * cached canonical string, unless already recorded in counted (if not
+   * null).
+   *
+   * Segments appended to the storage by other paths after this one are not
+   * counted, since this path can't safely read them.
+   */
+  size_t HeapMemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    size_t result = 0;
+    std::shared_ptr<const std::string> canonical_string =
+        std::atomic_load(&canonical_string_);
+    if (canonical_string && util::CountOnce(canonical_string.get(), counted)) {
+      result += util::kSharedControlBlockSize + sizeof(std::string) +
+                util::StringMemoryUsage(*canonical_string);
+    }
+    if (!storage_ || !util::CountOnce(storage_.get(), counted)) {
+      return result;
     }
-    return hash_result;
+    result += sizeof(Segments) + util::kSharedControlBlockSize +
+              storage_->values.capacity() * sizeof(Segment);
+    for (const Segment* segment = storage_->values.data(); segment != end_;
+         ++segment) {
+      if (util::CountOnce(segment->get(), counted)) {
+        result += util::kSharedControlBlockSize + sizeof(std::string) +
+                  util::StringMemoryUsage(**segment);
+      }
+    }
+    return result;
   }
-#endif  // defined(__OBJC__)
 
  protected:
   BasePath() = default;
   template <typename IterT>
-  BasePath(const IterT begin, const IterT end) : segments_{begin, end} {
+  BasePath(const IterT begin, const IterT end)
+      : BasePath{SegmentsT(begin, end)} {
+  }
+  BasePath(std::initializer_list<std::string> list)
+      : BasePath{SegmentsT(list)} {
+  }
+  explicit BasePath(SegmentsT&& segments) {
+    if (!segments.empty()) {
+      size_t size = segments.size();
+      storage_ = std::make_shared<Segments>(size);
+      SegmentPool* pool = SegmentPool::GetDefault();
+      if (pool != nullptr) {
+        for (size_t i = 0; i < size; i++) {
+          storage_->values[i] = pool->Intern(std::move(segments[i]));
+        }
+      } else {
+        // Rather than allocating each segment a handle of its own, keep all
+        // of them in one shared block that the handles point into.
+        auto block = std::make_shared<const SegmentsT>(std::move(segments));
+        for (size_t i = 0; i < size; i++) {
+          storage_->values[i] = Segment{block, &(*block)[i]};
+        }
+      }
+      storage_->used.store(size, std::memory_order_relaxed);
+      begin_ = storage_->values.data();
+      end_ = begin_ + size;
+      hash_ = ExtendHash(0, begin_, end_);
+    }
+  }
+
+  // The canonical string may be cached concurrently with copying, since both
+  // only read the path as far as its users are concerned.
+  BasePath(const BasePath& other)
+      : storage_{other.storage_},
+        begin_{other.begin_},
+        end_{other.end_},
+        hash_{other.hash_},
+        canonical_string_{std::atomic_load(&other.canonical_string_)} {
+  }
+  BasePath(BasePath&& other) noexcept
+      : storage_{std::move(other.storage_)},
+        begin_{other.begin_},
+        end_{other.end_},
+        hash_{other.hash_},
+        canonical_string_{std::move(other.canonical_string_)} {
+    other.begin_ = nullptr;
+    other.end_ = nullptr;
+    other.hash_ = 0;
+  }
+
+  BasePath& operator=(const BasePath& other) {
+    if (this != &other) {
+      storage_ = other.storage_;
+      begin_ = other.begin_;
+      end_ = other.end_;
+      hash_ = other.hash_;
+      canonical_string_ = std::atomic_load(&other.canonical_string_);
+    }
+    return *this;
   }
-  BasePath(std::initializer_list<std::string> list) : segments_{list} {
+  BasePath& operator=(BasePath&& other) noexcept {
+    if (this != &other) {
+      storage_ = std::move(other.storage_);
+      begin_ = other.begin_;
+      end_ = other.end_;
+      hash_ = other.hash_;
+      canonical_string_ = std::move(other.canonical_string_);
+      other.begin_ = nullptr;
+      other.end_ = nullptr;
+      other.hash_ = 0;
+    }
+    return *this;
   }
-  explicit BasePath(SegmentsT&& segments) : segments_{std::move(segments)} {
+
+  /**
+   * Returns the canonical string form of this path, calling format to build
+   * it the first time. The string is cached, and shared with copies of this
+   * path.
+   *
+   * The reference is only valid while this path is alive and not assigned
+   * to, so public accessors should return a copy.
+   */
+  template <typename FormatT>
+  const std::string& CachedCanonicalString(const FormatT& format) const {
+    std::shared_ptr<const std::string> cached =
+        std::atomic_load(&canonical_string_);
+    if (!cached) {
+      auto formatted = std::make_shared<const std::string>(format());
+      // If another thread got there first, use its (identical) string, so
+      // that references already handed out remain valid.
+      if (std::atomic_compare_exchange_strong(&canonical_string_, &cached,
+                                              formatted)) {
+        cached = std::move(formatted);
+      }
+    }
+    // The cache is only ever replaced by assigning to this path, so the
+    // string outlives the local reference.
+    return *cached;
   }
 
  private:
-  SegmentsT segments_;
+  /**
+   * Segment storage shared between paths. The first `used` values are in use
+   * by paths and never change; the rest are free slots, empty until claimed.
+   */
+  struct Segments {
+    explicit Segments(size_t capacity) : values(capacity) {
+    }
+
+    std::vector<Segment> values;
+    std::atomic<size_t> used{0};
+  };
+
+  /**
+   * Returns a handle to the given segment, interned in the default
+   * SegmentPool if there is one.
+   */
+  static Segment MakeSegment(std::string&& segment) {
+    SegmentPool* pool = SegmentPool::GetDefault();
+    if (pool != nullptr) {
+      return pool->Intern(std::move(segment));
+    }
+    return std::make_shared<const std::string>(std::move(segment));
+  }
+
+  // Interned segments that are equal are usually the same object, in which
+  // case there's no need to compare their contents.
+  static bool SegmentsEqual(const Segment& lhs, const Segment& rhs) {
+    return lhs == rhs || *lhs == *rhs;
+  }
+  static bool SegmentLessThan(const Segment& lhs, const Segment& rhs) {
+    return lhs != rhs && *lhs < *rhs;
+  }
+
+  /**
+   * Paths are hashed as a polynomial in the hashes of their segments, i.e.
+   * hash = hash * kHashMultiplier + HashSegment(segment) for each segment in
+   * turn, with arithmetic modulo 2^64. Appending a segment then takes one
+   * step, and since the multiplier is odd it has an inverse modulo 2^64 that
+   * undoes a step when removing the last segment.
+   */
+  static constexpr uint64_t kHashMultiplier = 31;
+  static constexpr uint64_t kHashMultiplierInverse = 0xef7bdef7bdef7bdfULL;
+  static_assert(kHashMultiplier * kHashMultiplierInverse == 1,
+                "kHashMultiplierInverse must be the inverse of "
+                "kHashMultiplier modulo 2^64");
+
+  static uint64_t HashSegment(const std::string& segment) {
+    return std::hash<std::string>{}(segment);
+  }
+
+  /** Returns the given hash extended with the segments in [first, last). */
+  static uint64_t ExtendHash(uint64_t hash,
+                             const Segment* first,
+                             const Segment* last) {
+    for (; first != last; ++first) {
+      hash = hash * kHashMultiplier + HashSegment(**first);
+    }
+    return hash;
+  }
+
+  static T MakePath(std::shared_ptr<Segments> storage,
+                    const Segment* begin,
+                    const Segment* end,
+                    uint64_t hash) {
+    T result;
+    BasePath& base = result;
+    if (begin != end) {
+      base.storage_ = std::move(storage);
+      base.begin_ = begin;
+      base.end_ = end;
+      base.hash_ = hash;
+    }
+    return result;
+  }
+
+  /**
+   * Returns a new path which is this path followed by the segment handles in
+   * [first, last), appended in place if this path can claim the free slots
+   * after it, and copied into new storage otherwise.
+   */
+  template <typename IterT>
+  T AppendRange(IterT first, IterT last) const {
+    size_t count = static_cast<size_t>(std::distance(first, last));
+    if (storage_) {
+      size_t end_index = static_cast<size_t>(end_ - storage_->values.data());
+      size_t expected = end_index;
+      if (end_index + count <= storage_->values.size() &&
+          storage_->used.compare_exchange_strong(expected,
+                                                 end_index + count)) {
+        std::copy(first, last, storage_->values.begin() + end_index);
+        return MakePath(storage_, begin_, end_ + count,
+                        ExtendHash(hash_, end_, end_ + count));
+      }
+    }
+
+    // Leave room for as many segments again, so that appends to the new
+    // path can be made in place.
+    size_t size = this->size() + count;
+    auto storage = std::make_shared<Segments>(std::max<size_t>(size * 2, 4));
+    auto next = std::copy(begin_, end_, storage->values.begin());
+    std::copy(first, last, next);
+    storage->used.store(size, std::memory_order_relaxed);
+    const Segment* data = storage->values.data();
+    uint64_t hash = ExtendHash(hash_, data + this->size(), data + size);
+    return MakePath(std::move(storage), data, data + size, hash);
+  }
+
+  std::shared_ptr<Segments> storage_;
+  const Segment* begin_ = nullptr;
+  const Segment* end_ = nullptr;
+  uint64_t hash_ = 0;
+  mutable std::shared_ptr<const std::string> canonical_string_;
 };
 
 }  // namespace impl
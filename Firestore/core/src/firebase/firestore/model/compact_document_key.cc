@@ -0,0 +1,251 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/compact_document_key.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <new>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+/** Hashes the bytes of a segment with 64-bit FNV-1a. */
+uint64_t HashSegment(const char* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+CompactDocumentKey::CompactDocumentKey(const ResourcePath& path) {
+  FIREBASE_ASSERT_MESSAGE(DocumentKey::IsDocumentKey(path),
+                          "invalid document key path: %s",
+                          path.CanonicalString().c_str());
+  if (path.empty()) {
+    return;
+  }
+
+  size_t bytes_size = 0;
+  for (const std::string& segment : path) {
+    bytes_size += segment.size();
+  }
+  Rep* rep = Allocate(path.size(), bytes_size);
+  uint32_t* ends = rep->ends();
+  char* bytes = rep->bytes();
+  uint32_t end = 0;
+  for (const std::string& segment : path) {
+    memcpy(bytes + end, segment.data(), segment.size());
+    end += static_cast<uint32_t>(segment.size());
+    *ends++ = end;
+  }
+  *this = Finish(rep);
+}
+
+CompactDocumentKey CompactDocumentKey::FromPathString(
+    const absl::string_view path) {
+  FIREBASE_ASSERT_MESSAGE(
+      path.find("//") == std::string::npos,
+      "Invalid path (%s). Paths must not contain // in them.",
+      std::string{path.data(), path.data() + path.size()}.c_str());
+
+  // Leading and trailing slashes are allowed, as in ResourcePath, so the
+  // segments are the non-empty runs between slashes.
+  size_t segment_count = 0;
+  size_t bytes_size = 0;
+  for (size_t i = 0; i < path.size(); i++) {
+    if (path[i] != '/') {
+      segment_count += i == 0 || path[i - 1] == '/';
+      bytes_size++;
+    }
+  }
+  FIREBASE_ASSERT_MESSAGE(segment_count % 2 == 0,
+                          "invalid document key path: %s",
+                          std::string{path.data(), path.size()}.c_str());
+  if (segment_count == 0) {
+    return CompactDocumentKey{};
+  }
+
+  Rep* rep = Allocate(segment_count, bytes_size);
+  uint32_t* ends = rep->ends();
+  char* bytes = rep->bytes();
+  uint32_t end = 0;
+  for (size_t i = 0; i < path.size(); i++) {
+    if (path[i] != '/') {
+      bytes[end++] = path[i];
+      if (i + 1 == path.size() || path[i + 1] == '/') {
+        *ends++ = end;
+      }
+    }
+  }
+  return Finish(rep);
+}
+
+CompactDocumentKey::Rep* CompactDocumentKey::Allocate(size_t segment_count,
+                                                      size_t bytes_size) {
+  FIREBASE_ASSERT_MESSAGE(bytes_size <= std::numeric_limits<uint32_t>::max(),
+                          "Document key is too long");
+  void* memory = ::operator new(sizeof(Rep) + segment_count * sizeof(uint32_t) +
+                                bytes_size);
+  Rep* rep = new (memory) Rep;
+  rep->ref_count.store(1, std::memory_order_relaxed);
+  rep->segment_count = static_cast<uint32_t>(segment_count);
+  return rep;
+}
+
+CompactDocumentKey CompactDocumentKey::Finish(Rep* rep) {
+  const uint32_t* ends = rep->ends();
+  const char* bytes = rep->bytes();
+  uint64_t hash = 0;
+  uint32_t start = 0;
+  for (size_t i = 0; i < rep->segment_count; i++) {
+    hash = hash * 31 + HashSegment(bytes + start, ends[i] - start);
+    start = ends[i];
+  }
+  rep->hash = hash;
+  return CompactDocumentKey{rep};
+}
+
+void CompactDocumentKey::Release() {
+  if (rep_ && rep_->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    rep_->~Rep();
+    ::operator delete(const_cast<Rep*>(rep_));
+  }
+  rep_ = nullptr;
+}
+
+absl::string_view CompactDocumentKey::segment(size_t index) const {
+  FIREBASE_ASSERT_MESSAGE(index < size(), "index %zu out of range (size %zu)",
+                          index, size());
+  const uint32_t* ends = rep_->ends();
+  uint32_t start = index == 0 ? 0 : ends[index - 1];
+  return absl::string_view{rep_->bytes() + start, ends[index] - start};
+}
+
+DocumentKey CompactDocumentKey::ToDocumentKey() const {
+  std::vector<std::string> segments;
+  segments.reserve(size());
+  for (size_t i = 0; i < size(); i++) {
+    absl::string_view view = segment(i);
+    segments.emplace_back(view.data(), view.size());
+  }
+  return DocumentKey{ResourcePath{std::move(segments)}};
+}
+
+std::string CompactDocumentKey::CanonicalString() const {
+  std::string result;
+  if (!rep_) {
+    return result;
+  }
+  result.reserve(rep_->bytes_size() + size() - 1);
+  for (size_t i = 0; i < size(); i++) {
+    if (i > 0) {
+      result.push_back('/');
+    }
+    absl::string_view view = segment(i);
+    result.append(view.data(), view.size());
+  }
+  return result;
+}
+
+util::ComparisonResult CompactDocumentKey::CompareTo(
+    const CompactDocumentKey& other) const {
+  if (rep_ == other.rep_) {
+    return util::ComparisonResult::Same;
+  }
+
+  // Walk both keys' segments in step, straight from their storage.
+  size_t common = std::min(size(), other.size());
+  const uint32_t* lhs_ends = rep_ ? rep_->ends() : nullptr;
+  const uint32_t* rhs_ends = other.rep_ ? other.rep_->ends() : nullptr;
+  uint32_t lhs_start = 0;
+  uint32_t rhs_start = 0;
+  for (size_t i = 0; i < common; i++) {
+    absl::string_view lhs{rep_->bytes() + lhs_start, lhs_ends[i] - lhs_start};
+    absl::string_view rhs{other.rep_->bytes() + rhs_start,
+                          rhs_ends[i] - rhs_start};
+    int cmp = lhs.compare(rhs);
+    if (cmp != 0) {
+      return util::ComparisonResultFromInt(cmp);
+    }
+    lhs_start = lhs_ends[i];
+    rhs_start = rhs_ends[i];
+  }
+  if (size() != other.size()) {
+    return size() < other.size() ? util::ComparisonResult::Ascending
+                                 : util::ComparisonResult::Descending;
+  }
+  return util::ComparisonResult::Same;
+}
+
+size_t CompactDocumentKey::HeapMemoryUsage(
+    util::CountedAllocations* counted) const {
+  if (!rep_ || !util::CountOnce(rep_, counted)) {
+    return 0;
+  }
+  return sizeof(Rep) + rep_->segment_count * sizeof(uint32_t) +
+         rep_->bytes_size();
+}
+
+bool operator==(const CompactDocumentKey& lhs, const CompactDocumentKey& rhs) {
+  if (lhs.rep_ == rhs.rep_) {
+    return true;
+  }
+  if (lhs.Hash() != rhs.Hash() || lhs.size() != rhs.size()) {
+    return false;
+  }
+  // Equal segment counts and contents imply equal end offsets, so comparing
+  // the table and then the bytes compares the segments.
+  size_t segment_count = lhs.size();
+  return memcmp(lhs.rep_->ends(), rhs.rep_->ends(),
+                segment_count * sizeof(uint32_t)) == 0 &&
+         memcmp(lhs.rep_->bytes(), rhs.rep_->bytes(),
+                lhs.rep_->bytes_size()) == 0;
+}
+
+void CompactDocumentKey::Builder::EndSegment() {
+  FIREBASE_ASSERT_MESSAGE(bytes_.size() <= std::numeric_limits<uint32_t>::max(),
+                          "Document key is too long");
+  ends_.push_back(static_cast<uint32_t>(bytes_.size()));
+}
+
+CompactDocumentKey CompactDocumentKey::Builder::Build() const {
+  FIREBASE_ASSERT_MESSAGE(ends_.size() % 2 == 0,
+                          "invalid document key path with %zu segments",
+                          ends_.size());
+  if (ends_.empty()) {
+    return CompactDocumentKey{};
+  }
+  Rep* rep = Allocate(ends_.size(), bytes_.size());
+  memcpy(rep->ends(), ends_.data(), ends_.size() * sizeof(uint32_t));
+  memcpy(rep->bytes(), bytes_.data(), bytes_.size());
+  return Finish(rep);
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_COMPACT_DOCUMENT_KEY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_COMPACT_DOCUMENT_KEY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * A document key stored in a single allocation: a header, a table with the
+ * end offset of each segment, and the bytes of all the segments back to back.
+ * Keys are compared segment by segment in place, without building strings.
+ *
+ * CompactDocumentKey is meant for collections that hold very many keys, where
+ * a DocumentKey (a shared ResourcePath holding a string per segment) costs
+ * several allocations per key. It orders keys the same way DocumentKey does,
+ * and converts to and from it. Like DocumentKey, copies share the same
+ * immutable storage.
+ */
+class CompactDocumentKey {
+ public:
+  class Builder;
+
+  /** Creates an empty key, which takes up no heap memory. */
+  CompactDocumentKey() = default;
+
+  /** Creates a key with the same segments as the given path. */
+  explicit CompactDocumentKey(const ResourcePath& path);
+
+  /** Creates a key with the same segments as the given key. */
+  explicit CompactDocumentKey(const DocumentKey& key)
+      : CompactDocumentKey(key.path()) {
+  }
+
+  /**
+   * Creates and returns a new key using '/' to split the string into
+   * segments.
+   */
+  static CompactDocumentKey FromPathString(absl::string_view path);
+
+  CompactDocumentKey(const CompactDocumentKey& other) : rep_{other.rep_} {
+    Retain();
+  }
+
+  CompactDocumentKey(CompactDocumentKey&& other) noexcept : rep_{other.rep_} {
+    other.rep_ = nullptr;
+  }
+
+  CompactDocumentKey& operator=(CompactDocumentKey other) noexcept {
+    std::swap(rep_, other.rep_);
+    return *this;
+  }
+
+  ~CompactDocumentKey() {
+    Release();
+  }
+
+  /** Returns the number of segments in the key. */
+  size_t size() const {
+    return rep_ ? rep_->segment_count : 0;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /** Returns the segment at the given index, which must be in range. */
+  absl::string_view segment(size_t index) const;
+
+  absl::string_view operator[](size_t index) const {
+    return segment(index);
+  }
+
+  /** Converts this key back to a DocumentKey. */
+  DocumentKey ToDocumentKey() const;
+
+  /** Returns the segments joined with '/', like ResourcePath does. */
+  std::string CanonicalString() const;
+
+  util::ComparisonResult CompareTo(const CompactDocumentKey& other) const;
+
+  /**
+   * Returns the hash of this key, computed once when the key is built. It is
+   * unrelated to the hash of the equivalent DocumentKey.
+   */
+  uint64_t Hash() const {
+    return rep_ ? rep_->hash : 0;
+  }
+
+  /**
+   * Returns the heap memory owned by this key (which it shares with its
+   * copies), not counting the key object itself.
+   *
+   * @param counted If not null, the key's storage is only counted if it isn't
+   *     already in this set, and is then added to it.
+   */
+  size_t HeapMemoryUsage(util::CountedAllocations* counted = nullptr) const;
+
+  friend bool operator==(const CompactDocumentKey& lhs,
+                         const CompactDocumentKey& rhs);
+
+ private:
+  /**
+   * The header of a key's storage. It is followed by segment_count uint32_t
+   * end offsets, and then by the bytes of the segments.
+   */
+  struct Rep {
+    mutable std::atomic<uint32_t> ref_count;
+    uint32_t segment_count;
+    uint64_t hash;
+
+    const uint32_t* ends() const {
+      return reinterpret_cast<const uint32_t*>(this + 1);
+    }
+    uint32_t* ends() {
+      return reinterpret_cast<uint32_t*>(this + 1);
+    }
+    const char* bytes() const {
+      return reinterpret_cast<const char*>(ends() + segment_count);
+    }
+    char* bytes() {
+      return reinterpret_cast<char*>(ends() + segment_count);
+    }
+    size_t bytes_size() const {
+      return segment_count == 0 ? 0 : ends()[segment_count - 1];
+    }
+  };
+
+  explicit CompactDocumentKey(const Rep* rep) : rep_{rep} {
+  }
+
+  /**
+   * Allocates storage for a key with the given number of segments and bytes,
+   * for the caller to fill in and then pass to Finish().
+   */
+  static Rep* Allocate(size_t segment_count, size_t bytes_size);
+
+  /** Hashes the filled in storage and returns a key that owns it. */
+  static CompactDocumentKey Finish(Rep* rep);
+
+  void Retain() const {
+    if (rep_) {
+      rep_->ref_count.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void Release();
+
+  const Rep* rep_ = nullptr;
+};
+
+/**
+ * Builds a CompactDocumentKey one segment at a time, e.g. while decoding a key
+ * from its LevelDB form. The segments' bytes are written straight into one
+ * buffer, so that none of them need a string of its own.
+ */
+class CompactDocumentKey::Builder {
+ public:
+  /** Adds a segment to the key. */
+  void AppendSegment(absl::string_view segment) {
+    bytes_.append(segment.data(), segment.size());
+    EndSegment();
+  }
+
+  /**
+   * Returns the buffer that holds the bytes of all the segments so far. To
+   * add a segment, append its bytes here, then call EndSegment().
+   */
+  std::string* bytes() {
+    return &bytes_;
+  }
+
+  /** Ends the segment whose bytes were appended to bytes(). */
+  void EndSegment();
+
+  /** Returns the number of segments added so far. */
+  size_t size() const {
+    return ends_.size();
+  }
+
+  /**
+   * Returns the key built from the segments added so far, which must be a
+   * valid document key (see DocumentKey::IsDocumentKey()).
+   */
+  CompactDocumentKey Build() const;
+
+ private:
+  std::string bytes_;
+  std::vector<uint32_t> ends_;
+};
+
+inline bool operator!=(const CompactDocumentKey& lhs,
+                       const CompactDocumentKey& rhs) {
+  return !(lhs == rhs);
+}
+inline bool operator<(const CompactDocumentKey& lhs,
+                      const CompactDocumentKey& rhs) {
+  return lhs.CompareTo(rhs) == util::ComparisonResult::Ascending;
+}
+inline bool operator<=(const CompactDocumentKey& lhs,
+                       const CompactDocumentKey& rhs) {
+  return lhs.CompareTo(rhs) != util::ComparisonResult::Descending;
+}
+inline bool operator>(const CompactDocumentKey& lhs,
+                      const CompactDocumentKey& rhs) {
+  return lhs.CompareTo(rhs) == util::ComparisonResult::Descending;
+}
+inline bool operator>=(const CompactDocumentKey& lhs,
+                       const CompactDocumentKey& rhs) {
+  return lhs.CompareTo(rhs) != util::ComparisonResult::Ascending;
+}
+
+/** A hash function for CompactDocumentKeys, for use in unordered containers. */
+struct HashCompactDocumentKey {
+  size_t operator()(const CompactDocumentKey& key) const {
+    return static_cast<size_t>(key.Hash());
+  }
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_COMPACT_DOCUMENT_KEY_H_
@@ -19,6 +19,8 @@
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "Firestore/core/src/firebase/firestore/util/wire_size.h"
 
 namespace firebase {
 namespace firestore {
@@ -35,6 +37,42 @@ Document::Document(FieldValue&& data,
   FIREBASE_ASSERT(FieldValue::Type::Object == data.type());
 }
 
+size_t Document::Hash() const {
+  size_t hash = MaybeDocument::Hash();
+  hash = util::HashCombine(hash, has_local_mutations_ ? 1 : 0);
+  return util::HashCombine(hash, data_.Hash());
+}
+
+size_t Document::ByteSize(const DatabaseId& database_id) const {
+  // Field numbers in google.firestore.v1beta1.Document.
+  enum : uint32_t {
+    kName = 1,
+    kFields = 2,
+    kUpdateTime = 4,
+
+    // Document.FieldsEntry.key and Document.FieldsEntry.value
+    kEntryKey = 1,
+    kEntryValue = 2,
+  };
+
+  size_t size = util::LengthDelimitedFieldSize(
+      kName, key().ResourceNameSize(database_id));
+  for (const auto& kv : data_.object_value()) {
+    size_t entry_size =
+        util::LengthDelimitedFieldSize(kEntryKey, kv.first.size()) +
+        util::LengthDelimitedFieldSize(kEntryValue, kv.second.ByteSize());
+    size += util::LengthDelimitedFieldSize(kFields, entry_size);
+  }
+  size_t update_time_size = version().timestamp().ByteSize();
+  return size + util::LengthDelimitedFieldSize(kUpdateTime, update_time_size);
+}
+
+size_t Document::MemoryUsageImpl(util::CountedAllocations* counted) const {
+  // data_ counts itself as well as what it retains.
+  return sizeof(Document) - sizeof(FieldValue) + data_.MemoryUsage(counted) +
+         key().HeapMemoryUsage(counted);
+}
+
 bool Document::Equals(const MaybeDocument& other) const {
   if (other.type() != Type::Document) {
     return false;
@@ -46,9 +46,19 @@ class Document : public MaybeDocument {
     return has_local_mutations_;
   }
 
+  /**
+   * Returns a hash of this document that is consistent with operator==. The
+   * hash of the document's data is cached, so rehashing is cheap.
+   */
+  size_t Hash() const override;
+
+  size_t ByteSize(const DatabaseId& database_id) const override;
+
  protected:
   bool Equals(const MaybeDocument& other) const override;
 
+  size_t MemoryUsageImpl(util::CountedAllocations* counted) const override;
+
  private:
   FieldValue data_;  // This is of type Object.
   bool has_local_mutations_;
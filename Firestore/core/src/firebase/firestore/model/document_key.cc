@@ -49,6 +49,24 @@ const DocumentKey& DocumentKey::Empty() {
   return empty;
 }
 
+size_t DocumentKey::ResourceNameSize(const DatabaseId& database_id) const {
+  // "projects/", "/databases/" and "/documents", then "/" and each segment.
+  size_t result = 9 + database_id.project_id().size() + 11 +
+                  database_id.database_id().size() + 10;
+  for (const std::string& segment : path()) {
+    result += 1 + segment.size();
+  }
+  return result;
+}
+
+size_t DocumentKey::HeapMemoryUsage(util::CountedAllocations* counted) const {
+  if (!path_ || !util::CountOnce(path_.get(), counted)) {
+    return 0;
+  }
+  return sizeof(ResourcePath) + util::kSharedControlBlockSize +
+         path_->HeapMemoryUsage(counted);
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
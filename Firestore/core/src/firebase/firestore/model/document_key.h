@@ -25,7 +25,9 @@
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #endif  // defined(__OBJC__)
 
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
 #include "absl/strings/string_view.h"
 
 namespace firebase {
@@ -87,6 +89,22 @@ class DocumentKey {
     return path_ ? *path_ : Empty().path();
   }
 
+  /**
+   * Returns the length of the fully qualified resource name of this key in the
+   * given database, i.e.
+   * "projects/{project_id}/databases/{database_id}/documents/{path}".
+   */
+  size_t ResourceNameSize(const DatabaseId& database_id) const;
+
+  /**
+   * Returns an estimate of the heap memory owned by this key (which it shares
+   * with its copies), not counting the key object itself.
+   *
+   * @param counted If not null, the key's path is only counted if it isn't
+   *     already in this set, and is then added to it.
+   */
+  size_t HeapMemoryUsage(util::CountedAllocations* counted = nullptr) const;
+
  private:
   // This is an optimization to make passing DocumentKey around cheaper (it's
   // copied often).
@@ -112,6 +130,13 @@ inline bool operator>=(const DocumentKey& lhs, const DocumentKey& rhs) {
   return lhs.path() >= rhs.path();
 }
 
+/** A hash function for DocumentKeys, for use in unordered containers. */
+struct HashDocumentKey {
+  size_t operator()(const DocumentKey& key) const {
+    return static_cast<size_t>(key.path().Hash());
+  }
+};
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/document_size_counter.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+void DocumentSizeCounter::Add(const MaybeDocument& document) {
+  Remove(document.key());
+  Sizes sizes{document.MemoryUsage(), document.ByteSize(*database_id_)};
+  sizes_.emplace(document.key(), sizes);
+  memory_usage_ += sizes.memory_usage;
+  byte_size_ += sizes.byte_size;
+}
+
+void DocumentSizeCounter::Remove(const DocumentKey& key) {
+  auto found = sizes_.find(key);
+  if (found == sizes_.end()) {
+    return;
+  }
+  memory_usage_ -= found->second.memory_usage;
+  byte_size_ -= found->second.byte_size;
+  sizes_.erase(found);
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_SIZE_COUNTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_SIZE_COUNTER_H_
+
+#include <stddef.h>
+
+#include <unordered_map>
+
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * Keeps running totals of the sizes of a collection of documents, such as the
+ * contents of a cache, so that the collection can be held to a budget in bytes
+ * rather than in documents.
+ *
+ * Each document is measured on its own as it is added, so any storage shared
+ * between documents is counted once for each of them. The sizes are recorded
+ * by key, so removing a document subtracts exactly what adding it added.
+ */
+class DocumentSizeCounter {
+ public:
+  /**
+   * Creates a counter for documents in the given database, which is used to
+   * size their names. The database_id must outlive the counter.
+   */
+  explicit DocumentSizeCounter(const DatabaseId* database_id)
+      : database_id_(database_id) {
+  }
+
+  /**
+   * Adds the given document to the totals, replacing any document with the
+   * same key that was added before.
+   */
+  void Add(const MaybeDocument& document);
+
+  /**
+   * Removes the document with the given key from the totals. Does nothing if
+   * no document with that key has been added.
+   */
+  void Remove(const DocumentKey& key);
+
+  /** Returns the number of documents counted. */
+  size_t document_count() const {
+    return sizes_.size();
+  }
+
+  /** Returns the total of the documents' MaybeDocument::MemoryUsage(). */
+  size_t memory_usage() const {
+    return memory_usage_;
+  }
+
+  /** Returns the total of the documents' MaybeDocument::ByteSize(). */
+  size_t byte_size() const {
+    return byte_size_;
+  }
+
+ private:
+  /** The sizes of a document, as measured when it was added. */
+  struct Sizes {
+    size_t memory_usage;
+    size_t byte_size;
+  };
+
+  const DatabaseId* database_id_;
+  std::unordered_map<DocumentKey, Sizes, HashDocumentKey> sizes_;
+  size_t memory_usage_ = 0;
+  size_t byte_size_ = 0;
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_SIZE_COUNTER_H_
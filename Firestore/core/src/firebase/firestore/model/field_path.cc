@@ -18,11 +18,9 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
-#include "absl/strings/str_join.h"
-#include "absl/strings/str_replace.h"
-#include "absl/strings/str_split.h"
 
 namespace firebase {
 namespace firestore {
@@ -34,7 +32,7 @@ namespace {
  * True if the string could be used as a segment in a field path without
  * escaping. Valid identifies follow the regex [a-zA-Z_][a-zA-Z0-9_]*
  */
-bool IsValidIdentifier(const std::string& segment) {
+bool IsValidIdentifier(const absl::string_view segment) {
   if (segment.empty()) {
     return false;
   }
@@ -59,6 +57,55 @@ bool IsValidIdentifier(const std::string& segment) {
   return true;
 }
 
+// string_view doesn't have a c_str() method, because it might not be
+// null-terminated. Assertions expect C strings, so construct std::string on
+// the fly, so that c_str() might be called on it.
+std::string ToString(const absl::string_view view) {
+  return std::string{view.data(), view.data() + view.size()};
+}
+
+/**
+ * Splits a path that has no backticks, escapes or nulls at its dots, which
+ * is all there is to parsing one. Most paths are like this.
+ */
+std::vector<std::string> SplitUnescaped(const absl::string_view path) {
+  std::vector<std::string> segments;
+  segments.reserve(std::count(path.begin(), path.end(), '.') + 1);
+  size_t start = 0;
+  while (true) {
+    size_t end = path.find('.', start);
+    if (end == absl::string_view::npos) {
+      end = path.size();
+    }
+    FIREBASE_ASSERT_MESSAGE(
+        end > start,
+        "Invalid field path (%s). Paths must not be empty, begin with "
+        "'.', end with '.', or contain '..'",
+        ToString(path).c_str());
+    segments.emplace_back(path.data() + start, end - start);
+    if (end == path.size()) {
+      return segments;
+    }
+    start = end + 1;
+  }
+}
+
+/** Appends the given segment to out, escaping it if necessary. */
+void AppendEscaped(const std::string& segment, std::string* out) {
+  if (IsValidIdentifier(segment)) {
+    out->append(segment);
+    return;
+  }
+  out->push_back('`');
+  for (char c : segment) {
+    if (c == '\\' || c == '`') {
+      out->push_back('\\');
+    }
+    out->push_back(c);
+  }
+  out->push_back('`');
+}
+
 }  // namespace
 
 FieldPath FieldPath::FromServerFormat(const absl::string_view path) {
@@ -67,22 +114,21 @@ FieldPath FieldPath::FromServerFormat(const absl::string_view path) {
   // aren't escaped. Technically, this will mangle paths with backticks in
   // them used in v1alpha1, but that's fine.
 
+  if (path.find_first_of(absl::string_view{"`\\\0", 3}) ==
+      absl::string_view::npos) {
+    return FieldPath{SplitUnescaped(path)};
+  }
+
   SegmentsT segments;
   std::string segment;
   segment.reserve(path.size());
 
-  // string_view doesn't have a c_str() method, because it might not be
-  // null-terminated. Assertions expect C strings, so construct std::string on
-  // the fly, so that c_str() might be called on it.
-  const auto to_string = [](const absl::string_view view) {
-    return std::string{view.data(), view.data() + view.size()};
-  };
-  const auto finish_segment = [&segments, &segment, &path, &to_string] {
+  const auto finish_segment = [&segments, &segment, &path] {
     FIREBASE_ASSERT_MESSAGE(
         !segment.empty(),
         "Invalid field path (%s). Paths must not be empty, begin with "
         "'.', end with '.', or contain '..'",
-        to_string(path).c_str());
+        ToString(path).c_str());
     // Move operation will clear segment, but capacity will remain the same
     // (not, strictly speaking, required by the standard, but true in practice).
     segments.push_back(std::move(segment));
@@ -118,7 +164,7 @@ FieldPath FieldPath::FromServerFormat(const absl::string_view path) {
         // finalize field escaping.
         FIREBASE_ASSERT_MESSAGE(i + 1 != path.size(),
                                 "Trailing escape characters not allowed in %s",
-                                to_string(path).c_str());
+                                ToString(path).c_str());
         ++i;
         segment += path[i];
         break;
@@ -132,7 +178,7 @@ FieldPath FieldPath::FromServerFormat(const absl::string_view path) {
   finish_segment();
 
   FIREBASE_ASSERT_MESSAGE(!inside_backticks, "Unterminated ` in path %s",
-                          to_string(path).c_str());
+                          ToString(path).c_str());
 
   return FieldPath{std::move(segments)};
 }
@@ -152,20 +198,21 @@ bool FieldPath::IsKeyFieldPath() const {
 }
 
 std::string FieldPath::CanonicalString() const {
-  const auto escaped_segment = [](const std::string& segment) {
-    auto escaped = absl::StrReplaceAll(segment, {{"\\", "\\\\"}, {"`", "\\`"}});
-    const bool needs_escaping = !IsValidIdentifier(escaped);
-    if (needs_escaping) {
-      escaped.insert(escaped.begin(), '`');
-      escaped.push_back('`');
+  return CachedCanonicalString([this] {
+    size_t size = 0;
+    for (const std::string& segment : *this) {
+      size += segment.size() + 1;
     }
-    return escaped;
-  };
-  return absl::StrJoin(
-      begin(), end(), ".",
-      [escaped_segment](std::string* out, const std::string& segment) {
-        out->append(escaped_segment(segment));
-      });
+    std::string result;
+    result.reserve(size);
+    for (const std::string& segment : *this) {
+      if (!result.empty()) {
+        result.push_back('.');
+      }
+      AppendEscaped(segment, &result);
+    }
+    return result;
+  });
 }
 
 }  // namespace model
@@ -62,7 +62,10 @@ class FieldPath : public impl::BasePath<FieldPath> {
   /** Returns a field path that represents a document key. */
   static const FieldPath& KeyFieldPath();
 
-  /** Returns a standardized string representation of this path. */
+  /**
+   * Returns a standardized string representation of this path. The string is
+   * built on first use and cached, so later calls only copy it.
+   */
   std::string CanonicalString() const;
   /** True if this FieldPath represents a document key. */
   bool IsKeyFieldPath() const;
@@ -87,6 +90,13 @@ class FieldPath : public impl::BasePath<FieldPath> {
   }
 };
 
+/** A hash function for FieldPaths, for use in unordered containers. */
+struct HashFieldPath {
+  size_t operator()(const FieldPath& path) const {
+    return static_cast<size_t>(path.Hash());
+  }
+};
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
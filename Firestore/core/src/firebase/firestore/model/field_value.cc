@@ -17,16 +17,22 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <math.h>
+#include <string.h>
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
-
-using firebase::firestore::util::Comparator;
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "Firestore/core/src/firebase/firestore/util/wire_size.h"
 
 namespace firebase {
 namespace firestore {
@@ -34,6 +40,7 @@ namespace model {
 
 using Type = FieldValue::Type;
 using firebase::firestore::util::ComparisonResult;
+using firebase::firestore::util::HashCombine;
 
 namespace {
 /**
@@ -56,8 +63,128 @@ bool Comparable(Type lhs, Type rhs) {
   }
 }
 
+bool IsNumber(Type type) {
+  return type == Type::Integer || type == Type::Double;
+}
+
+/** Performs a three-way comparison of two values using only operator<. */
+template <typename T>
+ComparisonResult CompareWithLessThan(const T& lhs, const T& rhs) {
+  if (lhs < rhs) {
+    return ComparisonResult::Ascending;
+  } else if (rhs < lhs) {
+    return ComparisonResult::Descending;
+  } else {
+    return ComparisonResult::Same;
+  }
+}
+
+/**
+ * Hashes a numeric value such that a double holding an integral value hashes
+ * the same as the equal integer (and -0.0 the same as 0), since Equals()
+ * considers those to be equal.
+ */
+size_t HashNumber(double value) {
+  // -2^63 and 2^63 are exactly representable; doubles in between convert to
+  // int64_t without overflow.
+  const double kMinInt64 = -9223372036854775808.0;
+  if (value >= kMinInt64 && value < -kMinInt64 && value == floor(value)) {
+    return std::hash<int64_t>()(static_cast<int64_t>(value));
+  }
+  return util::DoubleBitwiseHash(value);
+}
+
+size_t HashNumber(int64_t value) {
+  return std::hash<int64_t>()(value);
+}
+
+/** Mixes the given bytes into a running hash, eight at a time. */
+size_t HashBytes(size_t seed, const uint8_t* data, size_t size) {
+  size_t hash = HashCombine(seed, size);
+  while (size >= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    hash = HashCombine(hash, word);
+    data += sizeof(word);
+    size -= sizeof(word);
+  }
+  if (size > 0) {
+    uint64_t tail = 0;
+    memcpy(&tail, data, size);
+    hash = HashCombine(hash, tail);
+  }
+  return hash;
+}
+
+size_t HashTimestamp(const Timestamp& value) {
+  return HashCombine(std::hash<int64_t>()(value.seconds()),
+                     std::hash<int32_t>()(value.nanos()));
+}
+
+/**
+ * Returns false only if both hashes have already been computed and differ, in
+ * which case the values they belong to cannot be equal.
+ */
+bool MaybeEqualHashes(const std::atomic<size_t>& lhs,
+                      const std::atomic<size_t>& rhs) {
+  size_t lhs_hash = lhs.load(std::memory_order_relaxed);
+  size_t rhs_hash = rhs.load(std::memory_order_relaxed);
+  return lhs_hash == 0 || rhs_hash == 0 || lhs_hash == rhs_hash;
+}
+
+/**
+ * Stores a freshly computed container hash in its cache, reserving zero to
+ * mean "not yet computed". Concurrent callers compute the same hash, so the
+ * race between them is benign.
+ */
+size_t CacheHash(std::atomic<size_t>* cache, size_t hash) {
+  if (hash == 0) {
+    hash = 1;
+  }
+  cache->store(hash, std::memory_order_relaxed);
+  return hash;
+}
+
+bool EntryLess(const std::pair<std::string, FieldValue>& lhs,
+               const std::pair<std::string, FieldValue>& rhs) {
+  return lhs.first < rhs.first;
+}
+
+/**
+ * Returns a copy of the given fields with the named field set to the given
+ * value, sharing all the other fields.
+ */
+FieldValue::Map SetField(const FieldValue::Map& fields,
+                         const std::string& name,
+                         const FieldValue& value) {
+  // Map::insert() leaves the map as it is if the field already has a value
+  // equal to the new one. For FieldValues, finding that out can mean walking
+  // both values, and Integer 1 would be kept in place of Double 1.0 since they
+  // are equal. So any existing field is removed first. The Builder copies an
+  // array-backed map only once for both changes.
+  FieldValue::Map::Builder builder{fields};
+  builder.erase(name);
+  builder.insert(name, value);
+  return builder.Build();
+}
+
 }  // namespace
 
+const std::shared_ptr<const FieldValue::ArrayContents>&
+FieldValue::EmptyArray() {
+  // Shared by default-initialized arrays so that they need not allocate.
+  static const std::shared_ptr<const ArrayContents> kEmptyArray =
+      std::make_shared<const ArrayContents>();
+  return kEmptyArray;
+}
+
+const std::shared_ptr<const FieldValue::ObjectContents>&
+FieldValue::EmptyObject() {
+  static const std::shared_ptr<const ObjectContents> kEmptyObject =
+      std::make_shared<const ObjectContents>();
+  return kEmptyObject;
+}
+
 FieldValue::FieldValue(const FieldValue& value) {
   *this = value;
 }
@@ -93,30 +220,23 @@ FieldValue& FieldValue::operator=(const FieldValue& value) {
     case Type::String:
       string_value_ = value.string_value_;
       break;
-    case Type::Blob: {
-      // copy-and-swap
-      std::vector<uint8_t> tmp = value.blob_value_;
-      std::swap(blob_value_, tmp);
+    case Type::Blob:
+      // The bytes are immutable so sharing them is safe.
+      blob_value_ = value.blob_value_;
       break;
-    }
     case Type::Reference:
       reference_value_ = value.reference_value_;
       break;
     case Type::GeoPoint:
       geo_point_value_ = value.geo_point_value_;
       break;
-    case Type::Array: {
-      // copy-and-swap
-      std::vector<FieldValue> tmp = value.array_value_;
-      std::swap(array_value_, tmp);
+    case Type::Array:
+      // The contents are immutable so sharing them is safe.
+      array_value_ = value.array_value_;
       break;
-    }
-    case Type::Object: {
-      // copy-and-swap
-      std::map<std::string, FieldValue> tmp = value.object_value_;
-      std::swap(object_value_, tmp);
+    case Type::Object:
+      object_value_ = value.object_value_;
       break;
-    }
     default:
       FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
           false, lhs.type(), "Unsupported type %d", value.type());
@@ -234,10 +354,13 @@ FieldValue FieldValue::StringValue(std::string&& value) {
 }
 
 FieldValue FieldValue::BlobValue(const uint8_t* source, size_t size) {
+  return BlobValue(util::SharedBytes{source, size});
+}
+
+FieldValue FieldValue::BlobValue(util::SharedBytes value) {
   FieldValue result;
   result.SwitchTo(Type::Blob);
-  std::vector<uint8_t> copy(source, source + size);
-  std::swap(result.blob_value_, copy);
+  std::swap(result.blob_value_, value);
   return result;
 }
 
@@ -276,84 +399,503 @@ FieldValue FieldValue::ArrayValue(const std::vector<FieldValue>& value) {
 FieldValue FieldValue::ArrayValue(std::vector<FieldValue>&& value) {
   FieldValue result;
   result.SwitchTo(Type::Array);
-  std::swap(result.array_value_, value);
+  result.array_value_ = std::make_shared<const ArrayContents>(std::move(value));
   return result;
 }
 
 FieldValue FieldValue::ObjectValue(
     const std::map<std::string, FieldValue>& value) {
-  std::map<std::string, FieldValue> copy(value);
-  return ObjectValue(std::move(copy));
+  // std::map is already sorted by key.
+  return FromSortedMap(Map::FromSorted(value.begin(), value.end()));
 }
 
 FieldValue FieldValue::ObjectValue(std::map<std::string, FieldValue>&& value) {
+  return FromSortedMap(Map::FromSorted(std::make_move_iterator(value.begin()),
+                                       std::make_move_iterator(value.end())));
+}
+
+FieldValue FieldValue::FromFields(FieldList* fields,
+                                  const std::shared_ptr<util::Arena>& arena) {
+  if (!std::is_sorted(fields->begin(), fields->end(), EntryLess)) {
+    std::sort(fields->begin(), fields->end(), EntryLess);
+  }
+  auto duplicate = std::adjacent_find(
+      fields->begin(), fields->end(),
+      [](const std::pair<std::string, FieldValue>& lhs,
+         const std::pair<std::string, FieldValue>& rhs) {
+        return lhs.first == rhs.first;
+      });
+  FIREBASE_ASSERT_MESSAGE(duplicate == fields->end(),
+                          "Duplicate field %s in object value",
+                          duplicate->first.c_str());
+
+  // With a null arena, the allocator uses the heap.
+  util::ArenaAllocator<ObjectContents> allocator{arena};
+  Map map = Map::FromSorted(std::make_move_iterator(fields->begin()),
+                            std::make_move_iterator(fields->end()),
+                            std::less<std::string>(), allocator);
+  fields->clear();
+
+  FieldValue result;
+  result.SwitchTo(Type::Object);
+  result.object_value_ =
+      std::allocate_shared<const ObjectContents>(allocator, std::move(map));
+  return result;
+}
+
+FieldValue FieldValue::FromSortedMap(Map&& value) {
   FieldValue result;
   result.SwitchTo(Type::Object);
-  std::swap(result.object_value_, value);
+  result.object_value_ =
+      std::make_shared<const ObjectContents>(std::move(value));
   return result;
 }
 
-bool operator<(const FieldValue& lhs, const FieldValue& rhs) {
-  if (!Comparable(lhs.type(), rhs.type())) {
-    return lhs.type() < rhs.type();
+const FieldValue* FieldValue::Get(const FieldPath& field_path) const {
+  FIREBASE_ASSERT(tag_ == Type::Object);
+  const FieldValue* current = this;
+  for (const std::string& segment : field_path) {
+    if (current->tag_ != Type::Object) {
+      return nullptr;
+    }
+    const Map& fields = current->object_value_->values;
+    auto pos = fields.find(segment);
+    if (pos == fields.end()) {
+      return nullptr;
+    }
+    current = &pos->second;
+  }
+  return current;
+}
+
+FieldValue FieldValue::Set(const FieldPath& field_path,
+                           FieldValue value) const {
+  FIREBASE_ASSERT(tag_ == Type::Object);
+  FIREBASE_ASSERT_MESSAGE(!field_path.empty(),
+                          "Cannot set field for empty path on FieldValue");
+  return SetAt(field_path.begin(), field_path.end(), std::move(value));
+}
+
+FieldValue FieldValue::Delete(const FieldPath& field_path) const {
+  FIREBASE_ASSERT(tag_ == Type::Object);
+  FIREBASE_ASSERT_MESSAGE(!field_path.empty(),
+                          "Cannot delete field for empty path on FieldValue");
+  return DeleteAt(field_path.begin(), field_path.end());
+}
+
+FieldValue FieldValue::SetAt(FieldPath::const_iterator segment,
+                             FieldPath::const_iterator end,
+                             FieldValue&& value) const {
+  const Map& fields = object_value_->values;
+  if (segment + 1 != end) {
+    auto pos = fields.find(*segment);
+    if (pos != fields.end() && pos->second.tag_ == Type::Object) {
+      value = pos->second.SetAt(segment + 1, end, std::move(value));
+    } else {
+      FieldValue child;
+      child.SwitchTo(Type::Object);
+      value = child.SetAt(segment + 1, end, std::move(value));
+    }
+  }
+  return FromSortedMap(SetField(fields, *segment, value));
+}
+
+FieldValue FieldValue::DeleteAt(FieldPath::const_iterator segment,
+                                FieldPath::const_iterator end) const {
+  const Map& fields = object_value_->values;
+  auto pos = fields.find(*segment);
+  if (pos == fields.end()) {
+    return *this;
+  }
+  if (segment + 1 == end) {
+    return FromSortedMap(fields.erase(*segment));
   }
 
-  switch (lhs.type()) {
+  const FieldValue& child = pos->second;
+  if (child.tag_ != Type::Object) {
+    return *this;
+  }
+  FieldValue new_child = child.DeleteAt(segment + 1, end);
+  if (new_child.object_value_ == child.object_value_) {
+    // Nothing was deleted below us, so there's nothing to copy.
+    return *this;
+  }
+  return FromSortedMap(SetField(fields, *segment, new_child));
+}
+
+ComparisonResult FieldValue::Compare(const FieldValue& other) const {
+  if (!Comparable(tag_, other.tag_)) {
+    return CompareWithLessThan(tag_, other.tag_);
+  }
+
+  switch (tag_) {
     case Type::Null:
-      return false;
+      return ComparisonResult::Same;
     case Type::Boolean:
-      return Comparator<bool>()(lhs.boolean_value_, rhs.boolean_value_);
+      return util::Compare<bool>(boolean_value_, other.boolean_value_);
     case Type::Integer:
-      if (rhs.type() == Type::Integer) {
-        return Comparator<int64_t>()(lhs.integer_value_, rhs.integer_value_);
+      if (other.tag_ == Type::Integer) {
+        return util::Compare<int64_t>(integer_value_, other.integer_value_);
       } else {
-        return util::CompareMixedNumber(rhs.double_value_,
-                                        lhs.integer_value_) ==
-               ComparisonResult::Descending;
+        return util::ReverseOrder(
+            util::CompareMixedNumber(other.double_value_, integer_value_));
       }
     case Type::Double:
-      if (rhs.type() == Type::Double) {
-        return Comparator<double>()(lhs.double_value_, rhs.double_value_);
+      if (other.tag_ == Type::Double) {
+        return util::Compare<double>(double_value_, other.double_value_);
       } else {
-        return util::CompareMixedNumber(lhs.double_value_,
-                                        rhs.integer_value_) ==
-               ComparisonResult::Ascending;
+        return util::CompareMixedNumber(double_value_, other.integer_value_);
       }
     case Type::Timestamp:
-      if (rhs.type() == Type::Timestamp) {
-        return lhs.timestamp_value_ < rhs.timestamp_value_;
+      if (other.tag_ == Type::Timestamp) {
+        return CompareWithLessThan(timestamp_value_, other.timestamp_value_);
       } else {
-        return true;
+        return ComparisonResult::Ascending;
       }
     case Type::ServerTimestamp:
-      if (rhs.type() == Type::ServerTimestamp) {
-        return lhs.server_timestamp_value_.local_write_time <
-               rhs.server_timestamp_value_.local_write_time;
+      if (other.tag_ == Type::ServerTimestamp) {
+        return CompareWithLessThan(
+            server_timestamp_value_.local_write_time,
+            other.server_timestamp_value_.local_write_time);
       } else {
-        return false;
+        return ComparisonResult::Descending;
       }
     case Type::String:
-      return lhs.string_value_.compare(rhs.string_value_) < 0;
+      return util::ComparisonResultFromInt(
+          string_value_.compare(other.string_value_));
     case Type::Blob:
-      return lhs.blob_value_ < rhs.blob_value_;
-    case Type::Reference:
-      return *lhs.reference_value_.database_id <
-                 *rhs.reference_value_.database_id ||
-             (*lhs.reference_value_.database_id ==
-                  *rhs.reference_value_.database_id &&
-              lhs.reference_value_.reference < rhs.reference_value_.reference);
+      return blob_value_.Compare(other.blob_value_);
+    case Type::Reference: {
+      ComparisonResult cmp =
+          CompareWithLessThan(*reference_value_.database_id,
+                              *other.reference_value_.database_id);
+      if (cmp != ComparisonResult::Same) {
+        return cmp;
+      }
+      return CompareWithLessThan(reference_value_.reference,
+                                 other.reference_value_.reference);
+    }
     case Type::GeoPoint:
-      return lhs.geo_point_value_ < rhs.geo_point_value_;
-    case Type::Array:
-      return lhs.array_value_ < rhs.array_value_;
-    case Type::Object:
-      return lhs.object_value_ < rhs.object_value_;
+      return CompareWithLessThan(geo_point_value_, other.geo_point_value_);
+    case Type::Array: {
+      // Shared contents are trivially the same.
+      if (array_value_ == other.array_value_) {
+        return ComparisonResult::Same;
+      }
+      const std::vector<FieldValue>& lhs = array_value_->values;
+      const std::vector<FieldValue>& rhs = other.array_value_->values;
+      size_t size = std::min(lhs.size(), rhs.size());
+      for (size_t i = 0; i < size; ++i) {
+        ComparisonResult cmp = lhs[i].Compare(rhs[i]);
+        if (cmp != ComparisonResult::Same) {
+          return cmp;
+        }
+      }
+      return CompareWithLessThan(lhs.size(), rhs.size());
+    }
+    case Type::Object: {
+      if (object_value_ == other.object_value_) {
+        return ComparisonResult::Same;
+      }
+      const Map& lhs = object_value_->values;
+      const Map& rhs = other.object_value_->values;
+      auto lhs_iter = lhs.begin();
+      auto rhs_iter = rhs.begin();
+      for (; lhs_iter != lhs.end() && rhs_iter != rhs.end();
+           ++lhs_iter, ++rhs_iter) {
+        ComparisonResult cmp = util::ComparisonResultFromInt(
+            lhs_iter->first.compare(rhs_iter->first));
+        if (cmp != ComparisonResult::Same) {
+          return cmp;
+        }
+        cmp = lhs_iter->second.Compare(rhs_iter->second);
+        if (cmp != ComparisonResult::Same) {
+          return cmp;
+        }
+      }
+      return CompareWithLessThan(lhs.size(), rhs.size());
+    }
     default:
-      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
-          false, lhs.type(), "Unsupported type %d", lhs.type());
-      // return false if assertion does not abort the program. We will say
+      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(false, tag_,
+                                              "Unsupported type %d", tag_);
+      // return Same if assertion does not abort the program. We will say
       // each unsupported type takes only one value thus everything is equal.
-      return false;
+      return ComparisonResult::Same;
+  }
+}
+
+bool FieldValue::Equals(const FieldValue& other) const {
+  if (tag_ != other.tag_) {
+    // Integers and doubles with the same numeric value are equal; all other
+    // values of different types differ.
+    return IsNumber(tag_) && IsNumber(other.tag_) &&
+           Compare(other) == ComparisonResult::Same;
+  }
+
+  switch (tag_) {
+    case Type::Null:
+      return true;
+    case Type::Boolean:
+      return boolean_value_ == other.boolean_value_;
+    case Type::Integer:
+      return integer_value_ == other.integer_value_;
+    case Type::Double:
+      // Firestore semantics: NaN equals NaN.
+      return util::Compare<double>(double_value_, other.double_value_) ==
+             ComparisonResult::Same;
+    case Type::Timestamp:
+      return timestamp_value_ == other.timestamp_value_;
+    case Type::ServerTimestamp:
+      return server_timestamp_value_.local_write_time ==
+             other.server_timestamp_value_.local_write_time;
+    case Type::String:
+      return string_value_ == other.string_value_;
+    case Type::Blob:
+      return blob_value_ == other.blob_value_;
+    case Type::Reference:
+      return *reference_value_.database_id ==
+                 *other.reference_value_.database_id &&
+             reference_value_.reference == other.reference_value_.reference;
+    case Type::GeoPoint:
+      return geo_point_value_ == other.geo_point_value_;
+    case Type::Array: {
+      if (array_value_ == other.array_value_) {
+        return true;
+      }
+      if (!MaybeEqualHashes(array_value_->hash, other.array_value_->hash)) {
+        return false;
+      }
+      const std::vector<FieldValue>& lhs = array_value_->values;
+      const std::vector<FieldValue>& rhs = other.array_value_->values;
+      return lhs.size() == rhs.size() &&
+             std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                        [](const FieldValue& lhs, const FieldValue& rhs) {
+                          return lhs.Equals(rhs);
+                        });
+    }
+    case Type::Object: {
+      if (object_value_ == other.object_value_) {
+        return true;
+      }
+      if (!MaybeEqualHashes(object_value_->hash, other.object_value_->hash)) {
+        return false;
+      }
+      const Map& lhs = object_value_->values;
+      const Map& rhs = other.object_value_->values;
+      return lhs.size() == rhs.size() &&
+             std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                        [](const std::pair<std::string, FieldValue>& lhs,
+                           const std::pair<std::string, FieldValue>& rhs) {
+                          return lhs.first == rhs.first &&
+                                 lhs.second.Equals(rhs.second);
+                        });
+    }
+    default:
+      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(false, tag_,
+                                              "Unsupported type %d", tag_);
+      return true;
+  }
+}
+
+size_t FieldValue::Hash() const {
+  // Integers and doubles share a seed since they can be equal to each other.
+  size_t seed = static_cast<size_t>(IsNumber(tag_) ? Type::Integer : tag_);
+
+  switch (tag_) {
+    case Type::Null:
+      return seed;
+    case Type::Boolean:
+      return HashCombine(seed, boolean_value_ ? 1 : 0);
+    case Type::Integer:
+      return HashCombine(seed, HashNumber(integer_value_));
+    case Type::Double:
+      return HashCombine(seed, HashNumber(double_value_));
+    case Type::Timestamp:
+      return HashCombine(seed, HashTimestamp(timestamp_value_));
+    case Type::ServerTimestamp:
+      // Equals() only considers the local write time.
+      return HashCombine(
+          seed, HashTimestamp(server_timestamp_value_.local_write_time));
+    case Type::String:
+      return HashCombine(seed, std::hash<std::string>()(string_value_));
+    case Type::Blob:
+      return HashBytes(seed, blob_value_.data(), blob_value_.size());
+    case Type::Reference: {
+      const DatabaseId& database_id = *reference_value_.database_id;
+      size_t hash =
+          HashCombine(seed, std::hash<std::string>()(database_id.project_id()));
+      hash = HashCombine(hash,
+                         std::hash<std::string>()(database_id.database_id()));
+      return HashCombine(
+          hash, static_cast<size_t>(reference_value_.reference.path().Hash()));
+    }
+    case Type::GeoPoint: {
+      // Adding zero turns -0.0 into 0.0, which compares equal to it.
+      size_t hash = HashCombine(
+          seed, util::DoubleBitwiseHash(geo_point_value_.latitude() + 0.0));
+      return HashCombine(
+          hash, util::DoubleBitwiseHash(geo_point_value_.longitude() + 0.0));
+    }
+    case Type::Array: {
+      size_t hash = array_value_->hash.load(std::memory_order_relaxed);
+      if (hash == 0) {
+        hash = seed;
+        for (const FieldValue& element : array_value_->values) {
+          hash = HashCombine(hash, element.Hash());
+        }
+        hash = CacheHash(&array_value_->hash, hash);
+      }
+      return hash;
+    }
+    case Type::Object: {
+      size_t hash = object_value_->hash.load(std::memory_order_relaxed);
+      if (hash == 0) {
+        hash = seed;
+        for (const auto& kv : object_value_->values) {
+          hash = HashCombine(hash, std::hash<std::string>()(kv.first));
+          hash = HashCombine(hash, kv.second.Hash());
+        }
+        hash = CacheHash(&object_value_->hash, hash);
+      }
+      return hash;
+    }
+    default:
+      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(false, tag_,
+                                              "Unsupported type %d", tag_);
+      return seed;
+  }
+}
+
+size_t FieldValue::ByteSize() const {
+  // Field numbers in google.firestore.v1beta1.Value and the messages within
+  // it. Every member of the Value oneof is written, even a default value.
+  enum : uint32_t {
+    kBooleanValue = 1,
+    kIntegerValue = 2,
+    kDoubleValue = 3,
+    kReferenceValue = 5,
+    kMapValue = 6,
+    kGeoPointValue = 8,
+    kArrayValue = 9,
+    kTimestampValue = 10,
+    kNullValue = 11,
+    kStringValue = 17,
+    kBytesValue = 18,
+
+    // ArrayValue.values, MapValue.fields and its FieldsEntry.key
+    kRepeatedField = 1,
+    // MapValue.FieldsEntry.value
+    kEntryValue = 2,
+    // LatLng.latitude and LatLng.longitude
+    kLatitude = 1,
+    kLongitude = 2,
+  };
+
+  switch (tag_) {
+    case Type::Null:
+      return util::VarintFieldSize(kNullValue, 0);
+    case Type::Boolean:
+      return util::VarintFieldSize(kBooleanValue, boolean_value_);
+    case Type::Integer:
+      return util::VarintFieldSize(kIntegerValue,
+                                   static_cast<uint64_t>(integer_value_));
+    case Type::Double:
+      return util::Fixed64FieldSize(kDoubleValue);
+    case Type::Timestamp:
+      return util::LengthDelimitedFieldSize(kTimestampValue,
+                                            timestamp_value_.ByteSize());
+    case Type::ServerTimestamp:
+      return util::LengthDelimitedFieldSize(
+          kTimestampValue, server_timestamp_value_.local_write_time.ByteSize());
+    case Type::String:
+      return util::LengthDelimitedFieldSize(kStringValue,
+                                            string_value_.size());
+    case Type::Blob:
+      return util::LengthDelimitedFieldSize(kBytesValue, blob_value_.size());
+    case Type::Reference:
+      return util::LengthDelimitedFieldSize(
+          kReferenceValue, reference_value_.reference.ResourceNameSize(
+                               *reference_value_.database_id));
+    case Type::GeoPoint: {
+      size_t size = 0;
+      if (geo_point_value_.latitude() != 0) {
+        size += util::Fixed64FieldSize(kLatitude);
+      }
+      if (geo_point_value_.longitude() != 0) {
+        size += util::Fixed64FieldSize(kLongitude);
+      }
+      return util::LengthDelimitedFieldSize(kGeoPointValue, size);
+    }
+    case Type::Array: {
+      size_t size = 0;
+      for (const FieldValue& element : array_value_->values) {
+        size += util::LengthDelimitedFieldSize(kRepeatedField,
+                                               element.ByteSize());
+      }
+      return util::LengthDelimitedFieldSize(kArrayValue, size);
+    }
+    case Type::Object: {
+      size_t size = 0;
+      for (const auto& kv : object_value_->values) {
+        size_t entry_size =
+            util::LengthDelimitedFieldSize(kRepeatedField, kv.first.size()) +
+            util::LengthDelimitedFieldSize(kEntryValue, kv.second.ByteSize());
+        size += util::LengthDelimitedFieldSize(kRepeatedField, entry_size);
+      }
+      return util::LengthDelimitedFieldSize(kMapValue, size);
+    }
+    default:
+      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(false, tag_,
+                                              "Unsupported type %d", tag_);
+      return 0;
+  }
+}
+
+size_t FieldValue::MemoryUsage(util::CountedAllocations* counted) const {
+  return sizeof(FieldValue) + HeapMemoryUsage(counted);
+}
+
+size_t FieldValue::HeapMemoryUsage(util::CountedAllocations* counted) const {
+  switch (tag_) {
+    case Type::String:
+      return util::StringMemoryUsage(string_value_);
+    case Type::Blob:
+      return blob_value_.HeapMemoryUsage(counted);
+    case Type::Reference:
+      return reference_value_.reference.HeapMemoryUsage(counted);
+    case Type::Array: {
+      // The shared empty array isn't retained by any one value.
+      if (array_value_ == EmptyArray() ||
+          !util::CountOnce(array_value_.get(), counted)) {
+        return 0;
+      }
+      const std::vector<FieldValue>& values = array_value_->values;
+      size_t size = sizeof(ArrayContents) + util::kSharedControlBlockSize +
+                    values.capacity() * sizeof(FieldValue);
+      for (const FieldValue& element : values) {
+        size += element.HeapMemoryUsage(counted);
+      }
+      return size;
+    }
+    case Type::Object: {
+      if (object_value_ == EmptyObject() ||
+          !util::CountOnce(object_value_.get(), counted)) {
+        return 0;
+      }
+      // The Map's own MemoryUsage() includes the Map, which is already counted
+      // as part of the contents.
+      const Map& values = object_value_->values;
+      size_t size = sizeof(ObjectContents) - sizeof(Map) +
+                    util::kSharedControlBlockSize + values.MemoryUsage(counted);
+      for (const auto& kv : values) {
+        size += util::StringMemoryUsage(kv.first);
+        size += kv.second.HeapMemoryUsage(counted);
+      }
+      return size;
+    }
+    default:
+      // Everything else is stored within the FieldValue itself.
+      return 0;
   }
 }
 
@@ -374,7 +916,7 @@ void FieldValue::SwitchTo(const Type type) {
       string_value_.~basic_string();
       break;
     case Type::Blob:
-      blob_value_.~vector();
+      blob_value_.~SharedBytes();
       break;
     case Type::Reference:
       reference_value_.~ReferenceValue();
@@ -383,10 +925,10 @@ void FieldValue::SwitchTo(const Type type) {
       geo_point_value_.~GeoPoint();
       break;
     case Type::Array:
-      array_value_.~vector();
+      array_value_.~shared_ptr();
       break;
     case Type::Object:
-      object_value_.~map();
+      object_value_.~shared_ptr();
       break;
     default: {}  // The other types where there is nothing to worry about.
   }
@@ -403,8 +945,7 @@ void FieldValue::SwitchTo(const Type type) {
       new (&string_value_) std::string();
       break;
     case Type::Blob:
-      // Do not even bother to allocate a new array of size 0.
-      new (&blob_value_) std::vector<uint8_t>();
+      new (&blob_value_) util::SharedBytes();
       break;
     case Type::Reference:
       // Qualified name to avoid conflict with the member function of same name.
@@ -414,10 +955,10 @@ void FieldValue::SwitchTo(const Type type) {
       new (&geo_point_value_) GeoPoint();
       break;
     case Type::Array:
-      new (&array_value_) std::vector<FieldValue>();
+      new (&array_value_) std::shared_ptr<const ArrayContents>(EmptyArray());
       break;
     case Type::Object:
-      new (&object_value_) std::map<std::string, FieldValue>();
+      new (&object_value_) std::shared_ptr<const ObjectContents>(EmptyObject());
       break;
     default: {}  // The other types where there is nothing to worry about.
   }
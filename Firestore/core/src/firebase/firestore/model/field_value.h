@@ -17,18 +17,27 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/geo_point.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+#include "Firestore/core/src/firebase/firestore/util/shared_bytes.h"
 
 namespace firebase {
 namespace firestore {
@@ -51,6 +60,12 @@ struct ReferenceValue {
  * tagged-union class representing an immutable data value as stored in
  * Firestore. FieldValue represents all the different kinds of values
  * that can be stored in fields in a document.
+ *
+ * The contents of Blob, Array and Object values are immutable and shared
+ * between copies of the FieldValue, so copying a FieldValue is O(1)
+ * regardless of how large the value tree underneath it is. The hashes of
+ * arrays and objects are likewise computed at most once and cached alongside
+ * the shared contents.
  */
 class FieldValue {
  public:
@@ -78,6 +93,21 @@ class FieldValue {
     // position instead, see the doc comment above.
   };
 
+  /**
+   * The fields of an Object value, sorted by name. An object with no more than
+   * Map::kFixedSize fields keeps them in a single array, which makes lookups a
+   * binary search over contiguous memory; larger objects switch to a tree.
+   * Either way the map is persistent: Set() and Delete() build a new map that
+   * shares everything they don't change with the old one.
+   */
+  using Map = immutable::SortedMap<std::string, FieldValue>;
+
+  /**
+   * A list of fields in no particular order, from which FromFields() creates
+   * an Object value.
+   */
+  using FieldList = std::vector<std::pair<std::string, FieldValue>>;
+
   FieldValue() {
   }
 
@@ -106,16 +136,82 @@ class FieldValue {
     return integer_value_;
   }
 
+  double double_value() const {
+    FIREBASE_ASSERT(tag_ == Type::Double);
+    return double_value_;
+  }
+
+  const Timestamp& timestamp_value() const {
+    FIREBASE_ASSERT(tag_ == Type::Timestamp);
+    return timestamp_value_;
+  }
+
+  const ServerTimestamp& server_timestamp_value() const {
+    FIREBASE_ASSERT(tag_ == Type::ServerTimestamp);
+    return server_timestamp_value_;
+  }
+
   const std::string& string_value() const {
     FIREBASE_ASSERT(tag_ == Type::String);
     return string_value_;
   }
 
-  const std::map<std::string, FieldValue>& object_value() const {
+  const util::SharedBytes& blob_value() const {
+    FIREBASE_ASSERT(tag_ == Type::Blob);
+    return blob_value_;
+  }
+
+  const firebase::firestore::model::ReferenceValue& reference_value() const {
+    FIREBASE_ASSERT(tag_ == Type::Reference);
+    return reference_value_;
+  }
+
+  const GeoPoint& geo_point_value() const {
+    FIREBASE_ASSERT(tag_ == Type::GeoPoint);
+    return geo_point_value_;
+  }
+
+  const std::vector<FieldValue>& array_value() const {
+    FIREBASE_ASSERT(tag_ == Type::Array);
+    return array_value_->values;
+  }
+
+  /** Returns the fields of this Object value, sorted by name. */
+  const Map& object_value() const {
     FIREBASE_ASSERT(tag_ == Type::Object);
-    return object_value_;
+    return object_value_->values;
   }
 
+  /**
+   * Returns the value at the given path within this Object value, or nullptr
+   * if there is no such field. An empty path refers to this value itself.
+   *
+   * The returned pointer remains valid for as long as this value, or any copy
+   * of it, is alive.
+   */
+  const FieldValue* Get(const FieldPath& field_path) const;
+
+  /**
+   * Returns a copy of this Object value with the field at the given path set
+   * to the given value, creating intermediate objects (and replacing any
+   * non-object values) along the path as needed.
+   *
+   * Every subtree off the path is shared with this value. Of each object
+   * along the path, only the part of its Map leading to the field is copied:
+   * the whole array of an object with up to Map::kFixedSize fields, but only
+   * O(log n) tree nodes of a larger one. So setting a field at depth d in
+   * objects of up to n fields takes O(d log n) time, not O(size).
+   */
+  FieldValue Set(const FieldPath& field_path, FieldValue value) const;
+
+  /**
+   * Returns a copy of this Object value with the field at the given path
+   * removed. If there is no such field, returns this value unchanged.
+   *
+   * As with Set(), only the path to the field is copied, in O(d log n) time.
+   */
+  FieldValue Delete(const FieldPath& field_path) const;
+
   /** factory methods. */
   static const FieldValue& NullValue();
   static const FieldValue& TrueValue();
@@ -132,6 +228,8 @@ class FieldValue {
   static FieldValue StringValue(const std::string& value);
   static FieldValue StringValue(std::string&& value);
   static FieldValue BlobValue(const uint8_t* source, size_t size);
+  /** Creates a Blob value sharing the given bytes, without copying them. */
+  static FieldValue BlobValue(util::SharedBytes value);
   static FieldValue ReferenceValue(const DocumentKey& value,
                                    const DatabaseId* database_id);
   static FieldValue ReferenceValue(DocumentKey&& value,
@@ -141,13 +239,106 @@ class FieldValue {
   static FieldValue ArrayValue(std::vector<FieldValue>&& value);
   static FieldValue ObjectValue(const std::map<std::string, FieldValue>& value);
   static FieldValue ObjectValue(std::map<std::string, FieldValue>&& value);
+  /**
+   * Creates an Object value from the given fields, which need not be sorted.
+   * Field names must be unique. The fields are moved out of the list, which is
+   * left empty but keeps its capacity, so that it can be reused.
+   *
+   * @param arena If not null, the Object's contents are allocated in this
+   *     Arena, along with its fields unless there are more than
+   *     Map::kFixedSize of them. Decoders use this to place a whole tree of
+   *     values in a few blocks of memory; see remote::Serializer. Values
+   *     derived from the Object later, by Set() or Delete(), are allocated on
+   *     the heap.
+   */
+  static FieldValue FromFields(
+      FieldList* fields, const std::shared_ptr<util::Arena>& arena = nullptr);
+
+  /**
+   * Performs a three-way comparison of this value against the given one,
+   * according to the Firestore ordering of values (see Type above).
+   */
+  util::ComparisonResult Compare(const FieldValue& other) const;
 
-  friend bool operator<(const FieldValue& lhs, const FieldValue& rhs);
+  /**
+   * Returns true if this value is equal to the given one. This agrees with
+   * Compare() returning Same, but only walks the two values once and returns
+   * as soon as any difference (in type, size or contents) is found.
+   *
+   * Arrays and Objects that share contents are equal without being walked,
+   * and ones whose cached hashes (see Hash()) differ are unequal. Otherwise,
+   * including when the hashes match, the contents are compared in full.
+   */
+  bool Equals(const FieldValue& other) const;
+
+  /**
+   * Returns a hash of this value that is consistent with Equals(): equal
+   * values, including an Integer and a Double of the same numeric value, have
+   * equal hashes. Structurally identical subtrees hash identically no matter
+   * how they were built.
+   *
+   * The hash of an Array or Object is computed on first use and cached in its
+   * shared contents, so hashing a value again (or any copy of it) is O(1).
+   */
+  size_t Hash() const;
+
+  /**
+   * Returns the size of this value when serialized as a
+   * google.firestore.v1beta1.Value message. ServerTimestamps, which are never
+   * sent as values, are sized as their local write time.
+   */
+  size_t ByteSize() const;
+
+  /**
+   * Returns an estimate of the memory retained by this value: the FieldValue
+   * itself plus the heap memory it owns or shares with other values.
+   *
+   * @param counted If not null, shared storage (the contents of Arrays and
+   *     Objects, and the paths of References) that is already in this set is
+   *     skipped, and storage that is counted is added to it, so that measuring
+   *     several values with the same set counts what they share only once.
+   *     Without it, shared storage is counted everywhere it appears.
+   */
+  size_t MemoryUsage(util::CountedAllocations* counted = nullptr) const;
 
  private:
+  /**
+   * The immutable contents of an Array or Object value, shared by all copies
+   * of the value, along with the hash of those contents once computed.
+   */
+  template <typename T>
+  struct Contents {
+    template <typename... Args>
+    explicit Contents(Args&&... args) : values(std::forward<Args>(args)...) {
+    }
+
+    const T values;
+    // Zero until the hash has been computed; a computed hash is never zero.
+    mutable std::atomic<size_t> hash{0};
+  };
+  using ArrayContents = Contents<std::vector<FieldValue>>;
+  using ObjectContents = Contents<Map>;
+
+  static const std::shared_ptr<const ArrayContents>& EmptyArray();
+  static const std::shared_ptr<const ObjectContents>& EmptyObject();
+
   explicit FieldValue(bool value) : tag_(Type::Boolean), boolean_value_(value) {
   }
 
+  /** Creates an Object value with the given fields. */
+  static FieldValue FromSortedMap(Map&& value);
+
+  // Recursive implementations of Set() and Delete() for the path segments in
+  // [segment, end), which must not be empty.
+  FieldValue SetAt(FieldPath::const_iterator segment,
+                   FieldPath::const_iterator end,
+                   FieldValue&& value) const;
+  FieldValue DeleteAt(FieldPath::const_iterator segment,
+                      FieldPath::const_iterator end) const;
+
+  /** As MemoryUsage(), but without counting the FieldValue itself. */
+  size_t HeapMemoryUsage(util::CountedAllocations* counted) const;
+
   /**
    * Switch to the specified type, if different from the current type.
    */
@@ -162,38 +353,48 @@ class FieldValue {
     Timestamp timestamp_value_;
     ServerTimestamp server_timestamp_value_;
     std::string string_value_;
-    std::vector<uint8_t> blob_value_;
+    util::SharedBytes blob_value_;
     // Qualified name to avoid conflict with the member function of same name.
     firebase::firestore::model::ReferenceValue reference_value_;
     GeoPoint geo_point_value_;
-    std::vector<FieldValue> array_value_;
-    std::map<std::string, FieldValue> object_value_;
+    // Arrays and objects are never modified once created so their contents can
+    // be shared between all copies of the FieldValue.
+    std::shared_ptr<const ArrayContents> array_value_;
+    std::shared_ptr<const ObjectContents> object_value_;
   };
 };
 
-/** Compares against another FieldValue. */
-bool operator<(const FieldValue& lhs, const FieldValue& rhs);
+inline bool operator<(const FieldValue& lhs, const FieldValue& rhs) {
+  return lhs.Compare(rhs) == util::ComparisonResult::Ascending;
+}
 
 inline bool operator>(const FieldValue& lhs, const FieldValue& rhs) {
-  return rhs < lhs;
+  return lhs.Compare(rhs) == util::ComparisonResult::Descending;
 }
 
 inline bool operator>=(const FieldValue& lhs, const FieldValue& rhs) {
-  return !(lhs < rhs);
+  return lhs.Compare(rhs) != util::ComparisonResult::Ascending;
 }
 
 inline bool operator<=(const FieldValue& lhs, const FieldValue& rhs) {
-  return !(lhs > rhs);
+  return lhs.Compare(rhs) != util::ComparisonResult::Descending;
 }
 
 inline bool operator!=(const FieldValue& lhs, const FieldValue& rhs) {
-  return lhs < rhs || lhs > rhs;
+  return !lhs.Equals(rhs);
 }
 
 inline bool operator==(const FieldValue& lhs, const FieldValue& rhs) {
-  return !(lhs != rhs);
+  return lhs.Equals(rhs);
 }
 
+/** A hash function for FieldValues, for use in unordered containers. */
+struct HashFieldValue {
+  size_t operator()(const FieldValue& value) const {
+    return value.Hash();
+  }
+};
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
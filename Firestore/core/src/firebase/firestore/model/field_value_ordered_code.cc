@@ -0,0 +1,495 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_value_ordered_code.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+using Type = FieldValue::Type;
+using util::OrderedCode;
+
+namespace {
+
+// Every encoded value starts with one of these bytes, so values of different
+// types sort by it alone. They follow the ordering of FieldValue::Type, except
+// that Integers and Doubles share a marker since they compare as numbers.
+//
+// Zero is reserved to terminate arrays and objects, so that a shorter array
+// (or object) sorts before any longer one that it is a prefix of.
+const char kEndOfSequence = 0;
+const char kNullMarker = 1;
+const char kBooleanMarker = 2;
+const char kNumberMarker = 3;
+const char kTimestampMarker = 4;
+const char kServerTimestampMarker = 5;
+const char kStringMarker = 6;
+const char kBlobMarker = 7;
+const char kReferenceMarker = 8;
+const char kGeoPointMarker = 9;
+const char kArrayMarker = 10;
+const char kObjectMarker = 11;
+
+// Precedes each field of an encoded object and each path segment of an
+// encoded reference. Those are strings, whose encodings may start with a zero
+// byte, so without it they couldn't be told apart from the end of the
+// sequence.
+const char kFieldMarker = 1;
+
+// Numbers are split into classes that sort in this order. Numbers in the
+// range of int64_t are encoded exactly as an integral part and a fraction, so
+// that every Integer compares correctly with every Double. Doubles outside
+// that range are always integral and can be encoded as-is.
+const char kNaNClass = 1;
+const char kBelowInt64Class = 2;
+const char kInt64Class = 3;
+const char kAboveInt64Class = 4;
+
+// -2^63 and 2^63, which are both exactly representable as doubles.
+const double kMinInt64 = -9223372036854775808.0;
+const double kMaxInt64Exclusive = 9223372036854775808.0;
+
+const uint64_t kSignBit = 1ULL << 63;
+
+// How many bytes ReadDecreasing() first tries to read a value from.
+const size_t kInitialDecreasingPrefix = 64;
+
+/**
+ * Maps a double onto a uint64_t such that the order of the result matches
+ * the numeric order of the double. NaN is not supported.
+ */
+uint64_t DoubleToOrderedBits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  // Negative doubles sort in the reverse order of their magnitude, which
+  // inverting all their bits takes care of. Setting the sign bit of positive
+  // ones moves them after all the negative ones.
+  return (bits & kSignBit) ? ~bits : bits | kSignBit;
+}
+
+/** Inverts DoubleToOrderedBits(). */
+double OrderedBitsToDouble(uint64_t bits) {
+  bits = (bits & kSignBit) ? bits & ~kSignBit : ~bits;
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * Encodes a number in the int64_t range as its integral part (rounded towards
+ * zero) and the fraction that remains, which compare lexicographically as the
+ * number itself.
+ */
+void WriteInt64Range(std::string* dest, int64_t integral, double fraction) {
+  dest->push_back(kInt64Class);
+  OrderedCode::WriteSignedNumIncreasing(dest, integral);
+  // Adding zero turns -0.0 into 0.0, so that equal numbers encode the same.
+  OrderedCode::WriteNumIncreasing(dest, DoubleToOrderedBits(fraction + 0.0));
+}
+
+void WriteDouble(std::string* dest, double value) {
+  if (isnan(value)) {
+    dest->push_back(kNaNClass);
+  } else if (value < kMinInt64) {
+    dest->push_back(kBelowInt64Class);
+    OrderedCode::WriteNumIncreasing(dest, DoubleToOrderedBits(value));
+  } else if (value >= kMaxInt64Exclusive) {
+    dest->push_back(kAboveInt64Class);
+    OrderedCode::WriteNumIncreasing(dest, DoubleToOrderedBits(value));
+  } else {
+    // Subtracting the value rounded towards zero is always exact.
+    double integral = trunc(value);
+    WriteInt64Range(dest, static_cast<int64_t>(integral), value - integral);
+  }
+}
+
+void WriteTimestamp(std::string* dest, const Timestamp& value) {
+  OrderedCode::WriteSignedNumIncreasing(dest, value.seconds());
+  OrderedCode::WriteNumIncreasing(dest, value.nanos());
+}
+
+void WriteValue(std::string* dest, const FieldValue& value) {
+  switch (value.type()) {
+    case Type::Null:
+      dest->push_back(kNullMarker);
+      break;
+    case Type::Boolean:
+      dest->push_back(kBooleanMarker);
+      OrderedCode::WriteNumIncreasing(dest, value.boolean_value() ? 1 : 0);
+      break;
+    case Type::Integer:
+      dest->push_back(kNumberMarker);
+      WriteInt64Range(dest, value.integer_value(), 0.0);
+      break;
+    case Type::Double:
+      dest->push_back(kNumberMarker);
+      WriteDouble(dest, value.double_value());
+      break;
+    case Type::Timestamp:
+      dest->push_back(kTimestampMarker);
+      WriteTimestamp(dest, value.timestamp_value());
+      break;
+    case Type::ServerTimestamp:
+      // Server timestamps compare by their local write time alone.
+      dest->push_back(kServerTimestampMarker);
+      WriteTimestamp(dest, value.server_timestamp_value().local_write_time);
+      break;
+    case Type::String:
+      dest->push_back(kStringMarker);
+      OrderedCode::WriteString(dest, value.string_value());
+      break;
+    case Type::Blob: {
+      const util::SharedBytes& blob = value.blob_value();
+      dest->push_back(kBlobMarker);
+      OrderedCode::WriteString(
+          dest, absl::string_view(reinterpret_cast<const char*>(blob.data()),
+                                  blob.size()));
+      break;
+    }
+    case Type::Reference: {
+      const ReferenceValue& reference = value.reference_value();
+      dest->push_back(kReferenceMarker);
+      OrderedCode::WriteString(dest, reference.database_id->project_id());
+      OrderedCode::WriteString(dest, reference.database_id->database_id());
+      for (const std::string& segment : reference.reference.path()) {
+        dest->push_back(kFieldMarker);
+        OrderedCode::WriteString(dest, segment);
+      }
+      dest->push_back(kEndOfSequence);
+      break;
+    }
+    case Type::GeoPoint: {
+      // Adding zero turns -0.0 into 0.0, which compares equal to it.
+      const GeoPoint& geo_point = value.geo_point_value();
+      dest->push_back(kGeoPointMarker);
+      OrderedCode::WriteNumIncreasing(
+          dest, DoubleToOrderedBits(geo_point.latitude() + 0.0));
+      OrderedCode::WriteNumIncreasing(
+          dest, DoubleToOrderedBits(geo_point.longitude() + 0.0));
+      break;
+    }
+    case Type::Array:
+      dest->push_back(kArrayMarker);
+      for (const FieldValue& element : value.array_value()) {
+        WriteValue(dest, element);
+      }
+      dest->push_back(kEndOfSequence);
+      break;
+    case Type::Object:
+      dest->push_back(kObjectMarker);
+      for (const auto& kv : value.object_value()) {
+        dest->push_back(kFieldMarker);
+        OrderedCode::WriteString(dest, kv.first);
+        WriteValue(dest, kv.second);
+      }
+      dest->push_back(kEndOfSequence);
+      break;
+    default:
+      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+          false, value.type(), "Unsupported type %d", value.type());
+  }
+}
+
+bool ReadByte(absl::string_view* src, char* result) {
+  if (src->empty()) {
+    return false;
+  }
+  *result = (*src)[0];
+  src->remove_prefix(1);
+  return true;
+}
+
+/**
+ * Consumes the marker ending an array or object if it is next in *src,
+ * returning whether it was.
+ */
+bool ReadEndOfSequence(absl::string_view* src) {
+  if (!src->empty() && (*src)[0] == kEndOfSequence) {
+    src->remove_prefix(1);
+    return true;
+  }
+  return false;
+}
+
+bool ReadNumber(absl::string_view* src, FieldValue* result) {
+  char number_class;
+  if (!ReadByte(src, &number_class)) {
+    return false;
+  }
+  switch (number_class) {
+    case kNaNClass:
+      *result = FieldValue::NanValue();
+      return true;
+    case kBelowInt64Class:
+    case kAboveInt64Class: {
+      uint64_t bits;
+      if (!OrderedCode::ReadNumIncreasing(src, &bits)) {
+        return false;
+      }
+      *result = FieldValue::DoubleValue(OrderedBitsToDouble(bits));
+      return true;
+    }
+    case kInt64Class: {
+      int64_t integral;
+      uint64_t bits;
+      if (!OrderedCode::ReadSignedNumIncreasing(src, &integral) ||
+          !OrderedCode::ReadNumIncreasing(src, &bits)) {
+        return false;
+      }
+      double fraction = OrderedBitsToDouble(bits);
+      if (!(fraction > -1.0 && fraction < 1.0)) {
+        return false;
+      }
+      if (fraction == 0.0) {
+        *result = FieldValue::IntegerValue(integral);
+      } else {
+        // Only numbers smaller than 2^53 in magnitude have a fraction, and
+        // those convert to double (and back) exactly.
+        *result =
+            FieldValue::DoubleValue(static_cast<double>(integral) + fraction);
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool ReadTimestamp(absl::string_view* src, Timestamp* result) {
+  int64_t seconds;
+  uint64_t nanos;
+  if (!OrderedCode::ReadSignedNumIncreasing(src, &seconds) ||
+      !OrderedCode::ReadNumIncreasing(src, &nanos)) {
+    return false;
+  }
+  // Check the bounds that the Timestamp constructor asserts.
+  if (nanos >= 1000000000 || seconds < -62135596800L ||
+      seconds >= 253402300800L) {
+    return false;
+  }
+  *result = Timestamp(seconds, static_cast<int32_t>(nanos));
+  return true;
+}
+
+bool ReadValue(absl::string_view* src,
+               const DatabaseId* database_id,
+               FieldValue* result) {
+  char marker;
+  if (!ReadByte(src, &marker)) {
+    return false;
+  }
+  switch (marker) {
+    case kNullMarker:
+      *result = FieldValue::NullValue();
+      return true;
+    case kBooleanMarker: {
+      uint64_t value;
+      if (!OrderedCode::ReadNumIncreasing(src, &value) || value > 1) {
+        return false;
+      }
+      *result = FieldValue::BooleanValue(value == 1);
+      return true;
+    }
+    case kNumberMarker:
+      return ReadNumber(src, result);
+    case kTimestampMarker: {
+      Timestamp timestamp;
+      if (!ReadTimestamp(src, &timestamp)) {
+        return false;
+      }
+      *result = FieldValue::TimestampValue(timestamp);
+      return true;
+    }
+    case kServerTimestampMarker: {
+      Timestamp local_write_time;
+      if (!ReadTimestamp(src, &local_write_time)) {
+        return false;
+      }
+      *result = FieldValue::ServerTimestampValue(local_write_time);
+      return true;
+    }
+    case kStringMarker: {
+      std::string value;
+      if (!OrderedCode::ReadString(src, &value)) {
+        return false;
+      }
+      *result = FieldValue::StringValue(std::move(value));
+      return true;
+    }
+    case kBlobMarker: {
+      std::string value;
+      if (!OrderedCode::ReadString(src, &value)) {
+        return false;
+      }
+      *result = FieldValue::BlobValue(
+          reinterpret_cast<const uint8_t*>(value.data()), value.size());
+      return true;
+    }
+    case kReferenceMarker: {
+      std::string project_id;
+      std::string database;
+      if (!OrderedCode::ReadString(src, &project_id) ||
+          !OrderedCode::ReadString(src, &database)) {
+        return false;
+      }
+      if (project_id != database_id->project_id() ||
+          database != database_id->database_id()) {
+        return false;
+      }
+      std::vector<std::string> segments;
+      while (!ReadEndOfSequence(src)) {
+        char field_marker;
+        std::string segment;
+        if (!ReadByte(src, &field_marker) || field_marker != kFieldMarker ||
+            !OrderedCode::ReadString(src, &segment) || segment.empty()) {
+          return false;
+        }
+        segments.push_back(std::move(segment));
+      }
+      ResourcePath path{std::move(segments)};
+      if (!DocumentKey::IsDocumentKey(path)) {
+        return false;
+      }
+      *result = FieldValue::ReferenceValue(DocumentKey{std::move(path)},
+                                           database_id);
+      return true;
+    }
+    case kGeoPointMarker: {
+      uint64_t latitude_bits;
+      uint64_t longitude_bits;
+      if (!OrderedCode::ReadNumIncreasing(src, &latitude_bits) ||
+          !OrderedCode::ReadNumIncreasing(src, &longitude_bits)) {
+        return false;
+      }
+      double latitude = OrderedBitsToDouble(latitude_bits);
+      double longitude = OrderedBitsToDouble(longitude_bits);
+      // Check the bounds that the GeoPoint constructor asserts, which also
+      // rules out NaN.
+      if (!(latitude >= -90 && latitude <= 90) ||
+          !(longitude >= -180 && longitude <= 180)) {
+        return false;
+      }
+      *result = FieldValue::GeoPointValue(GeoPoint(latitude, longitude));
+      return true;
+    }
+    case kArrayMarker: {
+      std::vector<FieldValue> elements;
+      while (!ReadEndOfSequence(src)) {
+        FieldValue element;
+        if (!ReadValue(src, database_id, &element)) {
+          return false;
+        }
+        elements.push_back(std::move(element));
+      }
+      *result = FieldValue::ArrayValue(std::move(elements));
+      return true;
+    }
+    case kObjectMarker: {
+      FieldValue::FieldList fields;
+      while (!ReadEndOfSequence(src)) {
+        char field_marker;
+        std::string name;
+        FieldValue field_value;
+        if (!ReadByte(src, &field_marker) || field_marker != kFieldMarker ||
+            !OrderedCode::ReadString(src, &name) ||
+            !ReadValue(src, database_id, &field_value)) {
+          return false;
+        }
+        // Fields are written in order, so anything else is corrupt.
+        if (!fields.empty() && !(fields.back().first < name)) {
+          return false;
+        }
+        fields.emplace_back(std::move(name), std::move(field_value));
+      }
+      *result = FieldValue::FromFields(&fields);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+void FieldValueOrderedCode::WriteIncreasing(std::string* dest,
+                                            const FieldValue& value) {
+  WriteValue(dest, value);
+}
+
+void FieldValueOrderedCode::WriteDecreasing(std::string* dest,
+                                            const FieldValue& value) {
+  // The increasing encoding is prefix-free, so inverting its bytes exactly
+  // reverses its order.
+  size_t start = dest->size();
+  WriteValue(dest, value);
+  for (size_t i = start; i < dest->size(); ++i) {
+    (*dest)[i] = ~(*dest)[i];
+  }
+}
+
+bool FieldValueOrderedCode::ReadIncreasing(absl::string_view* src,
+                                           const DatabaseId* database_id,
+                                           FieldValue* result) {
+  return ReadValue(src, database_id, result);
+}
+
+bool FieldValueOrderedCode::ReadDecreasing(absl::string_view* src,
+                                           const DatabaseId* database_id,
+                                           FieldValue* result) {
+  // The length of the encoding isn't known up front. Rather than invert all
+  // of *src, invert a prefix of it that doubles in size until the value can
+  // be read from it. Since the encoding is prefix-free, a read that succeeds
+  // consumed the same bytes it would have from all of *src, and only a read
+  // that fails once the prefix is all of *src means the input is invalid.
+  // This inverts and reads O(n) bytes for a value encoded in n bytes, however
+  // much follows it.
+  std::string inverted;
+  size_t length = std::min(src->size(), kInitialDecreasingPrefix);
+  while (true) {
+    for (size_t i = inverted.size(); i < length; ++i) {
+      inverted.push_back(~(*src)[i]);
+    }
+    absl::string_view remaining{inverted};
+    if (ReadValue(&remaining, database_id, result)) {
+      src->remove_prefix(inverted.size() - remaining.size());
+      return true;
+    }
+    if (length == src->size()) {
+      return false;
+    }
+    length = std::min(src->size(), length * 2);
+  }
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
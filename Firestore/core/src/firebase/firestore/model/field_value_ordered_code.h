@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_ORDERED_CODE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_ORDERED_CODE_H_
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * Encodes FieldValues into byte strings that sort, when compared
+ * lexicographically (i.e. with memcmp), in exactly the order of the values
+ * themselves: for any values a and b, a < b if and only if the encoding of a
+ * sorts before the encoding of b. This makes the encodings suitable for use as
+ * (parts of) keys in an index of values.
+ *
+ * Encodings are built with util::OrderedCode and are self-delimiting, so they
+ * can be followed by other OrderedCode items (or further encoded values) in
+ * the same key without affecting its order.
+ *
+ * Values that compare as the same have identical encodings. Decoding
+ * therefore produces a value equal to (but not always indistinguishable from)
+ * the one that was encoded:
+ *   - Doubles holding an integral value in the range of int64_t decode as
+ *     Integers, and -0.0 decodes as 0.
+ *   - ServerTimestamps decode without their previous value.
+ */
+class FieldValueOrderedCode {
+ public:
+  /** Appends the encoding of the given value to *dest, in increasing order. */
+  static void WriteIncreasing(std::string* dest, const FieldValue& value);
+
+  /**
+   * Appends the encoding of the given value to *dest such that larger values
+   * sort first.
+   */
+  static void WriteDecreasing(std::string* dest, const FieldValue& value);
+
+  /**
+   * Decodes a value written by WriteIncreasing() from the front of *src,
+   * advancing *src past it. Reference values are decoded relative to the given
+   * database_id, which must outlive the result.
+   *
+   * Returns false if *src does not start with a valid encoding, or if it
+   * contains a reference to a database other than database_id. The contents
+   * of *src and *result are unspecified in that case.
+   */
+  static bool ReadIncreasing(absl::string_view* src,
+                             const DatabaseId* database_id,
+                             FieldValue* result);
+
+  /** Decodes a value written by WriteDecreasing(), as ReadIncreasing(). */
+  static bool ReadDecreasing(absl::string_view* src,
+                             const DatabaseId* database_id,
+                             FieldValue* result);
+
+ private:
+  // Not an instantiable class.
+  FieldValueOrderedCode() = delete;
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_ORDERED_CODE_H_
@@ -16,9 +16,12 @@
 
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 
+#include <functional>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "Firestore/core/src/firebase/firestore/util/wire_size.h"
 
 namespace firebase {
 namespace firestore {
@@ -28,6 +31,26 @@ MaybeDocument::MaybeDocument(DocumentKey key, SnapshotVersion version)
     : key_(std::move(key)), version_(std::move(version)) {
 }
 
+size_t MaybeDocument::Hash() const {
+  const Timestamp& timestamp = version_.timestamp();
+  size_t hash = static_cast<size_t>(type_);
+  hash = util::HashCombine(hash, key_.path().Hash());
+  hash = util::HashCombine(hash, std::hash<int64_t>()(timestamp.seconds()));
+  return util::HashCombine(hash, std::hash<int32_t>()(timestamp.nanos()));
+}
+
+size_t MaybeDocument::ByteSize(const DatabaseId& database_id) const {
+  // NoDocument.name and NoDocument.read_time
+  return util::LengthDelimitedFieldSize(1,
+                                        key_.ResourceNameSize(database_id)) +
+         util::LengthDelimitedFieldSize(2, version_.timestamp().ByteSize());
+}
+
+size_t MaybeDocument::MemoryUsageImpl(
+    util::CountedAllocations* counted) const {
+  return sizeof(MaybeDocument) + key_.HeapMemoryUsage(counted);
+}
+
 bool MaybeDocument::Equals(const MaybeDocument& other) const {
   return type_ == other.type_ && version_ == other.version_ &&
          key_ == other.key_;
@@ -17,10 +17,14 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_MAYBE_DOCUMENT_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_MAYBE_DOCUMENT_H_
 
+#include <stddef.h>
+
 #include <functional>
 
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
 
 namespace firebase {
 namespace firestore {
@@ -62,6 +66,25 @@ class MaybeDocument {
     return version_;
   }
 
+  /** Returns a hash of this document that is consistent with operator==. */
+  virtual size_t Hash() const;
+
+  /**
+   * Returns the size of this document when serialized for the given database:
+   * as a google.firestore.v1beta1.Document if it is a Document, or otherwise
+   * as a NoDocument message holding its name and read time.
+   */
+  virtual size_t ByteSize(const DatabaseId& database_id) const;
+
+  /**
+   * Returns an estimate of the memory retained by this document, including
+   * the document object itself. See FieldValue::MemoryUsage() for the meaning
+   * of counted.
+   */
+  size_t MemoryUsage(util::CountedAllocations* counted = nullptr) const {
+    return MemoryUsageImpl(counted);
+  }
+
  protected:
   // Only allow subclass to set their types.
   void set_type(Type type) {
@@ -70,6 +93,8 @@ class MaybeDocument {
 
   virtual bool Equals(const MaybeDocument& other) const;
 
+  virtual size_t MemoryUsageImpl(util::CountedAllocations* counted) const;
+
   friend bool operator==(const MaybeDocument& lhs, const MaybeDocument& rhs);
 
  private:
@@ -86,6 +111,16 @@ inline bool operator!=(const MaybeDocument& lhs, const MaybeDocument& rhs) {
   return !(lhs == rhs);
 }
 
+/**
+ * A hash function for MaybeDocuments (including Documents), for use in
+ * unordered containers.
+ */
+struct HashMaybeDocument {
+  size_t operator()(const MaybeDocument& doc) const {
+    return doc.Hash();
+  }
+};
+
 /** Compares against another MaybeDocument by keys only. */
 struct DocumentKeyComparator : public std::less<MaybeDocument> {
   bool operator()(const MaybeDocument& lhs, const MaybeDocument& rhs) const {
@@ -22,7 +22,6 @@
 
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
 #include "absl/strings/str_join.h"
-#include "absl/strings/str_split.h"
 
 namespace firebase {
 namespace firestore {
@@ -38,10 +37,22 @@ ResourcePath ResourcePath::FromString(const absl::string_view path) {
       "Invalid path (%s). Paths must not contain // in them.",
       std::string{path.data(), path.data() + path.size()}.c_str());
 
-  // SkipEmpty because we may still have an empty segment at the beginning or
-  // end if they had a leading or trailing slash (which we allow).
-  std::vector<std::string> segments =
-      absl::StrSplit(path, '/', absl::SkipEmpty());
+  // Count the segments first so that they can be allocated in one go.
+  SegmentsT segments;
+  segments.reserve(std::count(path.begin(), path.end(), '/') + 1);
+  size_t start = 0;
+  while (start < path.size()) {
+    size_t end = path.find('/', start);
+    if (end == absl::string_view::npos) {
+      end = path.size();
+    }
+    // Skip empty segments, since there may still be one at the beginning or
+    // end if the path had a leading or trailing slash (which we allow).
+    if (end > start) {
+      segments.emplace_back(path.data() + start, end - start);
+    }
+    start = end + 1;
+  }
   return ResourcePath{std::move(segments)};
 }
 
@@ -50,7 +61,8 @@ std::string ResourcePath::CanonicalString() const {
   // sequences (e.g. __id123__) and just passes them through raw (they exist
   // for legacy reasons and should not be used frequently).
 
-  return absl::StrJoin(begin(), end(), "/");
+  return CachedCanonicalString(
+      [this] { return absl::StrJoin(begin(), end(), "/"); });
 }
 
 }  // namespace model
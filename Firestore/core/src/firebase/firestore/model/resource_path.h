@@ -49,7 +49,10 @@ class ResourcePath : public impl::BasePath<ResourcePath> {
    */
   static ResourcePath FromString(absl::string_view path);
 
-  /** Returns a standardized string representation of this path. */
+  /**
+   * Returns a standardized string representation of this path. The string is
+   * built on first use and cached, so later calls only copy it.
+   */
   std::string CanonicalString() const;
 
   bool operator==(const ResourcePath& rhs) const {
@@ -72,6 +75,13 @@ class ResourcePath : public impl::BasePath<ResourcePath> {
   }
 };
 
+/** A hash function for ResourcePaths, for use in unordered containers. */
+struct HashResourcePath {
+  size_t operator()(const ResourcePath& path) const {
+    return static_cast<size_t>(path.Hash());
+  }
+};
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/segment_pool.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+std::atomic<SegmentPool*> SegmentPool::default_pool_{nullptr};
+
+std::shared_ptr<const std::string> SegmentPool::Intern(
+    std::string&& segment) {
+  lookup_count_.fetch_add(1, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(table_->mutex);
+  auto& segments = table_->segments;
+  auto found = segments.find(segment);
+  if (found != segments.end()) {
+    std::shared_ptr<const std::string> interned = found->second.lock();
+    if (interned) {
+      hit_count_.fetch_add(1, std::memory_order_relaxed);
+      // Each path would otherwise have had its own copy of the segment.
+      bytes_saved_.fetch_add(sizeof(std::string) +
+                                 util::kSharedControlBlockSize +
+                                 util::StringMemoryUsage(*interned),
+                             std::memory_order_relaxed);
+      return interned;
+    }
+    // The segment is about to be released. Its entry is keyed by a view of
+    // it, so make way for the new one; Release() will see it was replaced.
+    segments.erase(found);
+  }
+
+  std::weak_ptr<Table> table = table_;
+  std::shared_ptr<const std::string> interned{
+      new std::string(std::move(segment)),
+      [table](const std::string* released) { Release(table, released); }};
+  segments.emplace(*interned, interned);
+  return interned;
+}
+
+size_t SegmentPool::size() const {
+  std::lock_guard<std::mutex> lock(table_->mutex);
+  return table_->segments.size();
+}
+
+double SegmentPool::hit_rate() const {
+  uint64_t lookups = lookup_count();
+  return lookups == 0 ? 0 : static_cast<double>(hit_count()) / lookups;
+}
+
+size_t SegmentPool::HashSegment::operator()(absl::string_view segment) const {
+  // 64-bit FNV-1a.
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : segment) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return static_cast<size_t>(hash);
+}
+
+void SegmentPool::Release(const std::weak_ptr<Table>& weak_table,
+                          const std::string* segment) {
+  std::shared_ptr<Table> table = weak_table.lock();
+  if (table) {
+    std::lock_guard<std::mutex> lock(table->mutex);
+    auto found = table->segments.find(*segment);
+    // The entry may already belong to a newer copy of the segment.
+    if (found != table->segments.end() &&
+        found->first.data() == segment->data()) {
+      table->segments.erase(found);
+    }
+  }
+  delete segment;
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_SEGMENT_POOL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_SEGMENT_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * An interning table for path segments. Collection and field names repeat
+ * across many paths, and interning them lets all those paths share a single
+ * copy of each name. Equal interned segments are the same object, so
+ * comparing paths made of them mostly comes down to comparing pointers.
+ *
+ * Interning is opt-in: paths only intern their segments while a pool is
+ * installed with SetDefault(). The pool doesn't keep segments alive; each one
+ * lives as long as some path uses it, and the pool forgets it after that.
+ *
+ * SegmentPool is thread-safe.
+ */
+class SegmentPool {
+ public:
+  SegmentPool() = default;
+
+  SegmentPool(const SegmentPool&) = delete;
+  SegmentPool& operator=(const SegmentPool&) = delete;
+
+  /**
+   * Returns the pool that paths intern their segments in, or nullptr if
+   * interning is disabled (which it is by default).
+   */
+  static SegmentPool* GetDefault() {
+    return default_pool_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Installs the pool that paths intern their segments in, or disables
+   * interning if pool is nullptr. Does not take ownership of the pool, which
+   * must remain valid until it is uninstalled and any paths being built
+   * concurrently are done. Segments already interned may outlive the pool.
+   */
+  static void SetDefault(SegmentPool* pool) {
+    default_pool_.store(pool, std::memory_order_release);
+  }
+
+  /**
+   * Returns the interned segment equal to the given one, adding it to the
+   * pool if there isn't one already.
+   */
+  std::shared_ptr<const std::string> Intern(std::string&& segment);
+
+  /** Returns the number of segments in the pool. */
+  size_t size() const;
+
+  /** Returns the number of calls to Intern(). */
+  uint64_t lookup_count() const {
+    return lookup_count_.load(std::memory_order_relaxed);
+  }
+
+  /** Returns the number of calls to Intern() that found a segment. */
+  uint64_t hit_count() const {
+    return hit_count_.load(std::memory_order_relaxed);
+  }
+
+  /** Returns the fraction of calls to Intern() that found a segment. */
+  double hit_rate() const;
+
+  /**
+   * Returns the number of bytes of segment storage that interning has saved:
+   * the heap memory that each segment found in the pool would otherwise have
+   * taken up.
+   */
+  uint64_t bytes_saved() const {
+    return bytes_saved_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /** Hashes segments in the table without copying them. */
+  struct HashSegment {
+    size_t operator()(absl::string_view segment) const;
+  };
+
+  /**
+   * The interned segments, keyed by views of their own contents so that each
+   * one is only stored once. Each segment removes itself from the table once
+   * no path uses it. Segments only refer to the table weakly, since they may
+   * outlive the pool.
+   */
+  struct Table {
+    std::mutex mutex;
+    std::unordered_map<absl::string_view,
+                       std::weak_ptr<const std::string>,
+                       HashSegment>
+        segments;
+  };
+
+  /** Deletes an interned segment, after removing it from its table. */
+  static void Release(const std::weak_ptr<Table>& weak_table,
+                      const std::string* segment);
+
+  static std::atomic<SegmentPool*> default_pool_;
+
+  std::shared_ptr<Table> table_ = std::make_shared<Table>();
+
+  std::atomic<uint64_t> lookup_count_{0};
+  std::atomic<uint64_t> hit_count_{0};
+  std::atomic<uint64_t> bytes_saved_{0};
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_SEGMENT_POOL_H_
@@ -19,6 +19,7 @@
 #include <time.h>
 
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/wire_size.h"
 
 namespace firebase {
 namespace firestore {
@@ -49,6 +50,18 @@ Timestamp Timestamp::Now() {
   return Timestamp(time(nullptr), 0);
 }
 
+size_t Timestamp::ByteSize() const {
+  // Fields with default values are omitted.
+  size_t result = 0;
+  if (seconds_ != 0) {
+    result += util::VarintFieldSize(1, static_cast<uint64_t>(seconds_));
+  }
+  if (nanos_ != 0) {
+    result += util::VarintFieldSize(2, static_cast<uint64_t>(nanos_));
+  }
+  return result;
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_TIMESTAMP_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_TIMESTAMP_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace firebase {
@@ -56,6 +57,12 @@ class Timestamp {
     return nanos_;
   }
 
+  /**
+   * Returns the size of this timestamp when serialized as a
+   * google.protobuf.Timestamp message.
+   */
+  size_t ByteSize() const;
+
  private:
   int64_t seconds_;
   int32_t nanos_;
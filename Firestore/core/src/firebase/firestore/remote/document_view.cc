@@ -0,0 +1,423 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/document_view.h"
+
+#include <pb_decode.h>
+#include <string.h>
+
+#include <string>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1beta1/document.pb.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::FieldPath;
+using model::FieldValue;
+using model::Timestamp;
+using Type = FieldValue::Type;
+
+namespace {
+
+// Document fields and map values use the same layout for their entries, so
+// one routine can look through either.
+static_assert(google_firestore_v1beta1_Document_FieldsEntry_key_tag ==
+                      google_firestore_v1beta1_MapValue_FieldsEntry_key_tag &&
+                  google_firestore_v1beta1_Document_FieldsEntry_value_tag ==
+                      google_firestore_v1beta1_MapValue_FieldsEntry_value_tag,
+              "Document and MapValue FieldsEntry messages differ");
+
+/**
+ * Wraps a nanopb input stream over a buffer, adding the ability to read
+ * length-delimited fields in place.
+ */
+class Reader {
+ public:
+  Reader(const uint8_t* bytes, size_t length)
+      : bytes_(bytes),
+        length_(length),
+        stream_(pb_istream_from_buffer(bytes, length)) {
+  }
+
+  bool empty() const {
+    return stream_.bytes_left == 0;
+  }
+
+  /** Reads the tag and wire type of the next field. */
+  uint32_t ReadTag(pb_wire_type_t* wire_type) {
+    uint32_t tag;
+    bool eof;
+    bool status = pb_decode_tag(&stream_, wire_type, &tag, &eof);
+    FIREBASE_ASSERT_MESSAGE(status, "Malformed message: bad tag");
+    return tag;
+  }
+
+  uint64_t ReadVarint() {
+    uint64_t value;
+    bool status = pb_decode_varint(&stream_, &value);
+    FIREBASE_ASSERT_MESSAGE(status, "Malformed message: bad varint");
+    return value;
+  }
+
+  uint64_t ReadFixed64() {
+    uint64_t value;
+    bool status = pb_decode_fixed64(&stream_, &value);
+    FIREBASE_ASSERT_MESSAGE(status, "Malformed message: bad fixed64");
+    return value;
+  }
+
+  /**
+   * Skips over a length-delimited field, returning where its contents are in
+   * the underlying buffer.
+   */
+  absl::string_view ReadDelimited() {
+    pb_istream_t substream;
+    bool status = pb_make_string_substream(&stream_, &substream);
+    FIREBASE_ASSERT_MESSAGE(status, "Malformed message: bad length");
+
+    // The parent stream now stands at the end of the field, so the contents
+    // are the substream's bytes_left bytes before that.
+    size_t end = length_ - stream_.bytes_left;
+    absl::string_view result{
+        reinterpret_cast<const char*>(bytes_ + end - substream.bytes_left),
+        substream.bytes_left};
+    status = pb_read(&substream, nullptr, substream.bytes_left);
+    FIREBASE_ASSERT_MESSAGE(status, "Malformed message: truncated");
+    pb_close_string_substream(&stream_, &substream);
+    return result;
+  }
+
+  void SkipField(pb_wire_type_t wire_type) {
+    bool status = pb_skip_field(&stream_, wire_type);
+    FIREBASE_ASSERT_MESSAGE(status, "Malformed message: bad field");
+  }
+
+ private:
+  const uint8_t* bytes_;
+  size_t length_;
+  pb_istream_t stream_;
+};
+
+const uint8_t* Bytes(absl::string_view value) {
+  return reinterpret_cast<const uint8_t*>(value.data());
+}
+
+void AssertWireType(pb_wire_type_t actual, pb_wire_type_t expected) {
+  FIREBASE_ASSERT_MESSAGE(actual == expected,
+                          "Malformed message: wire type %d, expected %d",
+                          actual, expected);
+}
+
+/**
+ * Looks through the given message for a FieldsEntry with the given tag and
+ * key. Entries are not sorted, so this looks at (the keys of) every entry.
+ * As when parsing a protobuf map, if several entries have the key, the last
+ * one wins.
+ */
+bool FindFieldsEntry(const uint8_t* bytes,
+                     size_t length,
+                     uint32_t fields_tag,
+                     absl::string_view key,
+                     FieldValueView* result) {
+  bool found = false;
+  Reader reader{bytes, length};
+  while (!reader.empty()) {
+    pb_wire_type_t wire_type;
+    uint32_t tag = reader.ReadTag(&wire_type);
+    if (tag != fields_tag) {
+      reader.SkipField(wire_type);
+      continue;
+    }
+    AssertWireType(wire_type, PB_WT_STRING);
+    absl::string_view entry = reader.ReadDelimited();
+
+    Reader entry_reader{Bytes(entry), entry.size()};
+    absl::string_view entry_key;
+    absl::string_view entry_value;
+    while (!entry_reader.empty()) {
+      tag = entry_reader.ReadTag(&wire_type);
+      switch (tag) {
+        case google_firestore_v1beta1_MapValue_FieldsEntry_key_tag:
+          AssertWireType(wire_type, PB_WT_STRING);
+          entry_key = entry_reader.ReadDelimited();
+          break;
+        case google_firestore_v1beta1_MapValue_FieldsEntry_value_tag:
+          AssertWireType(wire_type, PB_WT_STRING);
+          entry_value = entry_reader.ReadDelimited();
+          break;
+        default:
+          entry_reader.SkipField(wire_type);
+      }
+    }
+
+    if (entry_key == key) {
+      *result = FieldValueView{Bytes(entry_value), entry_value.size()};
+      found = true;
+    }
+  }
+  return found;
+}
+
+}  // namespace
+
+FieldValueView::FieldValueView(const uint8_t* bytes, size_t length)
+    : bytes_(bytes), length_(length) {
+  Reader reader{bytes, length};
+  bool found = false;
+  while (!reader.empty()) {
+    pb_wire_type_t wire_type;
+    uint32_t tag = reader.ReadTag(&wire_type);
+
+    // Check the wire type and record the type of the value.
+    pb_wire_type_t expected_wire_type = PB_WT_STRING;
+    switch (tag) {
+      case google_firestore_v1beta1_Value_null_value_tag:
+        type_ = Type::Null;
+        expected_wire_type = PB_WT_VARINT;
+        break;
+      case google_firestore_v1beta1_Value_boolean_value_tag:
+        type_ = Type::Boolean;
+        expected_wire_type = PB_WT_VARINT;
+        break;
+      case google_firestore_v1beta1_Value_integer_value_tag:
+        type_ = Type::Integer;
+        expected_wire_type = PB_WT_VARINT;
+        break;
+      case google_firestore_v1beta1_Value_double_value_tag:
+        type_ = Type::Double;
+        expected_wire_type = PB_WT_64BIT;
+        break;
+      case google_firestore_v1beta1_Value_timestamp_value_tag:
+        type_ = Type::Timestamp;
+        break;
+      case google_firestore_v1beta1_Value_string_value_tag:
+        type_ = Type::String;
+        break;
+      case google_firestore_v1beta1_Value_bytes_value_tag:
+        type_ = Type::Blob;
+        break;
+      case google_firestore_v1beta1_Value_reference_value_tag:
+        type_ = Type::Reference;
+        break;
+      case google_firestore_v1beta1_Value_geo_point_value_tag:
+        type_ = Type::GeoPoint;
+        break;
+      case google_firestore_v1beta1_Value_array_value_tag:
+        type_ = Type::Array;
+        break;
+      case google_firestore_v1beta1_Value_map_value_tag:
+        type_ = Type::Object;
+        break;
+      default:
+        // Skip unknown fields.
+        reader.SkipField(wire_type);
+        continue;
+    }
+    AssertWireType(wire_type, expected_wire_type);
+
+    // Like any other oneof, the last value seen wins.
+    found = true;
+    payload_ = nullptr;
+    payload_length_ = 0;
+    switch (wire_type) {
+      case PB_WT_VARINT:
+        scalar_ = reader.ReadVarint();
+        break;
+      case PB_WT_64BIT:
+        scalar_ = reader.ReadFixed64();
+        break;
+      default: {
+        absl::string_view payload = reader.ReadDelimited();
+        payload_ = Bytes(payload);
+        payload_length_ = payload.size();
+      }
+    }
+  }
+  FIREBASE_ASSERT_MESSAGE(found, "Malformed Value: no value is set");
+}
+
+bool FieldValueView::boolean_value() const {
+  FIREBASE_ASSERT(type_ == Type::Boolean);
+  return scalar_ != 0;
+}
+
+int64_t FieldValueView::integer_value() const {
+  FIREBASE_ASSERT(type_ == Type::Integer);
+  return static_cast<int64_t>(scalar_);
+}
+
+double FieldValueView::double_value() const {
+  FIREBASE_ASSERT(type_ == Type::Double);
+  double result;
+  memcpy(&result, &scalar_, sizeof(result));
+  return result;
+}
+
+Timestamp FieldValueView::timestamp_value() const {
+  FIREBASE_ASSERT(type_ == Type::Timestamp);
+  int64_t seconds = 0;
+  int32_t nanos = 0;
+  Reader reader{payload_, payload_length_};
+  while (!reader.empty()) {
+    pb_wire_type_t wire_type;
+    uint32_t tag = reader.ReadTag(&wire_type);
+    switch (tag) {
+      case google_protobuf_Timestamp_seconds_tag:
+        AssertWireType(wire_type, PB_WT_VARINT);
+        seconds = static_cast<int64_t>(reader.ReadVarint());
+        break;
+      case google_protobuf_Timestamp_nanos_tag:
+        AssertWireType(wire_type, PB_WT_VARINT);
+        nanos = static_cast<int32_t>(reader.ReadVarint());
+        break;
+      default:
+        reader.SkipField(wire_type);
+    }
+  }
+  return Timestamp{seconds, nanos};
+}
+
+absl::string_view FieldValueView::string_value() const {
+  FIREBASE_ASSERT(type_ == Type::String);
+  return {reinterpret_cast<const char*>(payload_), payload_length_};
+}
+
+absl::string_view FieldValueView::blob_value() const {
+  FIREBASE_ASSERT(type_ == Type::Blob);
+  return {reinterpret_cast<const char*>(payload_), payload_length_};
+}
+
+absl::string_view FieldValueView::reference_value() const {
+  FIREBASE_ASSERT(type_ == Type::Reference);
+  return {reinterpret_cast<const char*>(payload_), payload_length_};
+}
+
+GeoPoint FieldValueView::geo_point_value() const {
+  FIREBASE_ASSERT(type_ == Type::GeoPoint);
+  double latitude = 0;
+  double longitude = 0;
+  Reader reader{payload_, payload_length_};
+  while (!reader.empty()) {
+    pb_wire_type_t wire_type;
+    uint32_t tag = reader.ReadTag(&wire_type);
+    switch (tag) {
+      case google_type_LatLng_latitude_tag: {
+        AssertWireType(wire_type, PB_WT_64BIT);
+        uint64_t bits = reader.ReadFixed64();
+        memcpy(&latitude, &bits, sizeof(latitude));
+        break;
+      }
+      case google_type_LatLng_longitude_tag: {
+        AssertWireType(wire_type, PB_WT_64BIT);
+        uint64_t bits = reader.ReadFixed64();
+        memcpy(&longitude, &bits, sizeof(longitude));
+        break;
+      }
+      default:
+        reader.SkipField(wire_type);
+    }
+  }
+  return GeoPoint{latitude, longitude};
+}
+
+std::vector<FieldValueView> FieldValueView::array_value() const {
+  FIREBASE_ASSERT(type_ == Type::Array);
+  std::vector<FieldValueView> result;
+  Reader reader{payload_, payload_length_};
+  while (!reader.empty()) {
+    pb_wire_type_t wire_type;
+    uint32_t tag = reader.ReadTag(&wire_type);
+    if (tag != google_firestore_v1beta1_ArrayValue_values_tag) {
+      reader.SkipField(wire_type);
+      continue;
+    }
+    AssertWireType(wire_type, PB_WT_STRING);
+    absl::string_view element = reader.ReadDelimited();
+    result.emplace_back(Bytes(element), element.size());
+  }
+  return result;
+}
+
+bool FieldValueView::GetField(absl::string_view name,
+                              FieldValueView* result) const {
+  FIREBASE_ASSERT(type_ == Type::Object);
+  return FindFieldsEntry(payload_, payload_length_,
+                         google_firestore_v1beta1_MapValue_fields_tag, name,
+                         result);
+}
+
+bool FieldValueView::Get(const FieldPath& field_path,
+                         FieldValueView* result) const {
+  FIREBASE_ASSERT(type_ == Type::Object);
+  FieldValueView current = *this;
+  for (const std::string& segment : field_path) {
+    if (current.type() != Type::Object ||
+        !current.GetField(segment, &current)) {
+      return false;
+    }
+  }
+  *result = current;
+  return true;
+}
+
+FieldValue FieldValueView::ToFieldValue() const {
+  if (bytes_ == nullptr) {
+    return FieldValue::NullValue();
+  }
+  return Serializer::DecodeFieldValue(bytes_, length_);
+}
+
+absl::string_view DocumentView::name() const {
+  Reader reader{bytes_, length_};
+  absl::string_view result;
+  while (!reader.empty()) {
+    pb_wire_type_t wire_type;
+    uint32_t tag = reader.ReadTag(&wire_type);
+    if (tag == google_firestore_v1beta1_Document_name_tag) {
+      AssertWireType(wire_type, PB_WT_STRING);
+      result = reader.ReadDelimited();
+    } else {
+      reader.SkipField(wire_type);
+    }
+  }
+  return result;
+}
+
+bool DocumentView::Get(const FieldPath& field_path,
+                       FieldValueView* result) const {
+  FIREBASE_ASSERT_MESSAGE(!field_path.empty(),
+                          "Cannot get a field for an empty path");
+  FieldValueView field;
+  if (!FindFieldsEntry(bytes_, length_,
+                       google_firestore_v1beta1_Document_fields_tag,
+                       field_path.first_segment(), &field)) {
+    return false;
+  }
+  if (field_path.size() == 1) {
+    *result = field;
+    return true;
+  }
+  return field.type() == Type::Object &&
+         field.Get(field_path.PopFirst(), result);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
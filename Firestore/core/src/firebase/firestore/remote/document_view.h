@@ -0,0 +1,152 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DOCUMENT_VIEW_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DOCUMENT_VIEW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/geo_point.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/timestamp.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A read-only view of a serialized google_firestore_v1beta1_Value, which reads
+ * the value in place rather than decoding it up front the way
+ * Serializer::DecodeFieldValue does.
+ *
+ * Creating a view only locates the value within the bytes; nested values are
+ * found (and then only their own location decoded) when they're accessed, and
+ * strings and blobs are returned as string_views pointing into the bytes. This
+ * makes it cheap to look at a few fields of a large value, e.g. to filter
+ * documents, without building a FieldValue for all of it.
+ *
+ * The bytes are not owned by the view, and must outlive the view along with
+ * any views or string_views obtained from it.
+ */
+class FieldValueView {
+ public:
+  /** Creates a view of a Null value that isn't backed by any bytes. */
+  FieldValueView() {
+  }
+
+  /**
+   * Creates a view of the encoded google_firestore_v1beta1_Value in the given
+   * bytes.
+   */
+  FieldValueView(const uint8_t* bytes, size_t length);
+
+  /** Returns the type of the viewed value. */
+  model::FieldValue::Type type() const {
+    return type_;
+  }
+
+  bool boolean_value() const;
+  int64_t integer_value() const;
+  double double_value() const;
+  model::Timestamp timestamp_value() const;
+  absl::string_view string_value() const;
+  absl::string_view blob_value() const;
+
+  /** Returns the resource name of the document that a Reference refers to. */
+  absl::string_view reference_value() const;
+
+  GeoPoint geo_point_value() const;
+
+  /** Returns views of the elements of an Array value. */
+  std::vector<FieldValueView> array_value() const;
+
+  /**
+   * Looks up the field with the given name in an Object value.
+   *
+   * @return true if the field exists, in which case *result is set to a view
+   * of its value.
+   */
+  bool GetField(absl::string_view name, FieldValueView* result) const;
+
+  /**
+   * Looks up the nested field at the given path in an Object value. An empty
+   * path refers to this value itself.
+   *
+   * @return true if the field exists, in which case *result is set to a view
+   * of its value.
+   */
+  bool Get(const model::FieldPath& field_path, FieldValueView* result) const;
+
+  /** Decodes the whole of the viewed value into a FieldValue. */
+  model::FieldValue ToFieldValue() const;
+
+ private:
+  // The whole encoded Value message.
+  const uint8_t* bytes_ = nullptr;
+  size_t length_ = 0;
+
+  model::FieldValue::Type type_ = model::FieldValue::Type::Null;
+
+  // The value itself: varint and fixed64 values are decoded directly into
+  // scalar_, while anything length-delimited is left where it is in the bytes.
+  uint64_t scalar_ = 0;
+  const uint8_t* payload_ = nullptr;
+  size_t payload_length_ = 0;
+};
+
+/**
+ * A read-only view of a serialized google_firestore_v1beta1_Document. Like
+ * FieldValueView, it reads fields in place and only when they're accessed.
+ *
+ * The bytes are not owned by the view, and must outlive the view along with
+ * any views or string_views obtained from it.
+ */
+class DocumentView {
+ public:
+  /**
+   * Creates a view of the encoded google_firestore_v1beta1_Document in the
+   * given bytes.
+   */
+  DocumentView(const uint8_t* bytes, size_t length)
+      : bytes_(bytes), length_(length) {
+  }
+
+  /** Returns the resource name of the document. */
+  absl::string_view name() const;
+
+  /**
+   * Looks up the field at the given path in the document.
+   *
+   * @return true if the field exists, in which case *result is set to a view
+   * of its value.
+   */
+  bool Get(const model::FieldPath& field_path, FieldValueView* result) const;
+
+ private:
+  const uint8_t* bytes_;
+  size_t length_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DOCUMENT_VIEW_H_
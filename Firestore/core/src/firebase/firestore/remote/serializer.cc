@@ -20,9 +20,10 @@
 #include <pb_encode.h>
 
 #include <functional>
-#include <map>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
 
@@ -36,17 +37,32 @@ namespace {
 
 class Writer;
 
-void EncodeObject(Writer* writer,
-                  const std::map<std::string, FieldValue>& object_value);
+void EncodeObject(Writer* writer, const FieldValue::Map& object_value);
 
-std::map<std::string, FieldValue> DecodeObject(pb_istream_t* stream);
+/** Where the values being decoded should keep their storage. */
+struct DecodeContext {
+  /** The arena to allocate objects from, or null to use the heap. */
+  const std::shared_ptr<util::Arena>& arena;
+
+  /**
+   * The buffer being decoded, if blobs should share it rather than copy their
+   * bytes out of it; otherwise null.
+   */
+  const util::SharedBytes* source;
+
+  /**
+   * Lists that held the fields of objects already decoded, kept so that the
+   * objects decoded after them can reuse their storage.
+   */
+  std::vector<FieldValue::FieldList>* spare_field_lists;
+};
+
+FieldValue DecodeObject(pb_istream_t* stream, const DecodeContext& context);
 
 /**
  * Docs TODO(rsgowman). But currently, this just wraps the underlying nanopb
  * pb_ostream_t.
  */
-// TODO(rsgowman): Define ObjectT alias (in field_value.h) and use it
-// throughout.
 class Writer {
  public:
   /**
@@ -86,6 +102,7 @@ class Writer {
   void WriteInteger(int64_t integer_value);
 
   void WriteString(const std::string& string_value);
+  void WriteBytes(const util::SharedBytes& bytes_value);
 
   /**
    * Writes a message and its length.
@@ -284,6 +301,52 @@ std::string DecodeString(pb_istream_t* stream) {
   return result;
 }
 
+void Writer::WriteBytes(const util::SharedBytes& bytes_value) {
+  bool status = pb_encode_string(&stream_, bytes_value.data(),
+                                 bytes_value.size());
+  if (!status) {
+    // TODO(rsgowman): figure out error handling
+    abort();
+  }
+}
+
+/**
+ * Decodes a bytes field. If the context has a source buffer, the result is a
+ * slice of it; otherwise the bytes are copied out of the stream.
+ */
+util::SharedBytes DecodeBytes(pb_istream_t* stream,
+                              const DecodeContext& context) {
+  pb_istream_t substream;
+  bool status = pb_make_string_substream(stream, &substream);
+  if (!status) {
+    // TODO(rsgowman): figure out error handling
+    abort();
+  }
+
+  size_t size = substream.bytes_left;
+  util::SharedBytes result;
+  if (context.source != nullptr) {
+    // A stream over a buffer keeps its current position in its state, which
+    // locates the bytes within the source. Reading into nullptr skips them.
+    const auto* start = static_cast<const uint8_t*>(substream.state);
+    result = context.source->Slice(
+        static_cast<size_t>(start - context.source->data()), size);
+    status = pb_read(&substream, nullptr, size);
+  } else {
+    std::vector<uint8_t> bytes(size);
+    status = pb_read(&substream, bytes.data(), size);
+    result = util::SharedBytes{std::move(bytes)};
+  }
+  if (!status || substream.bytes_left != 0) {
+    // TODO(rsgowman): figure out error handling
+    abort();
+  }
+
+  pb_close_string_substream(stream, &substream);
+
+  return result;
+}
+
 // Named '..Impl' so as to not conflict with Serializer::EncodeFieldValue.
 // TODO(rsgowman): Refactor to use a helper class that wraps the stream struct.
 // This will help with error handling, and should eliminate the issue of two
@@ -316,6 +379,12 @@ void EncodeFieldValueImpl(Writer* writer, const FieldValue& field_value) {
       writer->WriteString(field_value.string_value());
       break;
 
+    case FieldValue::Type::Blob:
+      writer->WriteTag(PB_WT_STRING,
+                       google_firestore_v1beta1_Value_bytes_value_tag);
+      writer->WriteBytes(field_value.blob_value());
+      break;
+
     case FieldValue::Type::Object:
       writer->WriteTag(PB_WT_STRING,
                        google_firestore_v1beta1_Value_map_value_tag);
@@ -328,7 +397,13 @@ void EncodeFieldValueImpl(Writer* writer, const FieldValue& field_value) {
   }
 }
 
-FieldValue DecodeFieldValueImpl(pb_istream_t* stream) {
+/**
+ * Decodes a Value message from the given stream. Objects within the value, if
+ * any, are allocated from the context's arena (or the heap if it is null).
+ * Blobs share the context's source buffer, if any.
+ */
+FieldValue DecodeFieldValueImpl(pb_istream_t* stream,
+                                const DecodeContext& context) {
   pb_wire_type_t wire_type;
   uint32_t tag;
   bool eof;
@@ -350,6 +425,7 @@ FieldValue DecodeFieldValueImpl(pb_istream_t* stream) {
       break;
 
     case google_firestore_v1beta1_Value_string_value_tag:
+    case google_firestore_v1beta1_Value_bytes_value_tag:
     case google_firestore_v1beta1_Value_map_value_tag:
       if (wire_type != PB_WT_STRING) {
         abort();
@@ -370,8 +446,10 @@ FieldValue DecodeFieldValueImpl(pb_istream_t* stream) {
       return FieldValue::IntegerValue(DecodeInteger(stream));
     case google_firestore_v1beta1_Value_string_value_tag:
       return FieldValue::StringValue(DecodeString(stream));
+    case google_firestore_v1beta1_Value_bytes_value_tag:
+      return FieldValue::BlobValue(DecodeBytes(stream, context));
     case google_firestore_v1beta1_Value_map_value_tag:
-      return FieldValue::ObjectValue(DecodeObject(stream));
+      return DecodeObject(stream, context);
 
     default:
       // TODO(rsgowman): figure out error handling
@@ -428,7 +506,8 @@ void Writer::WriteNestedMessage(
   }
 }
 
-FieldValue DecodeNestedFieldValue(pb_istream_t* stream) {
+FieldValue DecodeNestedFieldValue(pb_istream_t* stream,
+                                  const DecodeContext& context) {
   // Implementation note: This is roughly modeled on pb_decode_delimited,
   // adjusted to account for the oneof in FieldValue.
   pb_istream_t substream;
@@ -438,7 +517,7 @@ FieldValue DecodeNestedFieldValue(pb_istream_t* stream) {
     abort();
   }
 
-  FieldValue fv = DecodeFieldValueImpl(&substream);
+  FieldValue fv = DecodeFieldValueImpl(&substream, context);
 
   // NB: future versions of nanopb read the remaining characters out of the
   // substream (and return false if that fails) as an additional safety
@@ -488,7 +567,8 @@ void EncodeFieldsEntry(Writer* writer,
       [&kv](Writer* writer) { EncodeFieldValueImpl(writer, kv.second); });
 }
 
-std::pair<std::string, FieldValue> DecodeFieldsEntry(pb_istream_t* stream) {
+std::pair<std::string, FieldValue> DecodeFieldsEntry(
+    pb_istream_t* stream, const DecodeContext& context) {
   pb_wire_type_t wire_type;
   uint32_t tag;
   bool eof;
@@ -508,13 +588,12 @@ std::pair<std::string, FieldValue> DecodeFieldsEntry(pb_istream_t* stream) {
   FIREBASE_ASSERT(!eof);
   FIREBASE_ASSERT(status);
 
-  FieldValue value = DecodeNestedFieldValue(stream);
+  FieldValue value = DecodeNestedFieldValue(stream, context);
 
   return {key, value};
 }
 
-void EncodeObject(Writer* writer,
-                  const std::map<std::string, FieldValue>& object_value) {
+void EncodeObject(Writer* writer, const FieldValue::Map& object_value) {
   writer->WriteNestedMessage([&object_value](Writer* writer) {
     // Write each FieldsEntry (i.e. key-value pair.)
     for (const auto& kv : object_value) {
@@ -528,30 +607,74 @@ void EncodeObject(Writer* writer,
   });
 }
 
-std::map<std::string, FieldValue> DecodeObject(pb_istream_t* stream) {
+/**
+ * Counts the FieldsEntries in the MapValue at the front of the given stream,
+ * without consuming it. Entries are skipped over rather than decoded, so this
+ * is cheap relative to decoding them.
+ */
+size_t CountFieldsEntries(const pb_istream_t& stream) {
+  // Streams over a buffer can be copied; reading from the copy leaves the
+  // original where it was.
+  pb_istream_t copy = stream;
+  pb_istream_t substream;
+  bool status = pb_make_string_substream(&copy, &substream);
+  if (!status) {
+    // TODO(rsgowman): figure out error handling
+    abort();
+  }
+
+  size_t count = 0;
+  while (substream.bytes_left > 0) {
+    pb_wire_type_t wire_type;
+    uint32_t tag;
+    bool eof;
+    status = pb_decode_tag(&substream, &wire_type, &tag, &eof) &&
+             pb_skip_field(&substream, wire_type);
+    if (!status) {
+      // TODO(rsgowman): figure out error handling
+      abort();
+    }
+    if (tag == google_firestore_v1beta1_MapValue_fields_tag) {
+      count++;
+    }
+  }
+  return count;
+}
+
+FieldValue DecodeObject(pb_istream_t* stream, const DecodeContext& context) {
   google_firestore_v1beta1_MapValue map_value =
       google_firestore_v1beta1_MapValue_init_zero;
-  std::map<std::string, FieldValue> result;
+  // Objects nested in this one are decoded while its fields are collected, so
+  // each level of nesting needs a list of its own.
+  std::vector<FieldValue::FieldList>& spares = *context.spare_field_lists;
+  FieldValue::FieldList fields;
+  if (!spares.empty()) {
+    fields = std::move(spares.back());
+    spares.pop_back();
+  }
+  // Size the list up front: growing it would copy every entry.
+  fields.reserve(CountFieldsEntries(*stream));
   // NB: c-style callbacks can't use *capturing* lambdas, so we'll pass in the
-  // object_value via the arg field (and therefore need to do a bunch of
-  // casting).
+  // object_value (and the context for nested objects) via the arg field (and
+  // therefore need to do a bunch of casting).
+  struct DecodeState {
+    FieldValue::FieldList* fields;
+    const DecodeContext* context;
+  };
+  DecodeState state{&fields, &context};
   map_value.fields.funcs.decode = [](pb_istream_t* stream, const pb_field_t*,
                                      void** arg) -> bool {
-    auto& result = *static_cast<std::map<std::string, FieldValue>*>(*arg);
-
-    std::pair<std::string, FieldValue> fv = DecodeFieldsEntry(stream);
+    auto& state = *static_cast<DecodeState*>(*arg);
 
-    // Sanity check: ensure that this key doesn't already exist in the map.
+    // Add this key,fieldvalue to the results map. Entries may arrive in any
+    // order; FieldValue::FromFields sorts them and checks that no key repeats.
     // TODO(rsgowman): figure out error handling: We can do better than a failed
-    // assertion.
-    FIREBASE_ASSERT(result.find(fv.first) == result.end());
-
-    // Add this key,fieldvalue to the results map.
-    result.emplace(std::move(fv));
+    // assertion on duplicate keys.
+    state.fields->push_back(DecodeFieldsEntry(stream, *state.context));
 
     return true;
   };
-  map_value.fields.arg = &result;
+  map_value.fields.arg = &state;
 
   bool status = pb_decode_delimited(
       stream, google_firestore_v1beta1_MapValue_fields, &map_value);
@@ -560,6 +683,8 @@ std::map<std::string, FieldValue> DecodeObject(pb_istream_t* stream) {
     abort();
   }
 
+  FieldValue result = FieldValue::FromFields(&fields, context.arena);
+  spares.push_back(std::move(fields));
   return result;
 }
 
@@ -572,8 +697,25 @@ void Serializer::EncodeFieldValue(const FieldValue& field_value,
 }
 
 FieldValue Serializer::DecodeFieldValue(const uint8_t* bytes, size_t length) {
+  return DecodeFieldValue(bytes, length, nullptr);
+}
+
+FieldValue Serializer::DecodeFieldValue(
+    const uint8_t* bytes,
+    size_t length,
+    const std::shared_ptr<util::Arena>& arena) {
   pb_istream_t stream = pb_istream_from_buffer(bytes, length);
-  return DecodeFieldValueImpl(&stream);
+  std::vector<FieldValue::FieldList> spare_field_lists;
+  return DecodeFieldValueImpl(
+      &stream, DecodeContext{arena, nullptr, &spare_field_lists});
+}
+
+FieldValue Serializer::DecodeFieldValue(
+    const util::SharedBytes& bytes, const std::shared_ptr<util::Arena>& arena) {
+  pb_istream_t stream = pb_istream_from_buffer(bytes.data(), bytes.size());
+  std::vector<FieldValue::FieldList> spare_field_lists;
+  return DecodeFieldValueImpl(
+      &stream, DecodeContext{arena, &bytes, &spare_field_lists});
 }
 
 }  // namespace remote
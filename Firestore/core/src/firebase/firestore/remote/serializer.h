@@ -19,11 +19,15 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+
+#include <memory>
 #include <vector>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1beta1/document.pb.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/shared_bytes.h"
 
 namespace firebase {
 namespace firestore {
@@ -98,6 +102,50 @@ class Serializer {
     return DecodeFieldValue(bytes.data(), bytes.size());
   }
 
+  /**
+   * @brief Converts from bytes to the model FieldValue format, allocating the
+   * objects within the value from the given arena.
+   *
+   * Decoding a large value this way takes a few allocations per arena block
+   * instead of several per object, and the memory is released all at once
+   * when the last reference into the arena (from the result or any value
+   * within it) is dropped. Objects with more than FieldValue::Map::kFixedSize
+   * fields are the exception: their fields are kept in a tree on the heap.
+   * Values built later from parts of the result, e.g. by FieldValue::Set(),
+   * are allocated on the heap as usual.
+   *
+   * @param bytes The bytes to convert. It's assumed that exactly all of the
+   * bytes will be used by this conversion.
+   * @param arena The arena to allocate from, or nullptr to use the heap. It
+   * must not be in use by another thread during decoding.
+   * @return The model equivalent of the bytes.
+   */
+  // TODO(rsgowman): error handling.
+  static firebase::firestore::model::FieldValue DecodeFieldValue(
+      const uint8_t* bytes,
+      size_t length,
+      const std::shared_ptr<firebase::firestore::util::Arena>& arena);
+
+  /**
+   * @brief Converts from bytes to the model FieldValue format, without copying
+   * the contents of any blobs in the value.
+   *
+   * Blob values in the result are slices of the given bytes, so they share
+   * (and keep alive) the buffer instead of holding copies of their own. Their
+   * memory usage accordingly includes the whole buffer.
+   *
+   * @param bytes The bytes to convert. It's assumed that exactly all of the
+   * bytes will be used by this conversion.
+   * @param arena The arena to allocate objects from, or nullptr to use the
+   * heap, as above.
+   * @return The model equivalent of the bytes.
+   */
+  // TODO(rsgowman): error handling.
+  static firebase::firestore::model::FieldValue DecodeFieldValue(
+      const firebase::firestore::util::SharedBytes& bytes,
+      const std::shared_ptr<firebase::firestore::util::Arena>& arena =
+          nullptr);
+
  private:
   // TODO(rsgowman): We don't need the database_id_ yet (but will eventually).
   // const firebase::firestore::model::DatabaseId& database_id_;
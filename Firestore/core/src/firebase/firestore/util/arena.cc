@@ -0,0 +1,60 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
+
+#include <stdint.h>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+constexpr size_t Arena::kDefaultBlockSize;
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+  FIREBASE_ASSERT_MESSAGE(
+      alignment != 0 && (alignment & (alignment - 1)) == 0 &&
+          alignment <= alignof(max_align_t),
+      "Unsupported alignment %zu", alignment);
+
+  size_t padding =
+      (alignment - reinterpret_cast<uintptr_t>(next_) % alignment) % alignment;
+  if (padding + size > remaining_) {
+    // Allocations that are large relative to the block size get a block of
+    // their own, leaving the current block to be filled by smaller ones.
+    if (size > block_size_ / 4) {
+      blocks_.emplace_back(new char[size]);
+      bytes_allocated_ += size;
+      return blocks_.back().get();
+    }
+    blocks_.emplace_back(new char[block_size_]);
+    next_ = blocks_.back().get();
+    remaining_ = block_size_;
+    padding = 0;
+  }
+
+  void* result = next_ + padding;
+  next_ += padding + size;
+  remaining_ -= padding + size;
+  bytes_allocated_ += size;
+  return result;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ARENA_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ARENA_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A region of memory from which many small objects can be allocated cheaply
+ * and then freed all at once, when the Arena itself is destroyed.
+ *
+ * Allocation bumps a pointer through blocks of memory obtained from the heap,
+ * so building a large tree of objects in an Arena costs a handful of mallocs
+ * rather than one per node. Individual allocations are never freed; objects
+ * placed in the Arena must still be destroyed (if they have non-trivial
+ * destructors) but their memory is only returned with the Arena's.
+ *
+ * An Arena is not thread-safe: it is meant to be filled by a single thread
+ * while building something, such as a decoded document, and then only read.
+ */
+class Arena {
+ public:
+  /** The default size of the blocks an Arena allocates from. */
+  static constexpr size_t kDefaultBlockSize = 4096;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize)
+      : block_size_(block_size) {
+  }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Returns size bytes of memory aligned to the given alignment, which must be
+   * a power of two no greater than alignof(max_align_t).
+   */
+  void* Allocate(size_t size, size_t alignment);
+
+  /** Returns the total number of bytes handed out by Allocate(). */
+  size_t bytes_allocated() const {
+    return bytes_allocated_;
+  }
+
+  /** Returns the number of blocks obtained from the heap so far. */
+  size_t block_count() const {
+    return blocks_.size();
+  }
+
+ private:
+  size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* next_ = nullptr;
+  size_t remaining_ = 0;
+  size_t bytes_allocated_ = 0;
+};
+
+/**
+ * A standard allocator that allocates from an Arena, or from the heap if it
+ * was created without one (which is also what a default-constructed
+ * ArenaAllocator does). This is much like a std::pmr::polymorphic_allocator
+ * with a choice of two memory resources.
+ *
+ * Every ArenaAllocator using an Arena shares ownership of it, so the Arena
+ * lives until the last object allocated from it (or rather, the last
+ * container or shared_ptr holding such an allocator) is gone.
+ *
+ * Copying a container doesn't propagate the allocator: the copy is made on
+ * the heap. This keeps the Arena from being written to again once built, and
+ * keeps copies from extending its lifetime.
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  /** Creates an allocator that allocates from the heap. */
+  ArenaAllocator() {
+  }
+
+  /** Creates an allocator that allocates from the given arena. */
+  explicit ArenaAllocator(std::shared_ptr<Arena> arena)
+      : arena_(std::move(arena)) {
+  }
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other)  // NOLINT(runtime/explicit)
+      : arena_(other.arena()) {
+  }
+
+  /** Returns the arena this allocates from, or nullptr for the heap. */
+  const std::shared_ptr<Arena>& arena() const {
+    return arena_;
+  }
+
+  T* allocate(size_t n) {
+    if (arena_) {
+      return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t) {
+    // Memory in an arena is freed along with the arena.
+    if (!arena_) {
+      ::operator delete(p);
+    }
+  }
+
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator{};
+  }
+
+ private:
+  std::shared_ptr<Arena> arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ARENA_H_
@@ -66,6 +66,16 @@ constexpr ComparisonResult ReverseOrder(ComparisonResult result) {
   return static_cast<ComparisonResult>(-static_cast<int>(result));
 }
 
+/**
+ * Converts the result of a C-style comparison (e.g. memcmp or
+ * std::string::compare) into a ComparisonResult.
+ */
+constexpr ComparisonResult ComparisonResultFromInt(int value) {
+  return value < 0 ? ComparisonResult::Ascending
+                   : value > 0 ? ComparisonResult::Descending
+                               : ComparisonResult::Same;
+}
+
 /**
  * A generalized comparator for types in Firestore, with ordering defined
  * according to Firestore's semantics. This is useful as argument to e.g.
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_HASHING_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_HASHING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * Scrambles the bits of a hash value so that inputs differing in a single bit
+ * produce unrelated outputs. std::hash is the identity for integers on common
+ * standard libraries, so their hashes need mixing before being combined.
+ *
+ * This is the finalizer of SplitMix64.
+ */
+inline uint64_t MixHash(uint64_t value) {
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return value;
+}
+
+/**
+ * Mixes the given hash value into a running hash, in the manner of
+ * boost::hash_combine. The result depends on the order values are combined
+ * in.
+ */
+inline size_t HashCombine(size_t seed, uint64_t value) {
+  uint64_t result = seed;
+  result ^= MixHash(value) + 0x9e3779b97f4a7c15ULL + (result << 6) +
+            (result >> 2);
+  return static_cast<size_t>(result);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_HASHING_H_
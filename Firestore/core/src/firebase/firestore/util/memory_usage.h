@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MEMORY_USAGE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MEMORY_USAGE_H_
+
+// Helpers for the MemoryUsage() methods of model types and immutable
+// collections, which estimate how much memory an object retains.
+//
+// The estimates count the objects themselves and the heap allocations they
+// own or share, but not the allocator's own bookkeeping, so they are somewhat
+// lower than what the allocator actually hands out.
+
+#include <stddef.h>
+
+#include <string>
+#include <unordered_set>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A set of the shared allocations (e.g. the contents of FieldValue arrays and
+ * objects) that have already been counted. Passing the same set to the
+ * MemoryUsage() methods of several objects counts storage shared between
+ * them only once.
+ */
+using CountedAllocations = std::unordered_set<const void*>;
+
+/**
+ * The approximate size of the control block that std::make_shared places
+ * alongside a shared object: a vtable pointer and two reference counts.
+ */
+constexpr size_t kSharedControlBlockSize = sizeof(void*) + 2 * sizeof(int);
+
+/**
+ * Returns true if the shared allocation at the given address should be
+ * counted, recording it in counted (if not null) so that it is not counted
+ * again.
+ */
+inline bool CountOnce(const void* allocation, CountedAllocations* counted) {
+  return counted == nullptr || counted->insert(allocation).second;
+}
+
+/**
+ * Returns the heap memory owned by the given string: nothing if it is short
+ * enough to be stored inline, otherwise its capacity (and terminator).
+ */
+inline size_t StringMemoryUsage(const std::string& value) {
+  const char* data = value.data();
+  const char* object = reinterpret_cast<const char*>(&value);
+  bool inline_storage = data >= object && data < object + sizeof(value);
+  return inline_storage ? 0 : value.capacity() + 1;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MEMORY_USAGE_H_
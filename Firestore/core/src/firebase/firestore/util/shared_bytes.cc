@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/shared_bytes.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+SharedBytes::SharedBytes(const uint8_t* data, size_t size)
+    : SharedBytes(std::vector<uint8_t>(data, data + size)) {
+}
+
+SharedBytes::SharedBytes(std::vector<uint8_t>&& bytes) {
+  if (bytes.empty()) {
+    return;
+  }
+  auto storage = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+  data_ = storage->data();
+  size_ = storage->size();
+  owner_size_ = storage->capacity();
+  owner_ = std::move(storage);
+}
+
+SharedBytes SharedBytes::Wrap(std::shared_ptr<const void> owner,
+                              size_t owner_size,
+                              const uint8_t* data,
+                              size_t size) {
+  if (size == 0) {
+    return SharedBytes{};
+  }
+  return SharedBytes{std::move(owner), owner_size, data, size};
+}
+
+SharedBytes SharedBytes::Slice(size_t offset, size_t size) const {
+  FIREBASE_ASSERT_MESSAGE(offset <= size_ && size <= size_ - offset,
+                          "Slice [%zu, %zu) is out of bounds for %zu bytes",
+                          offset, offset + size, size_);
+  return Wrap(owner_, owner_size_, data_ + offset, size);
+}
+
+ComparisonResult SharedBytes::Compare(const SharedBytes& other) const {
+  size_t size = std::min(size_, other.size_);
+  if (size > 0) {
+    int cmp = memcmp(data_, other.data_, size);
+    if (cmp != 0) {
+      return ComparisonResultFromInt(cmp);
+    }
+  }
+  if (size_ != other.size_) {
+    return size_ < other.size_ ? ComparisonResult::Ascending
+                               : ComparisonResult::Descending;
+  }
+  return ComparisonResult::Same;
+}
+
+size_t SharedBytes::HeapMemoryUsage(CountedAllocations* counted) const {
+  if (owner_ && CountOnce(owner_.get(), counted)) {
+    return kSharedControlBlockSize + owner_size_;
+  }
+  return 0;
+}
+
+bool operator==(const SharedBytes& lhs, const SharedBytes& rhs) {
+  return lhs.size() == rhs.size() &&
+         (lhs.data() == rhs.data() ||
+          memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SHARED_BYTES_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SHARED_BYTES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/memory_usage.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * An immutable sequence of bytes whose storage is reference counted, so
+ * copying a SharedBytes is O(1) and never copies the bytes themselves.
+ *
+ * The bytes may be a slice of a larger buffer owned by something else, such
+ * as a serialized message that values were decoded from. The SharedBytes
+ * then keeps the whole of that buffer alive, which lets decoders hand out
+ * parts of their input without copying them.
+ */
+class SharedBytes {
+ public:
+  using const_iterator = const uint8_t*;
+
+  /** Creates an empty SharedBytes, without allocating anything. */
+  SharedBytes() {
+  }
+
+  /** Creates a SharedBytes holding a copy of the given bytes. */
+  SharedBytes(const uint8_t* data, size_t size);
+
+  /** Creates a SharedBytes that takes over the given bytes without copying. */
+  explicit SharedBytes(std::vector<uint8_t>&& bytes);
+
+  /**
+   * Creates a SharedBytes referring to the given bytes, which must remain
+   * valid and unchanged for as long as owner is alive. The SharedBytes (and
+   * every copy and slice of it) shares ownership of owner.
+   *
+   * @param owner_size The heap memory retained by owner, e.g. the capacity of
+   *     the buffer the bytes are part of, which HeapMemoryUsage() reports.
+   */
+  static SharedBytes Wrap(std::shared_ptr<const void> owner,
+                          size_t owner_size,
+                          const uint8_t* data,
+                          size_t size);
+
+  /**
+   * Returns the size bytes starting at offset, sharing this SharedBytes'
+   * storage rather than copying them.
+   */
+  SharedBytes Slice(size_t offset, size_t size) const;
+
+  /** Returns the bytes, or nullptr if there are none. */
+  const uint8_t* data() const {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const_iterator begin() const {
+    return data_;
+  }
+
+  const_iterator end() const {
+    return data_ + size_;
+  }
+
+  uint8_t operator[](size_t index) const {
+    return data_[index];
+  }
+
+  /** Compares the bytes lexicographically, shorter sorting first on a tie. */
+  ComparisonResult Compare(const SharedBytes& other) const;
+
+  /**
+   * Returns the heap memory retained by this SharedBytes: the whole of the
+   * storage it shares, and the reference count that shares it. Storage
+   * already recorded in counted (if not null) is not counted again.
+   *
+   * For a slice, this is the whole of the underlying buffer, since the slice
+   * keeps all of it alive. Passing the same counted set for several slices
+   * of one buffer counts the buffer once.
+   */
+  size_t HeapMemoryUsage(CountedAllocations* counted = nullptr) const;
+
+ private:
+  SharedBytes(std::shared_ptr<const void> owner,
+              size_t owner_size,
+              const uint8_t* data,
+              size_t size)
+      : owner_(std::move(owner)),
+        owner_size_(owner_size),
+        data_(data),
+        size_(size) {
+  }
+
+  std::shared_ptr<const void> owner_;
+  size_t owner_size_ = 0;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+bool operator==(const SharedBytes& lhs, const SharedBytes& rhs);
+
+inline bool operator!=(const SharedBytes& lhs, const SharedBytes& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SHARED_BYTES_H_
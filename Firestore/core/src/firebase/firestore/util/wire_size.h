@@ -0,0 +1,70 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WIRE_SIZE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WIRE_SIZE_H_
+
+// Functions for computing the size of protocol buffer fields in the wire
+// format, for the ByteSize() methods of model types. These let the model
+// report how large an object is when serialized without depending on the
+// serializer (or actually serializing anything).
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** Returns the number of bytes in the varint encoding of the given value. */
+inline size_t VarintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+/** Returns the size of the tag of the field with the given number. */
+inline size_t TagSize(uint32_t field_number) {
+  // The wire type takes up the low three bits.
+  return VarintSize(static_cast<uint64_t>(field_number) << 3);
+}
+
+/** Returns the size of a varint field, including its tag. */
+inline size_t VarintFieldSize(uint32_t field_number, uint64_t value) {
+  return TagSize(field_number) + VarintSize(value);
+}
+
+/** Returns the size of a 64-bit (e.g. double) field, including its tag. */
+inline size_t Fixed64FieldSize(uint32_t field_number) {
+  return TagSize(field_number) + 8;
+}
+
+/**
+ * Returns the size of a length-delimited (string, bytes or message) field
+ * with contents of the given length, including its tag and length.
+ */
+inline size_t LengthDelimitedFieldSize(uint32_t field_number, size_t length) {
+  return TagSize(field_number) + VarintSize(length) + length;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WIRE_SIZE_H_
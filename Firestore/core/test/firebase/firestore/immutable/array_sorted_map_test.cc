@@ -16,10 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
 
-#include <numeric>
-#include <random>
-
-#include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -29,123 +26,6 @@ namespace immutable {
 typedef ArraySortedMap<int, int> IntMap;
 constexpr IntMap::size_type kFixedSize = IntMap::kFixedSize;
 
-template <typename K, typename V>
-testing::AssertionResult NotFound(const ArraySortedMap<K, V>& set,
-                                  const K& key) {
-  auto found = set.find(key);
-  if (found == set.end()) {
-    return testing::AssertionSuccess();
-  } else {
-    return testing::AssertionFailure()
-           << "Should not have found (" << found->first << ", " << found->second
-           << ") @ " << found;
-  }
-}
-
-template <typename K, typename V>
-testing::AssertionResult Found(const ArraySortedMap<K, V>& map,
-                               const K& key,
-                               const V& expected) {
-  auto found = map.find(key);
-  if (found == map.end()) {
-    return testing::AssertionFailure() << "Did not find key " << key;
-  }
-  if (found->second == expected) {
-    return testing::AssertionSuccess();
-  } else {
-    return testing::AssertionFailure() << "Found entry was (" << found->first
-                                       << ", " << found->second << ")";
-  }
-}
-
-/**
- * Creates a vector containing a sequence of integers from the given starting
- * element up to, but not including, the given end element, with values
- * incremented by the given step.
- *
- * If step is negative the sequence is in descending order (but still starting
- * at start and ending before end).
- */
-std::vector<int> Sequence(int start, int end, int step = 1) {
-  std::vector<int> result;
-  if (step > 0) {
-    for (int i = start; i < end; i += step) {
-      result.push_back(i);
-    }
-  } else {
-    for (int i = start; i > end; i += step) {
-      result.push_back(i);
-    }
-  }
-  return result;
-}
-
-/**
- * Creates a vector containing a sequence of integers with the given number of
- * elements, from zero up to, but not including the given value.
- */
-std::vector<int> Sequence(int num_elements) {
-  return Sequence(0, num_elements);
-}
-
-/**
- * Creates a copy of the given vector with contents shuffled randomly.
- */
-std::vector<int> Shuffled(const std::vector<int>& values) {
-  std::vector<int> result(values);
-  util::SecureRandom rng;
-  std::shuffle(result.begin(), result.end(), rng);
-  return result;
-}
-
-/**
- * Creates a copy of the given vector with contents sorted.
- */
-std::vector<int> Sorted(const std::vector<int>& values) {
-  std::vector<int> result(values);
-  std::sort(result.begin(), result.end());
-  return result;
-}
-
-/**
- * Creates a vector of pairs where each pair has the same first and second
- * corresponding to an element in the given vector.
- */
-std::vector<std::pair<int, int>> Pairs(const std::vector<int>& values) {
-  std::vector<std::pair<int, int>> result;
-  for (auto&& value : values) {
-    result.emplace_back(value, value);
-  }
-  return result;
-}
-
-/**
- * Creates an ArraySortedMap by inserting a pair for each value in the vector.
- * Each pair will have the same key and value.
- */
-IntMap ToMap(const std::vector<int>& values) {
-  IntMap result;
-  for (auto&& value : values) {
-    result = result.insert(value, value);
-  }
-  return result;
-}
-
-/**
- * Appends the contents of the given container to a new vector.
- */
-template <typename Container>
-std::vector<typename Container::value_type> Append(const Container& container) {
-  std::vector<typename Container::value_type> result;
-  result.insert(result.begin(), container.begin(), container.end());
-  return result;
-}
-
-// TODO(wilhuff): ReverseTraversal
-
-#define ASSERT_SEQ_EQ(x, y) ASSERT_EQ((x), Append(y));
-#define EXPECT_SEQ_EQ(x, y) EXPECT_EQ((x), Append(y));
-
 TEST(ArraySortedMap, SearchForSpecificKey) {
   IntMap map{{1, 3}, {2, 4}};
 
@@ -238,7 +118,7 @@ TEST(ArraySortedMap, Override) {
 
 TEST(ArraySortedMap, ChecksSize) {
   std::vector<int> to_insert = Sequence(kFixedSize);
-  IntMap map = ToMap(to_insert);
+  IntMap map = ToMap<IntMap>(to_insert);
 
   // Replacing an existing entry should not hit increase size
   map = map.insert(5, 10);
@@ -281,7 +161,7 @@ TEST(ArraySortedMap, InsertionAndRemovalOfMaxItems) {
   std::vector<int> to_remove = Shuffled(to_insert);
 
   // Add them to the map
-  IntMap map = ToMap(to_insert);
+  IntMap map = ToMap<IntMap>(to_insert);
   ASSERT_EQ(expected_size, map.size())
       << "Check if all N objects are in the map";
 
@@ -297,13 +177,94 @@ TEST(ArraySortedMap, InsertionAndRemovalOfMaxItems) {
 TEST(ArraySortedMap, BalanceProblem) {
   std::vector<int> to_insert{1, 7, 8, 5, 2, 6, 4, 0, 3};
 
-  IntMap map = ToMap(to_insert);
+  IntMap map = ToMap<IntMap>(to_insert);
   ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
 }
 
-// TODO(wilhuff): Iterators
+TEST(ArraySortedMap, CreatesFromSortedRange) {
+  std::vector<std::pair<int, int>> entries = Pairs(Sequence(kFixedSize));
+  IntMap map = IntMap::FromSorted(entries.begin(), entries.end());
+  EXPECT_SEQ_EQ(entries, map);
 
-// TODO(wilhuff): IndexOf
+  IntMap empty = IntMap::FromSorted(entries.begin(), entries.begin());
+  EXPECT_TRUE(empty.empty());
+}
+
+TEST(ArraySortedMap, MergesMaps) {
+  IntMap evens = ToMap<IntMap>(Sequence(0, 20, 2));
+  IntMap odds = ToMap<IntMap>(Sequence(1, 20, 2));
+  EXPECT_SEQ_EQ(Pairs(Sequence(20)), evens.merge(odds));
+  EXPECT_SEQ_EQ(Pairs(Sequence(20)), odds.merge(evens));
+
+  IntMap other{{2, -2}, {3, 3}};
+  IntMap merged = evens.merge(other);
+  EXPECT_EQ(11u, merged.size());
+  EXPECT_TRUE(Found(merged, 2, -2));
+  EXPECT_TRUE(Found(merged, 3, 3));
+}
+
+TEST(ArraySortedMap, MergeAvoidsCopying) {
+  IntMap map = ToMap<IntMap>(Sequence(10));
+  IntMap empty;
+  EXPECT_EQ(map.begin(), map.merge(empty).begin());
+  EXPECT_EQ(map.begin(), empty.merge(map).begin());
+  EXPECT_EQ(map.begin(), map.merge(ToMap<IntMap>(Sequence(2, 5))).begin());
+}
+
+TEST(ArraySortedMap, BuildsMaps) {
+  IntMap::Builder builder;
+  for (int i : Shuffled(Sequence(kFixedSize))) {
+    builder.insert(i, i);
+  }
+  builder.insert(3, -3).erase(4).erase(100);
+  EXPECT_EQ(kFixedSize - 1, builder.size());
+  EXPECT_TRUE(Found(builder, 3, -3));
+  EXPECT_TRUE(NotFound(builder, 4));
+
+  IntMap map = builder.Build();
+  EXPECT_EQ(kFixedSize - 1, map.size());
+  EXPECT_TRUE(Found(map, 3, -3));
+  EXPECT_TRUE(NotFound(map, 4));
+  EXPECT_TRUE(Found(map, 5, 5));
+}
+
+TEST(ArraySortedMap, BuilderUpdatesInPlace) {
+  IntMap map = ToMap<IntMap>(Sequence(10));
+  IntMap::Builder builder{map};
+  EXPECT_EQ(map.begin(), builder.begin());
+
+  // The first change copies the array, and later ones reuse the copy while
+  // the entries fit in it.
+  builder.insert(10, 10);
+  auto entries = builder.begin();
+  EXPECT_NE(map.begin(), entries);
+  builder.erase(0).insert(11, 11).insert(5, -5);
+  EXPECT_EQ(entries, builder.begin());
+
+  // The built map shares the array.
+  IntMap built = builder.Build();
+  EXPECT_EQ(entries, built.begin());
+  EXPECT_SEQ_EQ(Pairs(Sequence(10)), map);
+}
+
+TEST(ArraySortedMap, BuilderBuildsRightSizedMaps) {
+  IntMap map = ToMap<IntMap>(Sequence(10));
+  IntMap::Builder builder{map};
+  builder.insert(10, 10).insert(11, 11).erase(0);
+  EXPECT_EQ(ToMap<IntMap>(Sequence(1, 12)).MemoryUsage(),
+            builder.Build().MemoryUsage());
+}
+
+TEST(ArraySortedMap, BuilderDoesNotChangeBuiltMaps) {
+  IntMap::Builder builder;
+  builder.insert(1, 1);
+  IntMap first = builder.Build();
+
+  builder.insert(2, 2).erase(1);
+  IntMap second = builder.Build();
+  EXPECT_SEQ_EQ(Pairs(Sequence(1, 2)), first);
+  EXPECT_SEQ_EQ(Pairs(Sequence(2, 3)), second);
+}
 
 TEST(ArraySortedMap, AvoidsCopying) {
   IntMap map = IntMap().insert(10, 20);
@@ -321,6 +282,33 @@ TEST(ArraySortedMap, AvoidsCopying) {
   EXPECT_EQ(found, duped_found);
 }
 
+TEST(ArraySortedMap, MemoryUsage) {
+  IntMap empty;
+  EXPECT_EQ(sizeof(IntMap), empty.MemoryUsage());
+
+  IntMap map = empty.insert(1, 2);
+  size_t usage = map.MemoryUsage();
+  EXPECT_LT(sizeof(IntMap) + sizeof(IntMap::array_type), usage);
+
+  // The array holds just the entries in the map.
+  EXPECT_EQ(usage + sizeof(IntMap::value_type),
+            map.insert(3, 4).MemoryUsage());
+  EXPECT_EQ(usage, map.insert(3, 4).erase(1).MemoryUsage());
+
+  // Copies share the array, which is counted once given a set.
+  IntMap copy = map;
+  util::CountedAllocations counted;
+  EXPECT_EQ(usage, map.MemoryUsage(&counted));
+  EXPECT_EQ(sizeof(IntMap), copy.MemoryUsage(&counted));
+  EXPECT_EQ(usage, copy.MemoryUsage());
+}
+
+TEST(ArraySortedMap, RangeApis) {
+  for (int n = 0; n <= static_cast<int>(kFixedSize); n++) {
+    CheckRangeApis(ToMap<IntMap>(Sequence(0, 2 * n, 2)), n);
+  }
+}
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+typedef BTreeSortedMap<int, int> IntMap;
+typedef IntMap::node_type IntNode;
+
+constexpr IntNode::size_type kMinEntries = IntNode::kMinEntries;
+constexpr IntNode::size_type kMaxEntries = IntNode::kMaxEntries;
+
+/**
+ * Checks the invariants of a B-tree below the given node and returns its
+ * height.
+ */
+int CheckInvariants(const IntNode& node, bool root) {
+  IntNode::size_type entries = node.entries().size();
+  EXPECT_LE(entries, kMaxEntries);
+  if (!root) {
+    EXPECT_GE(entries, kMinEntries) << "Too few entries";
+  }
+  for (IntNode::size_type i = 1; i < entries; i++) {
+    EXPECT_LT(node.entries()[i - 1].first, node.entries()[i].first);
+  }
+  if (node.leaf()) {
+    EXPECT_EQ(entries, node.size());
+    return 1;
+  }
+
+  IntNode::size_type size = entries;
+  int height = CheckInvariants(node.child(0), false);
+  for (IntNode::size_type i = 0; i <= entries; i++) {
+    const IntNode& child = node.child(i);
+    if (i > 0) {
+      EXPECT_EQ(height, CheckInvariants(child, false)) << "Unbalanced";
+      EXPECT_LT(node.entries()[i - 1].first, child.entries()[0].first);
+    }
+    if (i < entries) {
+      EXPECT_LT(child.entries()[child.entries().size() - 1].first,
+                node.entries()[i].first);
+    }
+    size += child.size();
+  }
+  EXPECT_EQ(size, node.size());
+  return height + 1;
+}
+
+void CheckInvariants(const IntMap& map) {
+  if (!map.empty()) {
+    CheckInvariants(map.root(), true);
+  }
+}
+
+TEST(BTreeSortedMap, SearchForSpecificKey) {
+  IntMap map{{1, 3}, {2, 4}};
+
+  ASSERT_TRUE(Found(map, 1, 3));
+  ASSERT_TRUE(Found(map, 2, 4));
+  ASSERT_TRUE(NotFound(map, 3));
+}
+
+TEST(BTreeSortedMap, RemoveKeyValuePair) {
+  IntMap map{{1, 3}, {2, 4}};
+
+  IntMap new_map = map.erase(1);
+  ASSERT_TRUE(Found(new_map, 2, 4));
+  ASSERT_TRUE(NotFound(new_map, 1));
+
+  // Make sure the original one is not mutated
+  ASSERT_TRUE(Found(map, 1, 3));
+  ASSERT_TRUE(Found(map, 2, 4));
+}
+
+TEST(BTreeSortedMap, Override) {
+  IntMap map = IntMap().insert(10, 10).insert(10, 8);
+
+  ASSERT_TRUE(Found(map, 10, 8));
+  ASSERT_FALSE(Found(map, 10, 10));
+  ASSERT_EQ(1u, map.size());
+}
+
+TEST(BTreeSortedMap, Empty) {
+  IntMap map = IntMap().insert(10, 10).erase(10);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_TRUE(NotFound(map, 1));
+  EXPECT_TRUE(NotFound(map, 10));
+  EXPECT_EQ(map.begin(), map.end());
+
+  EXPECT_TRUE(IntMap().erase(1).empty());
+}
+
+TEST(BTreeSortedMap, InsertionAndRemovalOfManyItems) {
+  int n = 5000;
+  std::vector<int> to_insert = Shuffled(Sequence(n));
+  std::vector<int> to_remove = Shuffled(to_insert);
+
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+  CheckInvariants(map);
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+
+  for (int i : to_insert) {
+    ASSERT_TRUE(Found(map, i, i));
+  }
+
+  int remaining = n;
+  for (int i : to_remove) {
+    map = map.erase(i);
+    remaining--;
+    ASSERT_TRUE(NotFound(map, i));
+    ASSERT_EQ(static_cast<IntMap::size_type>(remaining), map.size());
+    if (remaining % 97 == 0) {
+      CheckInvariants(map);
+    }
+  }
+  ASSERT_TRUE(map.empty());
+}
+
+TEST(BTreeSortedMap, StaysBalanced) {
+  IntMap map = ToMap<IntMap>(Sequence(1 << 14));
+  CheckInvariants(map);
+
+  std::vector<int> remaining;
+  for (int i = 0; i < (1 << 14); i++) {
+    if (i % 3 == 0) {
+      map = map.erase(i);
+    } else {
+      remaining.push_back(i);
+    }
+  }
+  CheckInvariants(map);
+  ASSERT_SEQ_EQ(Pairs(remaining), map);
+}
+
+TEST(BTreeSortedMap, FindReturnsIteratorToContinueFrom) {
+  IntMap map = ToMap<IntMap>(Shuffled(Sequence(0, 1000, 2)));
+
+  for (int i = 0; i < 1000; i += 50) {
+    auto iter = map.find(i);
+    ASSERT_NE(map.end(), iter);
+    std::vector<std::pair<int, int>> rest(iter, map.end());
+    EXPECT_EQ(Pairs(Sequence(i, 1000, 2)), rest);
+
+    EXPECT_EQ(map.end(), map.find(i + 1));
+  }
+  EXPECT_EQ(map.end(), map.find(1000));
+}
+
+TEST(BTreeSortedMap, CreatesFromSortedRange) {
+  for (int n = 0; n < 3000; n += (n < 100 ? 1 : 37)) {
+    std::vector<std::pair<int, int>> entries = Pairs(Sequence(n));
+    IntMap map = IntMap::FromSorted(entries.begin(), entries.end());
+    ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+    ASSERT_SEQ_EQ(entries, map);
+    CheckInvariants(map);
+  }
+}
+
+TEST(BTreeSortedMap, MergesMaps) {
+  IntMap evens = ToMap<IntMap>(Sequence(0, 2000, 2));
+  IntMap odds = ToMap<IntMap>(Sequence(1, 2000, 2));
+  IntMap merged = evens.merge(odds);
+  ASSERT_SEQ_EQ(Pairs(Sequence(2000)), merged);
+  CheckInvariants(merged);
+
+  IntMap updated = merged.merge(IntMap{{10, -10}});
+  EXPECT_TRUE(Found(updated, 10, -10));
+  EXPECT_TRUE(Found(merged, 10, 10));
+}
+
+TEST(BTreeSortedMap, AvoidsCopying) {
+  IntMap map = ToMap<IntMap>(Sequence(1000));
+
+  // Changes that leave the map the same don't copy anything.
+  util::CountedAllocations counted;
+  map.MemoryUsage(&counted);
+  EXPECT_EQ(sizeof(IntMap), map.insert(5, 5).MemoryUsage(&counted));
+  EXPECT_EQ(sizeof(IntMap), map.erase(1000).MemoryUsage(&counted));
+}
+
+TEST(BTreeSortedMap, SharesUnchangedNodes) {
+  IntMap map = ToMap<IntMap>(Sequence(10000));
+  IntMap updated = map.insert(10000, 10000);
+
+  // Only the nodes on the path to the new entry are copied.
+  util::CountedAllocations counted;
+  size_t usage = map.MemoryUsage(&counted);
+  size_t added = updated.MemoryUsage(&counted) - sizeof(IntMap);
+  EXPECT_LT(0u, added);
+  EXPECT_GT(usage / 20, added);
+}
+
+TEST(BTreeSortedMap, RangeApis) {
+  for (int n : {0, 1, 2, 3, 10, 100, 1000, 5000}) {
+    CheckRangeApis(ToMap<IntMap>(Shuffled(Sequence(0, 2 * n, 2))), n);
+  }
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
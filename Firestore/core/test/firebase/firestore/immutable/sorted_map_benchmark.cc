@@ -0,0 +1,242 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "benchmark/benchmark.h"
+
+// Compares the immutable map implementations across key types and sizes.
+//
+// Each benchmark is named after the map type it measures, e.g.
+// BM_SortedMapFind<TreeMap<std::string>>/1024. ArraySortedMap holds at most
+// kFixedSize entries so it's only measured that far; the sizes around
+// kFixedSize show where SortedMap ought to switch from an array to a tree.
+// DocumentKey maps are also measured at the sizes of large collections.
+//
+// Run with --benchmark_format=json (or build the run_ target, which writes
+// JSON to the build directory) to get results that can be compared over time.
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+namespace {
+
+using model::DocumentKey;
+
+template <typename K>
+using ArrayMap = ArraySortedMap<K, int>;
+
+template <typename K>
+using TreeMap = TreeSortedMap<K, int>;
+
+template <typename K>
+using BTreeMap = BTreeSortedMap<K, int>;
+
+template <typename K>
+using Map = SortedMap<K, int>;
+
+/** The type of the keys of the given map type. */
+template <typename MapT>
+using KeyOf = typename MapT::value_type::first_type;
+
+template <typename K>
+K MakeKey(int64_t i);
+
+template <>
+int MakeKey<int>(int64_t i) {
+  return static_cast<int>(i);
+}
+
+template <>
+std::string MakeKey<std::string>(int64_t i) {
+  return "field" + std::to_string(i);
+}
+
+template <>
+DocumentKey MakeKey<DocumentKey>(int64_t i) {
+  return DocumentKey::FromPathString("rooms/room" + std::to_string(i % 16) +
+                                     "/messages/" + std::to_string(i));
+}
+
+/** Returns count distinct keys, in no particular order. */
+template <typename K>
+std::vector<K> MakeKeys(int64_t count) {
+  std::vector<K> keys;
+  keys.reserve(count);
+  for (int64_t i = 0; i < count; i++) {
+    keys.push_back(MakeKey<K>(i * 7919 % count));
+  }
+  return keys;
+}
+
+/** Returns entries for the given keys, sorted by key. */
+template <typename K>
+std::vector<std::pair<K, int>> MakeSortedEntries(const std::vector<K>& keys) {
+  std::vector<std::pair<K, int>> entries;
+  entries.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    entries.emplace_back(keys[i], static_cast<int>(i));
+  }
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+template <typename MapT>
+MapT MakeMap(const std::vector<KeyOf<MapT>>& keys) {
+  auto entries = MakeSortedEntries(keys);
+  return MapT::FromSorted(entries.begin(), entries.end());
+}
+
+void ArraySizes(benchmark::internal::Benchmark* b) {
+  for (int64_t size : {1, 8, 16, 24}) {
+    b->Arg(size);
+  }
+  b->Arg(impl::SortedMapBase::kFixedSize);
+}
+
+void AllSizes(benchmark::internal::Benchmark* b) {
+  ArraySizes(b);
+  for (int64_t size : {32, 64, 1024, 65536}) {
+    b->Arg(size);
+  }
+}
+
+void CollectionSizes(benchmark::internal::Benchmark* b) {
+  AllSizes(b);
+  for (int64_t size : {100000, 1000000}) {
+    b->Arg(size);
+  }
+}
+
+}  // namespace
+
+// Registers the given benchmark for every map type and key type.
+#define BENCHMARK_SORTED_MAPS_FOR_KEY(func, K, sizes)       \
+  BENCHMARK_TEMPLATE(func, ArrayMap<K>)->Apply(ArraySizes); \
+  BENCHMARK_TEMPLATE(func, TreeMap<K>)->Apply(sizes);       \
+  BENCHMARK_TEMPLATE(func, BTreeMap<K>)->Apply(sizes);      \
+  BENCHMARK_TEMPLATE(func, Map<K>)->Apply(sizes)
+
+#define BENCHMARK_SORTED_MAPS(func)                                 \
+  BENCHMARK_SORTED_MAPS_FOR_KEY(func, int, AllSizes);               \
+  BENCHMARK_SORTED_MAPS_FOR_KEY(func, std::string, AllSizes);       \
+  BENCHMARK_SORTED_MAPS_FOR_KEY(func, DocumentKey, CollectionSizes)
+
+template <typename MapT>
+void BM_SortedMapInsert(benchmark::State& state) {
+  const auto keys = MakeKeys<KeyOf<MapT>>(state.range(0));
+  for (auto _ : state) {
+    MapT map;
+    for (const auto& key : keys) {
+      map = map.insert(key, 0);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_SORTED_MAPS(BM_SortedMapInsert);
+
+template <typename MapT>
+void BM_SortedMapErase(benchmark::State& state) {
+  const auto keys = MakeKeys<KeyOf<MapT>>(state.range(0));
+  const auto full = MakeMap<MapT>(keys);
+  for (auto _ : state) {
+    MapT map = full;
+    for (const auto& key : keys) {
+      map = map.erase(key);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_SORTED_MAPS(BM_SortedMapErase);
+
+template <typename MapT>
+void BM_SortedMapFind(benchmark::State& state) {
+  const auto keys = MakeKeys<KeyOf<MapT>>(state.range(0));
+  const auto map = MakeMap<MapT>(keys);
+  size_t i = 0;
+  for (auto _ : state) {
+    auto found = map.find(keys[i]);
+    benchmark::DoNotOptimize(found);
+    i = i + 1 < keys.size() ? i + 1 : 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_SORTED_MAPS(BM_SortedMapFind);
+
+template <typename MapT>
+void BM_SortedMapIterate(benchmark::State& state) {
+  const auto map = MakeMap<MapT>(MakeKeys<KeyOf<MapT>>(state.range(0)));
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& entry : map) {
+      sum += entry.second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_SORTED_MAPS(BM_SortedMapIterate);
+
+template <typename MapT>
+void BM_SortedMapCopy(benchmark::State& state) {
+  const auto map = MakeMap<MapT>(MakeKeys<KeyOf<MapT>>(state.range(0)));
+  for (auto _ : state) {
+    MapT copy = map;
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_SORTED_MAPS(BM_SortedMapCopy);
+
+template <typename MapT>
+void BM_SortedMapFromSorted(benchmark::State& state) {
+  const auto entries =
+      MakeSortedEntries(MakeKeys<KeyOf<MapT>>(state.range(0)));
+  for (auto _ : state) {
+    auto map = MapT::FromSorted(entries.begin(), entries.end());
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_SORTED_MAPS(BM_SortedMapFromSorted);
+
+template <typename MapT>
+void BM_SortedMapMemoryUsage(benchmark::State& state) {
+  const auto map = MakeMap<MapT>(MakeKeys<KeyOf<MapT>>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.MemoryUsage());
+  }
+  state.counters["bytes_per_entry"] =
+      static_cast<double>(map.MemoryUsage()) / state.range(0);
+}
+BENCHMARK_SORTED_MAPS(BM_SortedMapMemoryUsage);
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
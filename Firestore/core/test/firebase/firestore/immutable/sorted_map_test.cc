@@ -0,0 +1,206 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+typedef SortedMap<int, int> IntMap;
+constexpr IntMap::size_type kFixedSize = IntMap::kFixedSize;
+
+TEST(SortedMap, SearchForSpecificKey) {
+  IntMap map{{1, 3}, {2, 4}};
+
+  ASSERT_TRUE(Found(map, 1, 3));
+  ASSERT_TRUE(Found(map, 2, 4));
+  ASSERT_TRUE(NotFound(map, 3));
+}
+
+TEST(SortedMap, GrowsBeyondFixedSize) {
+  int n = static_cast<int>(kFixedSize) * 4;
+  std::vector<int> to_insert = Shuffled(Sequence(n));
+  std::vector<int> to_remove = Shuffled(to_insert);
+
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+  for (int i : to_insert) {
+    ASSERT_TRUE(Found(map, i, i));
+  }
+
+  for (int i : to_remove) {
+    map = map.erase(i);
+    ASSERT_TRUE(NotFound(map, i));
+  }
+  ASSERT_TRUE(map.empty());
+}
+
+TEST(SortedMap, SwitchesAtFixedSize) {
+  IntMap full = ToMap<IntMap>(Sequence(kFixedSize));
+
+  // Replacing an entry in a full array doesn't switch to a tree.
+  IntMap replaced = full.insert(5, 10);
+  EXPECT_TRUE(Found(replaced, 5, 10));
+  EXPECT_EQ(full.MemoryUsage(), replaced.MemoryUsage());
+
+  int next = kFixedSize;
+  IntMap grown = full.insert(next, next);
+  EXPECT_EQ(kFixedSize + 1, grown.size());
+  EXPECT_TRUE(Found(grown, next, next));
+  ASSERT_SEQ_EQ(Pairs(Sequence(kFixedSize + 1)), grown);
+
+  // The original is unchanged.
+  EXPECT_TRUE(NotFound(full, next));
+  ASSERT_SEQ_EQ(Pairs(Sequence(kFixedSize)), full);
+}
+
+TEST(SortedMap, CreatesFromManyEntries) {
+  IntMap small{{1, 1}, {2, 2}};
+  ASSERT_SEQ_EQ(Pairs(Sequence(1, 3)), small);
+
+  std::initializer_list<std::pair<int, int>> entries{
+      {30, 30}, {29, 29}, {28, 28}, {27, 27}, {26, 26}, {25, 25}, {24, 24},
+      {23, 23}, {22, 22}, {21, 21}, {20, 20}, {19, 19}, {18, 18}, {17, 17},
+      {16, 16}, {15, 15}, {14, 14}, {13, 13}, {12, 12}, {11, 11}, {10, 10},
+      {9, 9},   {8, 8},   {7, 7},   {6, 6},   {5, 5},   {4, 4},   {3, 3},
+  };
+  IntMap large{entries};
+  ASSERT_SEQ_EQ(Pairs(Sequence(3, 31)), large);
+}
+
+TEST(SortedMap, CreatesFromSortedRange) {
+  for (int n : {0, 1, static_cast<int>(kFixedSize),
+                static_cast<int>(kFixedSize) + 1, 1000}) {
+    std::vector<std::pair<int, int>> entries = Pairs(Sequence(n));
+    IntMap map = IntMap::FromSorted(entries.begin(), entries.end());
+    EXPECT_SEQ_EQ(entries, map);
+  }
+}
+
+TEST(SortedMap, MergesMaps) {
+  int n = static_cast<int>(kFixedSize);
+  std::vector<IntMap> maps = {
+      ToMap<IntMap>(Sequence(0, n / 2)),  // small array
+      ToMap<IntMap>(Sequence(0, n)),      // full array
+      ToMap<IntMap>(Sequence(0, n * 4)),  // tree
+  };
+  for (const IntMap& lhs : maps) {
+    for (const IntMap& rhs : maps) {
+      std::vector<int> expected = Sequence(std::max(lhs.size(), rhs.size()));
+      EXPECT_SEQ_EQ(Pairs(expected), lhs.merge(rhs));
+
+
+      // Keys only in rhs are added after those of lhs.
+      IntMap disjoint;
+      for (const auto& entry : rhs) {
+        disjoint = disjoint.insert(entry.first + 1000, entry.second);
+      }
+      IntMap merged = lhs.merge(disjoint);
+      EXPECT_EQ(lhs.size() + rhs.size(), merged.size());
+      std::vector<std::pair<int, int>> prefix(
+          merged.begin(), std::next(merged.begin(), lhs.size()));
+      EXPECT_EQ(Append(lhs), prefix);
+    }
+  }
+}
+
+TEST(SortedMap, MergeSwitchesToTree) {
+  int n = static_cast<int>(kFixedSize);
+  IntMap evens = ToMap<IntMap>(Sequence(0, n * 2, 2));
+  IntMap odds = ToMap<IntMap>(Sequence(1, n * 2, 2));
+
+  IntMap merged = evens.merge(odds);
+  ASSERT_SEQ_EQ(Pairs(Sequence(n * 2)), merged);
+  merged = merged.insert(n * 2, n * 2);
+  EXPECT_EQ(static_cast<IntMap::size_type>(n * 2 + 1), merged.size());
+}
+
+TEST(SortedMap, MergePrefersOtherValues) {
+  IntMap map = ToMap<IntMap>(Sequence(100));
+  IntMap other{{10, -10}, {150, 150}};
+
+  IntMap merged = map.merge(other);
+  EXPECT_EQ(101u, merged.size());
+  EXPECT_TRUE(Found(merged, 10, -10));
+  EXPECT_TRUE(Found(merged, 150, 150));
+  EXPECT_TRUE(Found(other.merge(map), 10, 10));
+}
+
+TEST(SortedMap, BuildsMaps) {
+  int n = static_cast<int>(kFixedSize) * 4;
+  IntMap::Builder builder;
+  for (int i : Shuffled(Sequence(n))) {
+    builder.insert(i, i);
+    if (i % 2 == 1) {
+      builder.erase(i);
+    }
+  }
+  IntMap map = builder.Build();
+  EXPECT_SEQ_EQ(Pairs(Sequence(0, n, 2)), map);
+
+  // Builders start from existing maps, which they don't change.
+  IntMap::Builder small{IntMap{{1, 1}}};
+  IntMap::Builder large{map};
+  EXPECT_SEQ_EQ(Pairs(Sequence(2, 3)), small.insert(2, 2).erase(1).Build());
+  EXPECT_SEQ_EQ(Pairs(Sequence(2, n, 2)), large.erase(0).Build());
+  EXPECT_SEQ_EQ(Pairs(Sequence(0, n, 2)), map);
+}
+
+TEST(SortedMap, CopiesAndAssigns) {
+  IntMap small = ToMap<IntMap>(Sequence(5));
+  IntMap large = ToMap<IntMap>(Sequence(100));
+
+  IntMap copy = small;
+  ASSERT_SEQ_EQ(Pairs(Sequence(5)), copy);
+  copy = large;
+  ASSERT_SEQ_EQ(Pairs(Sequence(100)), copy);
+  copy = small;
+  ASSERT_SEQ_EQ(Pairs(Sequence(5)), copy);
+
+  IntMap moved = std::move(large);
+  ASSERT_SEQ_EQ(Pairs(Sequence(100)), moved);
+  moved = std::move(copy);
+  ASSERT_SEQ_EQ(Pairs(Sequence(5)), moved);
+}
+
+TEST(SortedMap, Empty) {
+  IntMap map = IntMap().insert(10, 10).erase(10);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_TRUE(NotFound(map, 10));
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(SortedMap, RangeApis) {
+  for (int n : {0, 1, static_cast<int>(kFixedSize),
+                static_cast<int>(kFixedSize) + 1, 1000}) {
+    CheckRangeApis(ToMap<IntMap>(Shuffled(Sequence(0, 2 * n, 2))), n);
+  }
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
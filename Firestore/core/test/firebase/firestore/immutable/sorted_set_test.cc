@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
+
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+typedef SortedSet<int> IntSet;
+constexpr IntSet::size_type kFixedSize = IntSet::kFixedSize;
+
+IntSet ToSet(const std::vector<int>& values) {
+  IntSet result;
+  for (int value : values) {
+    result = result.insert(value);
+  }
+  return result;
+}
+
+std::vector<int> Keys(const IntSet& set) {
+  return std::vector<int>(set.begin(), set.end());
+}
+
+TEST(SortedSet, InsertsAndErases) {
+  IntSet set{3, 1, 2};
+  EXPECT_EQ(Sequence(1, 4), Keys(set));
+  EXPECT_TRUE(set.contains(2));
+  EXPECT_FALSE(set.contains(4));
+
+  IntSet erased = set.erase(2).erase(5);
+  EXPECT_EQ((std::vector<int>{1, 3}), Keys(erased));
+  EXPECT_FALSE(erased.contains(2));
+  EXPECT_NE(erased.end(), erased.find(3));
+  EXPECT_EQ(erased.end(), erased.find(2));
+}
+
+TEST(SortedSet, CreatesFromSortedRange) {
+  std::vector<int> keys = Sequence(1000);
+  IntSet set = IntSet::FromSorted(keys.begin(), keys.end());
+  EXPECT_EQ(keys, Keys(set));
+  EXPECT_EQ(ToSet(Shuffled(keys)), set);
+}
+
+TEST(SortedSet, Union) {
+  int n = static_cast<int>(kFixedSize) * 4;
+  IntSet evens = ToSet(Sequence(0, n, 2));
+  IntSet odds = ToSet(Sequence(1, n, 2));
+  EXPECT_EQ(Sequence(n), Keys(evens.Union(odds)));
+  EXPECT_EQ(Sequence(n), Keys(odds.Union(evens)));
+  EXPECT_EQ(evens, evens.Union(IntSet{}));
+  EXPECT_EQ(evens, IntSet{}.Union(evens));
+  EXPECT_EQ(Sequence(0, n, 2), Keys(evens.Union(ToSet(Sequence(0, 10, 2)))));
+}
+
+TEST(SortedSet, Intersection) {
+  int n = static_cast<int>(kFixedSize) * 4;
+  IntSet all = ToSet(Sequence(n));
+  IntSet evens = ToSet(Sequence(0, n, 2));
+  IntSet threes = ToSet(Sequence(0, n, 3));
+  EXPECT_EQ(Sequence(0, n, 6), Keys(evens.Intersection(threes)));
+  EXPECT_EQ(Sequence(0, n, 6), Keys(threes.Intersection(evens)));
+  EXPECT_EQ(evens, all.Intersection(evens));
+  EXPECT_EQ(evens, evens.Intersection(all));
+  EXPECT_TRUE(evens.Intersection(IntSet{}).empty());
+  EXPECT_TRUE(IntSet{}.Intersection(evens).empty());
+}
+
+TEST(SortedSet, Difference) {
+  int n = static_cast<int>(kFixedSize) * 4;
+  IntSet all = ToSet(Sequence(n));
+  IntSet evens = ToSet(Sequence(0, n, 2));
+  EXPECT_EQ(Sequence(1, n, 2), Keys(all.Difference(evens)));
+  EXPECT_TRUE(evens.Difference(all).empty());
+  EXPECT_EQ(evens, evens.Difference(ToSet(Sequence(1, n, 2))));
+  EXPECT_EQ(evens, evens.Difference(IntSet{}));
+  EXPECT_EQ(Sequence(2, 10, 2),
+            Keys(ToSet(Sequence(0, 10, 2)).Difference(IntSet{0, 100})));
+}
+
+TEST(SortedSet, RangeApis) {
+  IntSet set = ToSet(Sequence(0, 100, 2));
+  EXPECT_EQ(5u, set.find_index(10));
+  EXPECT_EQ(IntSet::npos, set.find_index(11));
+  EXPECT_EQ(Sequence(10, 100, 2),
+            std::vector<int>(set.lower_bound(10), set.end()));
+  EXPECT_EQ(Sequence(12, 100, 2),
+            std::vector<int>(set.upper_bound(10), set.end()));
+  EXPECT_EQ(Sequence(98, -1, -2), std::vector<int>(set.rbegin(), set.rend()));
+}
+
+TEST(SortedSet, AvoidsCopying) {
+  IntSet set = ToSet(Sequence(100));
+  IntSet subset = ToSet(Sequence(10, 20));
+
+  util::CountedAllocations counted;
+  size_t usage = set.MemoryUsage(&counted);
+  EXPECT_EQ(sizeof(IntSet), set.Union(subset).MemoryUsage(&counted));
+  EXPECT_EQ(sizeof(IntSet), set.Intersection(set).MemoryUsage(&counted));
+  EXPECT_EQ(sizeof(IntSet),
+            set.Difference(ToSet(Sequence(100, 200))).MemoryUsage(&counted));
+  EXPECT_LT(sizeof(IntSet), usage);
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
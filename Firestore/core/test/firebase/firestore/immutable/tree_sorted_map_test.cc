@@ -0,0 +1,321 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+typedef TreeSortedMap<int, int> IntMap;
+typedef IntMap::node_type IntNode;
+
+/**
+ * Checks the invariants of a left-leaning red-black tree below the given node
+ * and returns its black height.
+ */
+int CheckInvariants(const IntNode& node) {
+  if (node.empty()) {
+    return 0;
+  }
+  EXPECT_FALSE(node.right().red()) << "Right child is red at " << node.key();
+  EXPECT_FALSE(node.red() && node.left().red())
+      << "Red node has a red child at " << node.key();
+  EXPECT_EQ(node.left().size() + 1 + node.right().size(), node.size());
+
+  int left_height = CheckInvariants(node.left());
+  int right_height = CheckInvariants(node.right());
+  EXPECT_EQ(left_height, right_height)
+      << "Unbalanced black height at " << node.key();
+  return left_height + (node.red() ? 0 : 1);
+}
+
+void CheckInvariants(const IntMap& map) {
+  EXPECT_FALSE(map.root().red()) << "Root is red";
+  CheckInvariants(map.root());
+}
+
+TEST(TreeSortedMap, SearchForSpecificKey) {
+  IntMap map{{1, 3}, {2, 4}};
+
+  ASSERT_TRUE(Found(map, 1, 3));
+  ASSERT_TRUE(Found(map, 2, 4));
+  ASSERT_TRUE(NotFound(map, 3));
+}
+
+TEST(TreeSortedMap, RemoveKeyValuePair) {
+  IntMap map{{1, 3}, {2, 4}};
+
+  IntMap new_map = map.erase(1);
+  ASSERT_TRUE(Found(new_map, 2, 4));
+  ASSERT_TRUE(NotFound(new_map, 1));
+
+  // Make sure the original one is not mutated
+  ASSERT_TRUE(Found(map, 1, 3));
+  ASSERT_TRUE(Found(map, 2, 4));
+}
+
+TEST(TreeSortedMap, MoreRemovals) {
+  IntMap map = IntMap()
+                   .insert(1, 1)
+                   .insert(50, 50)
+                   .insert(3, 3)
+                   .insert(4, 4)
+                   .insert(7, 7)
+                   .insert(9, 9)
+                   .insert(20, 20)
+                   .insert(18, 18)
+                   .insert(2, 2)
+                   .insert(71, 71)
+                   .insert(42, 42)
+                   .insert(88, 88);
+  CheckInvariants(map);
+
+  IntMap s1 = map.erase(7);
+  IntMap s2 = map.erase(3);
+  IntMap s3 = map.erase(1);
+  CheckInvariants(s1);
+  CheckInvariants(s2);
+  CheckInvariants(s3);
+
+  ASSERT_TRUE(NotFound(s1, 7));
+  ASSERT_TRUE(Found(s1, 3, 3));
+  ASSERT_TRUE(Found(s1, 1, 1));
+
+  ASSERT_TRUE(Found(s2, 7, 7));
+  ASSERT_TRUE(NotFound(s2, 3));
+  ASSERT_TRUE(Found(s2, 1, 1));
+
+  ASSERT_TRUE(Found(s3, 7, 7));
+  ASSERT_TRUE(Found(s3, 3, 3));
+  ASSERT_TRUE(NotFound(s3, 1));
+}
+
+TEST(TreeSortedMap, Override) {
+  IntMap map = IntMap().insert(10, 10).insert(10, 8);
+
+  ASSERT_TRUE(Found(map, 10, 8));
+  ASSERT_FALSE(Found(map, 10, 10));
+  ASSERT_EQ(1u, map.size());
+}
+
+TEST(TreeSortedMap, Empty) {
+  IntMap map = IntMap().insert(10, 10).erase(10);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_TRUE(NotFound(map, 1));
+  EXPECT_TRUE(NotFound(map, 10));
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(TreeSortedMap, EmptyRemoval) {
+  IntMap map;
+  IntMap new_map = map.erase(1);
+  EXPECT_TRUE(new_map.empty());
+  EXPECT_EQ(0u, new_map.size());
+  EXPECT_TRUE(NotFound(new_map, 1));
+}
+
+TEST(TreeSortedMap, RemovingAbsentKeyDoesNotCopy) {
+  IntMap map = ToMap<IntMap>(Sequence(10));
+  IntMap same = map.erase(100);
+  EXPECT_EQ(&map.root().entry(), &same.root().entry());
+}
+
+TEST(TreeSortedMap, InsertionAndRemovalOfManyItems) {
+  int n = 1000;
+  std::vector<int> to_insert = Shuffled(Sequence(n));
+  std::vector<int> to_remove = Shuffled(to_insert);
+
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+  CheckInvariants(map);
+
+  // check the order is correct
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+
+  for (int i : to_remove) {
+    map = map.erase(i);
+    ASSERT_TRUE(NotFound(map, i));
+  }
+  ASSERT_EQ(0u, map.size()) << "Check we removed all of the items";
+}
+
+TEST(TreeSortedMap, StaysBalanced) {
+  IntMap map = ToMap<IntMap>(Sequence(1 << 12));
+  CheckInvariants(map);
+
+  std::vector<int> remaining;
+  for (int i = 0; i < (1 << 12); i++) {
+    if (i % 3 == 0) {
+      map = map.erase(i);
+    } else {
+      remaining.push_back(i);
+    }
+  }
+  CheckInvariants(map);
+  ASSERT_SEQ_EQ(Pairs(remaining), map);
+}
+
+TEST(TreeSortedMap, BalanceProblem) {
+  std::vector<int> to_insert{1, 7, 8, 5, 2, 6, 4, 0, 3};
+
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+  CheckInvariants(map);
+}
+
+TEST(TreeSortedMap, Iterates) {
+  std::vector<int> to_insert = Shuffled(Sequence(100));
+  IntMap map = ToMap<IntMap>(to_insert);
+
+  int expected = 0;
+  for (auto iter = map.begin(); iter != map.end(); iter++) {
+    EXPECT_EQ(expected, iter->first);
+    expected++;
+  }
+  EXPECT_EQ(100, expected);
+}
+
+TEST(TreeSortedMap, FindReturnsIteratorToContinueFrom) {
+  IntMap map = ToMap<IntMap>(Shuffled(Sequence(0, 100, 2)));
+
+  auto iter = map.find(50);
+  ASSERT_NE(map.end(), iter);
+  std::vector<std::pair<int, int>> rest(iter, map.end());
+  EXPECT_EQ(Pairs(Sequence(50, 100, 2)), rest);
+
+  EXPECT_EQ(map.end(), map.find(51));
+  EXPECT_EQ(map.end(), map.find(100));
+}
+
+TEST(TreeSortedMap, CreatesFromRange) {
+  std::vector<std::pair<int, int>> entries = Pairs(Shuffled(Sequence(50)));
+  IntMap map = IntMap::Create(entries.begin(), entries.end());
+  ASSERT_SEQ_EQ(Pairs(Sequence(50)), map);
+  CheckInvariants(map);
+}
+
+TEST(TreeSortedMap, CreatesFromSortedRange) {
+  for (int n = 0; n < 300; n++) {
+    std::vector<std::pair<int, int>> entries = Pairs(Sequence(n));
+    IntMap map = IntMap::FromSorted(entries.begin(), entries.end());
+    ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+    ASSERT_SEQ_EQ(entries, map);
+    CheckInvariants(map);
+
+    // The result is a valid tree to keep modifying.
+    map = map.insert(n, n).erase(0);
+    CheckInvariants(map);
+  }
+}
+
+TEST(TreeSortedMap, MergesMaps) {
+  IntMap evens = ToMap<IntMap>(Sequence(0, 200, 2));
+  IntMap odds = ToMap<IntMap>(Sequence(1, 200, 2));
+
+  IntMap merged = evens.merge(odds);
+  ASSERT_SEQ_EQ(Pairs(Sequence(200)), merged);
+  CheckInvariants(merged);
+  EXPECT_SEQ_EQ(Pairs(Sequence(200)), odds.merge(evens));
+}
+
+TEST(TreeSortedMap, MergePrefersOtherValues) {
+  IntMap map = ToMap<IntMap>(Sequence(100));
+  IntMap other{{10, -10}, {150, 150}};
+
+  IntMap merged = map.merge(other);
+  EXPECT_EQ(101u, merged.size());
+  EXPECT_TRUE(Found(merged, 10, -10));
+  EXPECT_TRUE(Found(merged, 150, 150));
+  CheckInvariants(merged);
+
+  merged = other.merge(map);
+  EXPECT_EQ(101u, merged.size());
+  EXPECT_TRUE(Found(merged, 10, 10));
+  CheckInvariants(merged);
+}
+
+TEST(TreeSortedMap, MergeAvoidsCopying) {
+  IntMap map = ToMap<IntMap>(Sequence(100));
+  IntMap empty;
+  EXPECT_EQ(&map.root().entry(), &map.merge(empty).root().entry());
+  EXPECT_EQ(&map.root().entry(), &empty.merge(map).root().entry());
+
+  // Merging in the same entries returns the same tree.
+  IntMap same = ToMap<IntMap>(Shuffled(Sequence(100)));
+  EXPECT_EQ(&map.root().entry(), &map.merge(same).root().entry());
+
+  // Merging in a few entries only copies the paths to them.
+  IntMap small = ToMap<IntMap>(Sequence(1000, 1003));
+  IntMap large = ToMap<IntMap>(Sequence(1000));
+  util::CountedAllocations counted;
+  size_t usage = large.MemoryUsage(&counted);
+  IntMap merged = large.merge(small);
+  size_t added = merged.MemoryUsage(&counted) - sizeof(IntMap);
+  EXPECT_GT(usage / 10, added);
+
+  merged = small.merge(large);
+  ASSERT_SEQ_EQ(Pairs(Sequence(1003)), merged);
+  EXPECT_GT(usage / 10, merged.MemoryUsage(&counted) - sizeof(IntMap));
+}
+
+TEST(TreeSortedMap, AvoidsCopying) {
+  IntMap map = ToMap<IntMap>(Sequence(10));
+
+  // Inserting an equal key and value returns the same tree.
+  IntMap duped = map.insert(5, 5);
+  EXPECT_EQ(&map.root().entry(), &duped.root().entry());
+}
+
+TEST(TreeSortedMap, SharesUnchangedSubtrees) {
+  IntMap map = ToMap<IntMap>(Sequence(1000));
+  IntMap updated = map.insert(1000, 1000);
+
+  // Only the nodes on the path to the new entry are copied.
+  util::CountedAllocations counted;
+  size_t usage = map.MemoryUsage(&counted);
+  size_t added = updated.MemoryUsage(&counted) - sizeof(IntMap);
+  EXPECT_LT(0u, added);
+  EXPECT_GT(usage / 20, added);
+}
+
+TEST(TreeSortedMap, MemoryUsage) {
+  IntMap empty;
+  EXPECT_EQ(sizeof(IntMap), empty.MemoryUsage());
+
+  IntMap map = ToMap<IntMap>(Sequence(10));
+  size_t usage = map.MemoryUsage();
+  EXPECT_LT(sizeof(IntMap) + 10 * sizeof(std::pair<int, int>), usage);
+
+  IntMap copy = map;
+  util::CountedAllocations counted;
+  EXPECT_EQ(usage, map.MemoryUsage(&counted));
+  EXPECT_EQ(sizeof(IntMap), copy.MemoryUsage(&counted));
+}
+
+TEST(TreeSortedMap, RangeApis) {
+  for (int n : {0, 1, 2, 3, 10, 100, 1000}) {
+    CheckRangeApis(ToMap<IntMap>(Shuffled(Sequence(0, 2 * n, 2))), n);
+  }
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -351,6 +351,24 @@ TEST(RemoteDocumentKeyTest, EncodeDecodeCycle) {
   }
 }
 
+TEST(RemoteDocumentKeyTest, DecodeCompact) {
+  std::vector<std::string> paths{"foo/bar", "foo/bar2", "foo/bar/baz/quux",
+                                 std::string{"foo/b\0r", 7}};
+  for (auto&& path : paths) {
+    model::CompactDocumentKey key;
+    ASSERT_TRUE(
+        LevelDbRemoteDocumentKey::DecodeCompact(RemoteDocKey(path), &key));
+    ASSERT_EQ(testutil::Key(path), key.ToDocumentKey());
+  }
+
+  model::CompactDocumentKey key;
+  ASSERT_FALSE(LevelDbRemoteDocumentKey::DecodeCompact(
+      RemoteDocKeyPrefix("foo"), &key));
+  ASSERT_FALSE(LevelDbRemoteDocumentKey::DecodeCompact(
+      TargetDocKey(1, "foo/bar"), &key));
+  ASSERT_TRUE(key.empty());
+}
+
 TEST(RemoteDocumentKeyTest, Description) {
   AssertExpectedKeyDescription(
       "[remote_document: key=foo/bar/baz/quux]",
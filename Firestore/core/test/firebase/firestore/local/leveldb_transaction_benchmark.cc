@@ -0,0 +1,175 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <leveldb/db.h>
+#include <leveldb/env.h>
+#include <leveldb/write_batch.h>
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using leveldb::DB;
+using leveldb::Options;
+using leveldb::Status;
+using leveldb::WriteBatch;
+using model::DocumentKey;
+
+const int64_t kRows = 1000000;
+const int64_t kValueSize = 100;
+
+std::string RowKey(int64_t i) {
+  std::string id = std::to_string(i);
+  // Zero-pad the IDs so that rows sort in the order they're numbered.
+  id.insert(0, 8 - id.size(), '0');
+  return LevelDbRemoteDocumentKey::Key(
+      DocumentKey::FromSegments({"rooms", "eros", "messages", id}));
+}
+
+/**
+ * Returns a database containing kRows remote documents, creating it the first
+ * time it's called.
+ */
+DB* RowsDb() {
+  static DB* db = [] {
+    std::string dir;
+    Status status = leveldb::Env::Default()->GetTestDirectory(&dir);
+    FIREBASE_ASSERT_MESSAGE(status.ok(), "No test directory: %s",
+                            status.ToString().c_str());
+    std::string path = dir + "/leveldb_transaction_benchmark";
+    leveldb::DestroyDB(path, Options());
+
+    Options options;
+    options.create_if_missing = true;
+    DB* result;
+    status = DB::Open(options, path, &result);
+    FIREBASE_ASSERT_MESSAGE(status.ok(), "Failed to create db: %s",
+                            status.ToString().c_str());
+
+    std::string value(kValueSize, 'x');
+    WriteBatch batch;
+    for (int64_t i = 0; i < kRows; i++) {
+      batch.Put(RowKey(i), value);
+      if ((i + 1) % 10000 == 0) {
+        status = result->Write(LevelDbTransaction::DefaultWriteOptions(),
+                               &batch);
+        FIREBASE_ASSERT_MESSAGE(status.ok(), "Failed to write rows: %s",
+                                status.ToString().c_str());
+        batch.Clear();
+      }
+    }
+    return result;
+  }();
+  return db;
+}
+
+}  // namespace
+
+/** Scans all the rows with a plain leveldb iterator, for comparison. */
+void BM_LevelDbScan(benchmark::State& state) {
+  DB* db = RowsDb();
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    std::unique_ptr<leveldb::Iterator> it(
+        db->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      bytes += it->key().size() + it->value().size();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kRows);
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_LevelDbScan)->Unit(benchmark::kMillisecond);
+
+/**
+ * Scans all the rows through a transaction, with the given number of pending
+ * changes (half updates, half deletions) spread evenly across the rows.
+ */
+void BM_TransactionScan(benchmark::State& state) {
+  DB* db = RowsDb();
+  LevelDbTransaction transaction(db);
+  int64_t changes = state.range(0);
+  std::string value(kValueSize, 'y');
+  for (int64_t i = 0; i < changes; i++) {
+    std::string key = RowKey(i * kRows / changes);
+    if (i % 2 == 0) {
+      transaction.Put(key, value);
+    } else {
+      transaction.Delete(key);
+    }
+  }
+
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    auto it = transaction.NewIterator();
+    for (it->Seek(""); it->Valid(); it->Next()) {
+      bytes += it->key().size() + it->value().size();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kRows);
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_TransactionScan)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Writes the given number of rows into a transaction, as when applying a
+ * large remote event. The transaction isn't committed, so this measures just
+ * the cost of buffering the writes.
+ */
+void BM_TransactionPut(benchmark::State& state) {
+  DB* db = RowsDb();
+  int64_t rows = state.range(0);
+  std::vector<std::string> keys;
+  for (int64_t i = 0; i < rows; i++) {
+    keys.push_back(RowKey(i * kRows / rows));
+  }
+  std::string value(kValueSize, 'z');
+
+  for (auto _ : state) {
+    LevelDbTransaction transaction(db);
+    for (const std::string& key : keys) {
+      transaction.Put(key, value);
+    }
+    benchmark::DoNotOptimize(transaction);
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_TransactionPut)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/write_buffer.h"
+
+#include <map>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+TEST(WriteBufferTest, EmptyBehavior) {
+  WriteBuffer buffer;
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(0u, buffer.size());
+  EXPECT_FALSE(buffer.Find("a").Valid());
+
+  WriteBuffer::Iterator it(&buffer);
+  EXPECT_FALSE(it.Valid());
+  it.SeekToFirst();
+  EXPECT_FALSE(it.Valid());
+  it.Seek("");
+  EXPECT_FALSE(it.Valid());
+}
+
+TEST(WriteBufferTest, FindsPutsAndDeletes) {
+  WriteBuffer buffer;
+  buffer.Put("a", "1");
+  buffer.Delete("b");
+
+  WriteBuffer::Iterator a = buffer.Find("a");
+  ASSERT_TRUE(a.Valid());
+  EXPECT_EQ("a", a.key());
+  EXPECT_EQ("1", a.value());
+  EXPECT_FALSE(a.is_delete());
+
+  WriteBuffer::Iterator b = buffer.Find("b");
+  ASSERT_TRUE(b.Valid());
+  EXPECT_EQ("b", b.key());
+  EXPECT_EQ("", b.value());
+  EXPECT_TRUE(b.is_delete());
+
+  EXPECT_FALSE(buffer.Find("").Valid());
+  EXPECT_FALSE(buffer.Find("ab").Valid());
+  EXPECT_EQ(2u, buffer.size());
+}
+
+TEST(WriteBufferTest, LaterWritesReplaceEarlierOnes) {
+  WriteBuffer buffer;
+  buffer.Put("a", "1");
+  absl::string_view first_value = buffer.Find("a").value();
+
+  buffer.Delete("a");
+  EXPECT_TRUE(buffer.Find("a").is_delete());
+
+  buffer.Put("a", "2");
+  WriteBuffer::Iterator a = buffer.Find("a");
+  EXPECT_FALSE(a.is_delete());
+  EXPECT_EQ("2", a.value());
+  EXPECT_EQ(1u, buffer.size());
+
+  // Values that have been replaced are still readable.
+  EXPECT_EQ("1", first_value);
+}
+
+TEST(WriteBufferTest, IteratesInKeyOrder) {
+  std::mt19937 random(1);
+  std::map<std::string, std::string> expected;
+  WriteBuffer buffer;
+  for (int i = 0; i < 10000; i++) {
+    std::string key = std::to_string(random() % 5000);
+    if (random() % 4 == 0) {
+      buffer.Delete(key);
+      expected[key] = "<deleted>";
+    } else {
+      std::string value = std::to_string(i);
+      buffer.Put(key, value);
+      expected[key] = value;
+    }
+  }
+  ASSERT_EQ(expected.size(), buffer.size());
+
+  WriteBuffer::Iterator it(&buffer);
+  it.SeekToFirst();
+  for (const auto& entry : expected) {
+    ASSERT_TRUE(it.Valid());
+    ASSERT_EQ(entry.first, it.key());
+    ASSERT_EQ(entry.second, it.is_delete() ? "<deleted>" : it.value());
+    it.Next();
+  }
+  EXPECT_FALSE(it.Valid());
+
+  it.Seek("25");
+  auto lower_bound = expected.lower_bound("25");
+  ASSERT_TRUE(it.Valid());
+  EXPECT_EQ(lower_bound->first, it.key());
+}
+
+TEST(WriteBufferTest, IteratorsSeeLaterWritesAhead) {
+  WriteBuffer buffer;
+  buffer.Put("a", "1");
+  buffer.Put("c", "3");
+
+  WriteBuffer::Iterator it(&buffer);
+  it.SeekToFirst();
+  ASSERT_EQ("a", it.key());
+
+  buffer.Put("b", "2");
+  buffer.Put("a", "4");
+  EXPECT_EQ("4", it.value());
+  it.Next();
+  ASSERT_TRUE(it.Valid());
+  EXPECT_EQ("b", it.key());
+  it.Next();
+  ASSERT_TRUE(it.Valid());
+  EXPECT_EQ("c", it.key());
+  it.Next();
+  EXPECT_FALSE(it.Valid());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
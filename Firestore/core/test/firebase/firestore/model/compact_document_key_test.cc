@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/compact_document_key.h"
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(CompactDocumentKey, Empty) {
+  const CompactDocumentKey key;
+  EXPECT_TRUE(key.empty());
+  EXPECT_EQ(0u, key.size());
+  EXPECT_EQ("", key.CanonicalString());
+  EXPECT_EQ(0u, key.HeapMemoryUsage());
+  EXPECT_EQ(key, CompactDocumentKey{DocumentKey{}});
+  EXPECT_EQ(DocumentKey{}, key.ToDocumentKey());
+}
+
+TEST(CompactDocumentKey, Segments) {
+  const CompactDocumentKey key =
+      CompactDocumentKey::FromPathString("/rooms/eros/messages/1/");
+  ASSERT_EQ(4u, key.size());
+  EXPECT_EQ("rooms", key[0]);
+  EXPECT_EQ("eros", key[1]);
+  EXPECT_EQ("messages", key[2]);
+  EXPECT_EQ("1", key.segment(3));
+  EXPECT_EQ("rooms/eros/messages/1", key.CanonicalString());
+  EXPECT_ANY_THROW(key.segment(4));
+
+  EXPECT_ANY_THROW(CompactDocumentKey::FromPathString("rooms//eros"));
+  EXPECT_ANY_THROW(CompactDocumentKey::FromPathString("rooms"));
+}
+
+TEST(CompactDocumentKey, ConvertsToAndFromDocumentKey) {
+  const DocumentKey key = DocumentKey::FromSegments({"rooms", "", "a/b", "x"});
+  const CompactDocumentKey compact{key};
+  ASSERT_EQ(4u, compact.size());
+  EXPECT_EQ("", compact[1]);
+  EXPECT_EQ("a/b", compact[2]);
+  EXPECT_EQ(key, compact.ToDocumentKey());
+  EXPECT_EQ(compact, CompactDocumentKey{key.path()});
+
+  EXPECT_ANY_THROW(CompactDocumentKey{ResourcePath{"rooms"}});
+}
+
+TEST(CompactDocumentKey, Builder) {
+  CompactDocumentKey::Builder builder;
+  builder.AppendSegment("rooms");
+  builder.bytes()->append("er");
+  builder.bytes()->append("os");
+  builder.EndSegment();
+  EXPECT_EQ(2u, builder.size());
+  EXPECT_EQ(CompactDocumentKey::FromPathString("rooms/eros"), builder.Build());
+
+  builder.AppendSegment("messages");
+  EXPECT_ANY_THROW(builder.Build());
+}
+
+TEST(CompactDocumentKey, CopiesShareStorage) {
+  CompactDocumentKey key = CompactDocumentKey::FromPathString("rooms/eros");
+  const CompactDocumentKey copy = key;
+  EXPECT_EQ(&key[0][0], &copy[0][0]);
+
+  util::CountedAllocations counted;
+  size_t usage = key.HeapMemoryUsage(&counted);
+  EXPECT_LT(0u, usage);
+  EXPECT_EQ(0u, copy.HeapMemoryUsage(&counted));
+
+  const CompactDocumentKey moved = std::move(key);
+  EXPECT_TRUE(key.empty());  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(copy, moved);
+}
+
+TEST(CompactDocumentKey, Comparison) {
+  // Segments are compared as unsigned bytes, so "a\xff" sorts after "aa".
+  const std::vector<std::string> ordered{
+      "a/a",  "a/a/b/b", "a/a/b/c", "a/ab",    "a/b",
+      "aa/a", "a\xff/a", "b/a",     "b/a/a/a",
+  };
+  for (size_t i = 0; i < ordered.size(); i++) {
+    for (size_t j = 0; j < ordered.size(); j++) {
+      const auto lhs = CompactDocumentKey::FromPathString(ordered[i]);
+      const auto rhs = CompactDocumentKey::FromPathString(ordered[j]);
+      EXPECT_EQ(i < j, lhs < rhs) << ordered[i] << " vs " << ordered[j];
+      EXPECT_EQ(i == j, lhs == rhs) << ordered[i] << " vs " << ordered[j];
+      EXPECT_EQ(i >= j, lhs >= rhs) << ordered[i] << " vs " << ordered[j];
+
+      // The order is the same as DocumentKey's.
+      EXPECT_EQ(lhs.ToDocumentKey() < rhs.ToDocumentKey(), lhs < rhs);
+    }
+  }
+}
+
+TEST(CompactDocumentKey, Hash) {
+  std::unordered_set<CompactDocumentKey, HashCompactDocumentKey> keys;
+  keys.insert(CompactDocumentKey::FromPathString("rooms/eros"));
+  keys.insert(CompactDocumentKey::FromPathString("rooms/eros"));
+  keys.insert(CompactDocumentKey::FromPathString("room/seros"));
+  keys.insert(CompactDocumentKey::FromPathString("rooms/eros/messages/1"));
+  EXPECT_EQ(3u, keys.size());
+  EXPECT_EQ(1u, keys.count(CompactDocumentKey{
+                    DocumentKey::FromPathString("rooms/eros")}));
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/compact_document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+/** Returns paths of documents in a few collections, in no particular order. */
+std::vector<std::string> MakePaths(size_t count) {
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < count; i++) {
+    size_t shuffled = i * 7919 % count;
+    paths.push_back("rooms/room" + std::to_string(shuffled % 16) +
+                    "/messages/" + std::to_string(shuffled));
+  }
+  return paths;
+}
+
+template <typename KeyT>
+std::vector<KeyT> MakeKeys(size_t count) {
+  std::vector<KeyT> keys;
+  for (const std::string& path : MakePaths(count)) {
+    keys.push_back(KeyT::FromPathString(path));
+  }
+  return keys;
+}
+
+}  // namespace
+
+void BM_DocumentKeyFromPathString(benchmark::State& state) {
+  for (auto _ : state) {
+    DocumentKey key = DocumentKey::FromPathString("rooms/eros/messages/1");
+    benchmark::DoNotOptimize(key);
+  }
+}
+BENCHMARK(BM_DocumentKeyFromPathString);
+
+void BM_CompactDocumentKeyFromPathString(benchmark::State& state) {
+  for (auto _ : state) {
+    CompactDocumentKey key =
+        CompactDocumentKey::FromPathString("rooms/eros/messages/1");
+    benchmark::DoNotOptimize(key);
+  }
+}
+BENCHMARK(BM_CompactDocumentKeyFromPathString);
+
+void BM_DocumentKeySort(benchmark::State& state) {
+  const auto keys = MakeKeys<DocumentKey>(state.range(0));
+  for (auto _ : state) {
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    benchmark::DoNotOptimize(sorted);
+  }
+}
+BENCHMARK(BM_DocumentKeySort)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_CompactDocumentKeySort(benchmark::State& state) {
+  const auto keys = MakeKeys<CompactDocumentKey>(state.range(0));
+  for (auto _ : state) {
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    benchmark::DoNotOptimize(sorted);
+  }
+}
+BENCHMARK(BM_CompactDocumentKeySort)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_DocumentKeyMemoryUsage(benchmark::State& state) {
+  const auto keys = MakeKeys<DocumentKey>(state.range(0));
+  size_t usage = 0;
+  for (auto _ : state) {
+    usage = 0;
+    for (const DocumentKey& key : keys) {
+      usage += key.HeapMemoryUsage();
+    }
+  }
+  state.counters["bytes_per_key"] = static_cast<double>(usage) / keys.size();
+}
+BENCHMARK(BM_DocumentKeyMemoryUsage)->Arg(1 << 10);
+
+void BM_CompactDocumentKeyMemoryUsage(benchmark::State& state) {
+  const auto keys = MakeKeys<CompactDocumentKey>(state.range(0));
+  size_t usage = 0;
+  for (auto _ : state) {
+    usage = 0;
+    for (const CompactDocumentKey& key : keys) {
+      usage += key.HeapMemoryUsage();
+    }
+  }
+  state.counters["bytes_per_key"] = static_cast<double>(usage) / keys.size();
+}
+BENCHMARK(BM_CompactDocumentKeyMemoryUsage)->Arg(1 << 10);
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+/**
+ * Returns a set of keys of documents in one collection, the ones whose index
+ * is in [start, start + count * step) stepping by step.
+ */
+DocumentKeySet MakeKeySet(int start, int count, int step) {
+  std::vector<DocumentKey> keys;
+  for (int i = 0; i < count; i++) {
+    // Pad the ids so that they sort numerically.
+    std::string id = std::to_string(1000000 + start + i * step);
+    keys.push_back(DocumentKey::FromPathString("rooms/eros/messages/" + id));
+  }
+  return DocumentKeySet::FromSorted(keys.begin(), keys.end());
+}
+
+}  // namespace
+
+// The set operations are compared against inserting or erasing one key at a
+// time, which is what callers of FSTDocumentKeySet do today. The second set
+// overlaps half of the first.
+
+void BM_DocumentKeySetUnion(benchmark::State& state) {
+  int n = static_cast<int>(state.range(0));
+  DocumentKeySet lhs = MakeKeySet(0, n, 2);
+  DocumentKeySet rhs = MakeKeySet(n, n, 2);
+  for (auto _ : state) {
+    DocumentKeySet result = lhs.Union(rhs);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DocumentKeySetUnion)->Arg(10000);
+
+void BM_DocumentKeySetUnionByInsert(benchmark::State& state) {
+  int n = static_cast<int>(state.range(0));
+  DocumentKeySet lhs = MakeKeySet(0, n, 2);
+  DocumentKeySet rhs = MakeKeySet(n, n, 2);
+  for (auto _ : state) {
+    DocumentKeySet result = lhs;
+    for (const DocumentKey& key : rhs) {
+      result = result.insert(key);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DocumentKeySetUnionByInsert)->Arg(10000);
+
+void BM_DocumentKeySetIntersection(benchmark::State& state) {
+  int n = static_cast<int>(state.range(0));
+  DocumentKeySet lhs = MakeKeySet(0, n, 2);
+  DocumentKeySet rhs = MakeKeySet(n, n, 2);
+  for (auto _ : state) {
+    DocumentKeySet result = lhs.Intersection(rhs);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DocumentKeySetIntersection)->Arg(10000);
+
+void BM_DocumentKeySetIntersectionByInsert(benchmark::State& state) {
+  int n = static_cast<int>(state.range(0));
+  DocumentKeySet lhs = MakeKeySet(0, n, 2);
+  DocumentKeySet rhs = MakeKeySet(n, n, 2);
+  for (auto _ : state) {
+    DocumentKeySet result;
+    for (const DocumentKey& key : lhs) {
+      if (rhs.contains(key)) {
+        result = result.insert(key);
+      }
+    }
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DocumentKeySetIntersectionByInsert)->Arg(10000);
+
+void BM_DocumentKeySetDifference(benchmark::State& state) {
+  int n = static_cast<int>(state.range(0));
+  DocumentKeySet lhs = MakeKeySet(0, n, 2);
+  DocumentKeySet rhs = MakeKeySet(n, n, 2);
+  for (auto _ : state) {
+    DocumentKeySet result = lhs.Difference(rhs);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DocumentKeySetDifference)->Arg(10000);
+
+void BM_DocumentKeySetDifferenceByErase(benchmark::State& state) {
+  int n = static_cast<int>(state.range(0));
+  DocumentKeySet lhs = MakeKeySet(0, n, 2);
+  DocumentKeySet rhs = MakeKeySet(n, n, 2);
+  for (auto _ : state) {
+    DocumentKeySet result = lhs;
+    for (const DocumentKey& key : rhs) {
+      result = result.erase(key);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DocumentKeySetDifferenceByErase)->Arg(10000);
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -16,6 +16,7 @@
 
 #include <initializer_list>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -148,6 +149,14 @@ TEST(DocumentKey, Comparison) {
   EXPECT_TRUE(ab >= a);
 }
 
+TEST(DocumentKey, Hash) {
+  const DocumentKey key = DocumentKey::FromPathString("rooms/Eros");
+  std::unordered_set<DocumentKey, HashDocumentKey> keys{key};
+  EXPECT_EQ(1u, keys.count(DocumentKey::FromSegments({"rooms", "Eros"})));
+  EXPECT_EQ(0u, keys.count(DocumentKey::FromPathString("rooms/Zeus")));
+  EXPECT_EQ(HashResourcePath{}(key.path()), HashDocumentKey{}(key));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/document_size_counter.h"
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/no_document.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(DocumentSizeCounter, CountsDocuments) {
+  const DatabaseId database_id("p", "d");
+  const Document doc(
+      FieldValue::ObjectValue({{"field", FieldValue::StringValue("foo")}}),
+      DocumentKey::FromPathString("i/am/a/path"),
+      SnapshotVersion(Timestamp(123, 456)), false);
+  const NoDocument no_doc(DocumentKey::FromPathString("i/am/b/path"),
+                          SnapshotVersion(Timestamp(123, 456)));
+
+  DocumentSizeCounter counter(&database_id);
+  EXPECT_EQ(0u, counter.document_count());
+  EXPECT_EQ(0u, counter.memory_usage());
+  EXPECT_EQ(0u, counter.byte_size());
+
+  counter.Add(doc);
+  counter.Add(no_doc);
+  EXPECT_EQ(2u, counter.document_count());
+  EXPECT_EQ(doc.MemoryUsage() + no_doc.MemoryUsage(), counter.memory_usage());
+  // name: "projects/p/databases/d/documents/i/am/b/path"
+  // read_time: {seconds: 123 nanos: 456}
+  EXPECT_EQ(53u, no_doc.ByteSize(database_id));
+  EXPECT_EQ(doc.ByteSize(database_id) + 53u, counter.byte_size());
+
+  counter.Remove(doc.key());
+  EXPECT_EQ(1u, counter.document_count());
+  EXPECT_EQ(no_doc.MemoryUsage(), counter.memory_usage());
+  EXPECT_EQ(53u, counter.byte_size());
+
+  counter.Remove(no_doc.key());
+  EXPECT_EQ(0u, counter.document_count());
+  EXPECT_EQ(0u, counter.memory_usage());
+  EXPECT_EQ(0u, counter.byte_size());
+}
+
+TEST(DocumentSizeCounter, RemovesWhatWasAdded) {
+  const DatabaseId database_id("p", "d");
+  const DocumentKey key = DocumentKey::FromPathString("i/am/a/path");
+  const Document small(
+      FieldValue::ObjectValue({{"field", FieldValue::StringValue("foo")}}),
+      key, SnapshotVersion(Timestamp(123, 456)), false);
+  const Document large(FieldValue::ObjectValue(
+                           {{"field", FieldValue::StringValue(
+                                          std::string(1000, 'a'))}}),
+                       key, SnapshotVersion(Timestamp(123, 456)), false);
+
+  DocumentSizeCounter counter(&database_id);
+  counter.Add(small);
+  counter.Add(large);
+  EXPECT_EQ(1u, counter.document_count());
+  EXPECT_EQ(large.MemoryUsage(), counter.memory_usage());
+  EXPECT_EQ(large.ByteSize(database_id), counter.byte_size());
+
+  // Removing a key that was never added changes nothing.
+  counter.Remove(DocumentKey::FromPathString("i/am/b/path"));
+  EXPECT_EQ(1u, counter.document_count());
+
+  counter.Remove(key);
+  EXPECT_EQ(0u, counter.document_count());
+  EXPECT_EQ(0u, counter.memory_usage());
+  EXPECT_EQ(0u, counter.byte_size());
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
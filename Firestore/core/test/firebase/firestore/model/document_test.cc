@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 
+#include <unordered_set>
+
 #include "absl/strings/string_view.h"
 #include "gtest/gtest.h"
 
@@ -71,6 +73,52 @@ TEST(Document, Comparison) {
                           SnapshotVersion(Timestamp())));
 }
 
+TEST(Document, Hash) {
+  const HashMaybeDocument hash;
+  EXPECT_EQ(
+      hash(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true)),
+      hash(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true)));
+  EXPECT_NE(
+      hash(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true)),
+      hash(MakeDocument("bar", "i/am/a/path", Timestamp(123, 456), true)));
+  EXPECT_NE(
+      hash(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true)),
+      hash(MakeDocument("foo", "i/am/another/path", Timestamp(123, 456),
+                        true)));
+
+  std::unordered_set<Document, HashMaybeDocument> docs;
+  docs.insert(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true));
+  docs.insert(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true));
+  docs.insert(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), false));
+  EXPECT_EQ(2u, docs.size());
+}
+
+TEST(Document, ByteSize) {
+  // name: "projects/p/databases/d/documents/i/am/a/path"
+  // fields: {key: "field" value: {string_value: "foo"}}
+  // update_time: {seconds: 123 nanos: 456}
+  const DatabaseId database_id("p", "d");
+  EXPECT_EQ(46u + 17u + 7u,
+            MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true)
+                .ByteSize(database_id));
+}
+
+TEST(Document, MemoryUsage) {
+  const Document doc =
+      MakeDocument("foo", "i/am/a/path", Timestamp(123, 456), true);
+  size_t usage = doc.MemoryUsage();
+  EXPECT_LT(sizeof(Document) + doc.key().HeapMemoryUsage(), usage);
+  EXPECT_EQ(sizeof(Document) - sizeof(FieldValue) +
+                doc.data().MemoryUsage() + doc.key().HeapMemoryUsage(),
+            usage);
+
+  // A copy shares its key and data with the original.
+  const Document copy = doc;
+  util::CountedAllocations counted;
+  EXPECT_EQ(usage, doc.MemoryUsage(&counted));
+  EXPECT_EQ(sizeof(Document), copy.MemoryUsage(&counted));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -18,6 +18,7 @@
 
 #include <initializer_list>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -129,6 +130,26 @@ TEST(FieldPath, Comparison) {
   EXPECT_TRUE(ab > a);
 }
 
+TEST(FieldPath, Hash) {
+  const FieldPath abc{"a", "b", "c"};
+  EXPECT_EQ(abc.Hash(), FieldPath({"a", "b", "c"}).Hash());
+  EXPECT_NE(abc.Hash(), FieldPath({"a", "c", "b"}).Hash());
+
+  // Derived paths hash the same as ones built from scratch.
+  EXPECT_EQ(FieldPath({"a", "b"}).Hash(), abc.PopLast().Hash());
+  EXPECT_EQ(FieldPath({"b", "c"}).Hash(), abc.PopFirst().Hash());
+  EXPECT_EQ(FieldPath({"c"}).Hash(), abc.PopFirst(2).Hash());
+  EXPECT_EQ(FieldPath{}.Hash(), abc.PopFirst(3).Hash());
+  EXPECT_EQ(FieldPath({"a", "b", "c", "d"}).Hash(), abc.Append("d").Hash());
+  EXPECT_EQ(FieldPath({"a", "b", "c", "a", "b", "c"}).Hash(),
+            abc.Append(abc).Hash());
+  EXPECT_EQ(abc.Hash(), abc.Append("d").PopLast().Hash());
+
+  std::unordered_set<FieldPath, HashFieldPath> paths{abc, abc.PopLast()};
+  EXPECT_EQ(1u, paths.count(FieldPath::FromServerFormat("a.b")));
+  EXPECT_EQ(0u, paths.count(FieldPath::FromServerFormat("a")));
+}
+
 TEST(FieldPath, IsPrefixOf) {
   const FieldPath empty;
   const FieldPath a{"a"};
@@ -255,6 +276,18 @@ TEST(FieldPath, CanonicalStringEscaping) {
   EXPECT_EQ(FieldPath::FromServerFormat("a_").CanonicalString(), "a_");
 }
 
+TEST(FieldPath, CanonicalStringIsCached) {
+  const auto path = FieldPath::FromServerFormat("foo.`bar baz`");
+  EXPECT_EQ(path.CanonicalString(), "foo.`bar baz`");
+  EXPECT_EQ(path.CanonicalString(), "foo.`bar baz`");
+
+  // Copies share the cached string, but derived paths build their own.
+  const FieldPath copy = path;
+  EXPECT_EQ(copy.CanonicalString(), "foo.`bar baz`");
+  EXPECT_EQ(copy.PopLast().CanonicalString(), "foo");
+  EXPECT_EQ(copy.Append("qux").CanonicalString(), "foo.`bar baz`.qux");
+}
+
 TEST(FieldPath, EmptyPath) {
   const auto& empty_path = FieldPath::EmptyPath();
   EXPECT_EQ(empty_path, FieldPath{empty_path});
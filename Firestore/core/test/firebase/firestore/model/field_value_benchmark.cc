@@ -0,0 +1,202 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+/**
+ * Creates an object value of roughly the given size in bytes, made up of
+ * nested objects and arrays of 100-byte strings.
+ */
+FieldValue MakeObject(size_t approximate_size) {
+  const size_t kStringSize = 100;
+  const size_t kFieldsPerChild = 20;
+
+  std::map<std::string, FieldValue> root;
+  size_t size = 0;
+  for (int i = 0; size < approximate_size; i++) {
+    std::map<std::string, FieldValue> child;
+    std::vector<FieldValue> array;
+    for (size_t j = 0; j < kFieldsPerChild; j++) {
+      FieldValue value =
+          FieldValue::StringValue(std::string(kStringSize, 'a' + j % 26));
+      child["field" + std::to_string(j)] = value;
+      array.push_back(std::move(value));
+      size += 2 * kStringSize;
+    }
+    child["array"] = FieldValue::ArrayValue(std::move(array));
+    root["child" + std::to_string(i)] =
+        FieldValue::ObjectValue(std::move(child));
+  }
+  return FieldValue::ObjectValue(std::move(root));
+}
+
+/**
+ * Copies every node in the given value, which is what assigning a FieldValue
+ * used to cost before arrays and objects shared their contents.
+ */
+FieldValue DeepCopy(const FieldValue& value) {
+  switch (value.type()) {
+    case FieldValue::Type::Array: {
+      std::vector<FieldValue> copy;
+      for (const FieldValue& element : value.array_value()) {
+        copy.push_back(DeepCopy(element));
+      }
+      return FieldValue::ArrayValue(std::move(copy));
+    }
+    case FieldValue::Type::Object: {
+      std::map<std::string, FieldValue> copy;
+      for (const auto& kv : value.object_value()) {
+        copy.emplace(kv.first, DeepCopy(kv.second));
+      }
+      return FieldValue::ObjectValue(std::move(copy));
+    }
+    case FieldValue::Type::String:
+      return FieldValue::StringValue(value.string_value());
+    default:
+      return value;
+  }
+}
+
+}  // namespace
+
+void BM_FieldValueCopy(benchmark::State& state) {
+  FieldValue value = MakeObject(state.range(0));
+  for (auto _ : state) {
+    FieldValue copy = value;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_FieldValueCopy)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_FieldValueDeepCopy(benchmark::State& state) {
+  FieldValue value = MakeObject(state.range(0));
+  for (auto _ : state) {
+    FieldValue copy = DeepCopy(value);
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_FieldValueDeepCopy)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_ObjectIteration(benchmark::State& state) {
+  FieldValue value = MakeObject(state.range(0));
+  for (auto _ : state) {
+    size_t fields = 0;
+    for (const auto& kv : value.object_value()) {
+      fields += kv.second.object_value().size();
+    }
+    benchmark::DoNotOptimize(fields);
+  }
+}
+BENCHMARK(BM_ObjectIteration)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_ObjectCompare(benchmark::State& state) {
+  // Build two separate trees so that comparison can't short-circuit on
+  // shared contents.
+  FieldValue lhs = MakeObject(state.range(0));
+  FieldValue rhs = MakeObject(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs < rhs);
+  }
+}
+BENCHMARK(BM_ObjectCompare)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_ObjectEquals(benchmark::State& state) {
+  FieldValue lhs = MakeObject(state.range(0));
+  FieldValue rhs = MakeObject(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs == rhs);
+  }
+}
+BENCHMARK(BM_ObjectEquals)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_ObjectHash(benchmark::State& state) {
+  FieldValue value = MakeObject(state.range(0));
+  for (auto _ : state) {
+    // Only the first iteration walks the tree; the hash is cached after that.
+    benchmark::DoNotOptimize(value.Hash());
+  }
+}
+BENCHMARK(BM_ObjectHash)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_ObjectNotEqualsHashed(benchmark::State& state) {
+  // Once hashed, values that differ anywhere are rejected without a walk.
+  FieldValue lhs = MakeObject(state.range(0));
+  const FieldValue copy = DeepCopy(lhs);
+  FieldValue::FieldList fields{copy.object_value().begin(),
+                               copy.object_value().end()};
+  fields.emplace_back("extra", FieldValue::NullValue());
+  FieldValue rhs = FieldValue::FromFields(&fields);
+  lhs.Hash();
+  rhs.Hash();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs == rhs);
+  }
+}
+BENCHMARK(BM_ObjectNotEqualsHashed)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_ObjectSetField(benchmark::State& state) {
+  FieldValue value = MakeObject(state.range(0));
+  const FieldPath path{"child0", "field0"};
+  for (auto _ : state) {
+    FieldValue updated = value.Set(path, FieldValue::IntegerValue(1));
+    benchmark::DoNotOptimize(updated);
+  }
+}
+BENCHMARK(BM_ObjectSetField)->Arg(1 << 10)->Arg(100 << 10);
+
+void BM_WideObjectSetField(benchmark::State& state) {
+  // A flat object with the given number of fields, as in a large document
+  // receiving a one-field patch.
+  std::map<std::string, FieldValue> fields;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    fields["field" + std::to_string(i)] = FieldValue::IntegerValue(i);
+  }
+  FieldValue value = FieldValue::ObjectValue(std::move(fields));
+  const FieldPath path{"field0"};
+  for (auto _ : state) {
+    FieldValue updated = value.Set(path, FieldValue::IntegerValue(-1));
+    benchmark::DoNotOptimize(updated);
+  }
+}
+BENCHMARK(BM_WideObjectSetField)->Arg(10)->Arg(500)->Arg(5000);
+
+void BM_DocumentCopy(benchmark::State& state) {
+  Document doc(MakeObject(state.range(0)),
+               DocumentKey::FromPathString("rooms/eros"),
+               SnapshotVersion::None(), false);
+  for (auto _ : state) {
+    Document copy = doc;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_DocumentCopy)->Arg(1 << 10)->Arg(100 << 10);
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
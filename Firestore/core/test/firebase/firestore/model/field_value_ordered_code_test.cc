@@ -0,0 +1,291 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_value_ordered_code.h"
+
+#include <limits.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+using util::ComparisonResult;
+
+namespace {
+
+const DatabaseId kDatabaseId("project", "database");
+const DatabaseId kOtherDatabaseId("project", "other");
+
+const uint8_t* Bytes(const char* value) {
+  return reinterpret_cast<const uint8_t*>(value);
+}
+
+std::string EncodeIncreasing(const FieldValue& value) {
+  std::string result;
+  FieldValueOrderedCode::WriteIncreasing(&result, value);
+  return result;
+}
+
+std::string EncodeDecreasing(const FieldValue& value) {
+  std::string result;
+  FieldValueOrderedCode::WriteDecreasing(&result, value);
+  return result;
+}
+
+ComparisonResult CompareBytes(const std::string& lhs, const std::string& rhs) {
+  return util::ComparisonResultFromInt(lhs.compare(rhs));
+}
+
+FieldValue Reference(const char* path, const DatabaseId* database_id) {
+  return FieldValue::ReferenceValue(DocumentKey::FromPathString(path),
+                                    database_id);
+}
+
+/** A selection of values, in increasing order within each group. */
+std::vector<std::vector<FieldValue>> ValueGroups() {
+  return {
+      {FieldValue::NullValue()},
+      {FieldValue::FalseValue()},
+      {FieldValue::TrueValue()},
+      {FieldValue::NanValue(), FieldValue::DoubleValue(NAN)},
+      {FieldValue::DoubleValue(-INFINITY)},
+      {FieldValue::DoubleValue(-1e300)},
+      {FieldValue::DoubleValue(-9223372036854777856.0)},
+      {FieldValue::IntegerValue(LLONG_MIN),
+       FieldValue::DoubleValue(-9223372036854775808.0)},
+      {FieldValue::IntegerValue(LLONG_MIN + 1)},
+      {FieldValue::IntegerValue(-2), FieldValue::DoubleValue(-2.0)},
+      {FieldValue::DoubleValue(-1.5)},
+      {FieldValue::IntegerValue(-1), FieldValue::DoubleValue(-1.0)},
+      {FieldValue::DoubleValue(-0.5)},
+      {FieldValue::DoubleValue(-1e-300)},
+      {FieldValue::IntegerValue(0), FieldValue::DoubleValue(0.0),
+       FieldValue::DoubleValue(-0.0)},
+      {FieldValue::DoubleValue(1e-300)},
+      {FieldValue::DoubleValue(0.5)},
+      {FieldValue::IntegerValue(1), FieldValue::DoubleValue(1.0)},
+      {FieldValue::DoubleValue(1.5)},
+      {FieldValue::IntegerValue(9007199254740993LL)},
+      {FieldValue::IntegerValue(LLONG_MAX)},
+      {FieldValue::DoubleValue(9223372036854775808.0)},
+      {FieldValue::DoubleValue(1e300)},
+      {FieldValue::DoubleValue(INFINITY)},
+      {FieldValue::TimestampValue({-62135596800L, 0})},
+      {FieldValue::TimestampValue({0, 0})},
+      {FieldValue::TimestampValue({0, 1})},
+      {FieldValue::TimestampValue({1, 0})},
+      {FieldValue::ServerTimestampValue({0, 0}),
+       FieldValue::ServerTimestampValue({0, 0}, {1, 1})},
+      {FieldValue::ServerTimestampValue({1, 0})},
+      {FieldValue::StringValue("")},
+      {FieldValue::StringValue(std::string("\0", 1))},
+      {FieldValue::StringValue(std::string("\0\xff", 2))},
+      {FieldValue::StringValue("a")},
+      {FieldValue::StringValue("ab")},
+      {FieldValue::StringValue("a\xff")},
+      {FieldValue::StringValue("\xff")},
+      {FieldValue::BlobValue(Bytes(""), 0)},
+      {FieldValue::BlobValue(Bytes("\0"), 1)},
+      {FieldValue::BlobValue(Bytes("\x01\x02"), 2)},
+      {FieldValue::BlobValue(Bytes("\xff"), 1)},
+      {Reference("a/b", &kDatabaseId)},
+      {Reference("a/b/c/d", &kDatabaseId)},
+      {Reference("a/c", &kDatabaseId)},
+      {Reference("b/a", &kDatabaseId)},
+      {Reference("a/a", &kOtherDatabaseId)},
+      {FieldValue::GeoPointValue({-90, -180})},
+      {FieldValue::GeoPointValue({-0.0, 0}),
+       FieldValue::GeoPointValue({0, -0.0})},
+      {FieldValue::GeoPointValue({0, 1})},
+      {FieldValue::GeoPointValue({90, 180})},
+      {FieldValue::ArrayValue({})},
+      {FieldValue::ArrayValue({FieldValue::NullValue()})},
+      {FieldValue::ArrayValue(
+          {FieldValue::NullValue(), FieldValue::NullValue()})},
+      {FieldValue::ArrayValue({FieldValue::IntegerValue(1)}),
+       FieldValue::ArrayValue({FieldValue::DoubleValue(1.0)})},
+      {FieldValue::ArrayValue(
+          {FieldValue::IntegerValue(1), FieldValue::StringValue("a")})},
+      {FieldValue::ArrayValue({FieldValue::StringValue("")})},
+      {FieldValue::ObjectValue({})},
+      {FieldValue::ObjectValue({{"", FieldValue::TrueValue()}})},
+      {FieldValue::ObjectValue({{"a", FieldValue::NullValue()}})},
+      {FieldValue::ObjectValue(
+          {{"a", FieldValue::NullValue()}, {"b", FieldValue::NullValue()}})},
+      {FieldValue::ObjectValue({{"a", FieldValue::TrueValue()}})},
+      {FieldValue::ObjectValue(
+          {{"a", FieldValue::ObjectValue({{"a", FieldValue::NullValue()}})}})},
+      {FieldValue::ObjectValue({{"b", FieldValue::NullValue()}})},
+  };
+}
+
+}  // namespace
+
+TEST(FieldValueOrderedCode, GroupsAreOrdered) {
+  // Double check the test data against FieldValue's own ordering.
+  std::vector<std::vector<FieldValue>> groups = ValueGroups();
+  for (size_t i = 0; i < groups.size(); ++i) {
+    for (const FieldValue& value : groups[i]) {
+      EXPECT_EQ(ComparisonResult::Same, groups[i][0].Compare(value));
+      if (i > 0) {
+        EXPECT_EQ(ComparisonResult::Ascending,
+                  groups[i - 1][0].Compare(value));
+      }
+    }
+  }
+}
+
+TEST(FieldValueOrderedCode, EncodingsSortAsValues) {
+  std::vector<FieldValue> values;
+  for (const std::vector<FieldValue>& group : ValueGroups()) {
+    values.insert(values.end(), group.begin(), group.end());
+  }
+
+  for (const FieldValue& lhs : values) {
+    for (const FieldValue& rhs : values) {
+      ComparisonResult expected = lhs.Compare(rhs);
+      EXPECT_EQ(expected,
+                CompareBytes(EncodeIncreasing(lhs), EncodeIncreasing(rhs)));
+      EXPECT_EQ(util::ReverseOrder(expected),
+                CompareBytes(EncodeDecreasing(lhs), EncodeDecreasing(rhs)));
+    }
+  }
+}
+
+TEST(FieldValueOrderedCode, RoundTrips) {
+  for (const std::vector<FieldValue>& group : ValueGroups()) {
+    for (const FieldValue& value : group) {
+      // Follow each value with another item to check that reading stops at
+      // the end of the value.
+      std::string increasing = EncodeIncreasing(value);
+      util::OrderedCode::WriteString(&increasing, "next");
+      std::string decreasing = EncodeDecreasing(value);
+      util::OrderedCode::WriteString(&decreasing, "next");
+
+      const DatabaseId* database_id = &kDatabaseId;
+      if (value.type() == FieldValue::Type::Reference) {
+        database_id = value.reference_value().database_id;
+      }
+
+      FieldValue decoded;
+      absl::string_view src{increasing};
+      ASSERT_TRUE(
+          FieldValueOrderedCode::ReadIncreasing(&src, database_id, &decoded));
+      EXPECT_EQ(value, decoded);
+      std::string next;
+      EXPECT_TRUE(util::OrderedCode::ReadString(&src, &next));
+      EXPECT_EQ("next", next);
+
+      src = decreasing;
+      ASSERT_TRUE(
+          FieldValueOrderedCode::ReadDecreasing(&src, database_id, &decoded));
+      EXPECT_EQ(value, decoded);
+      EXPECT_EQ(EncodeDecreasing(value).size(),
+                decreasing.size() - src.size());
+    }
+  }
+}
+
+TEST(FieldValueOrderedCode, ReadsDecreasingSequences) {
+  // Values shorter and much longer than the prefix ReadDecreasing starts
+  // with, one after another as in a multi-column key.
+  std::vector<FieldValue> values;
+  for (int i = 0; i < 100; i++) {
+    values.push_back(FieldValue::IntegerValue(i));
+    values.push_back(
+        FieldValue::StringValue(std::string(i * 10, 'a' + i % 26)));
+    values.push_back(FieldValue::ArrayValue(
+        std::vector<FieldValue>(i, FieldValue::StringValue("element"))));
+  }
+  std::string encoded;
+  for (const FieldValue& value : values) {
+    FieldValueOrderedCode::WriteDecreasing(&encoded, value);
+  }
+
+  absl::string_view src{encoded};
+  for (const FieldValue& value : values) {
+    FieldValue decoded;
+    ASSERT_TRUE(
+        FieldValueOrderedCode::ReadDecreasing(&src, &kDatabaseId, &decoded));
+    EXPECT_EQ(value, decoded);
+  }
+  EXPECT_TRUE(src.empty());
+
+  // A value cut short is invalid, however long it is.
+  std::string truncated = EncodeDecreasing(values.back());
+  truncated.pop_back();
+  src = truncated;
+  FieldValue decoded;
+  EXPECT_FALSE(
+      FieldValueOrderedCode::ReadDecreasing(&src, &kDatabaseId, &decoded));
+}
+
+TEST(FieldValueOrderedCode, DecodesToCanonicalValues) {
+  FieldValue decoded;
+  std::string encoded = EncodeIncreasing(FieldValue::DoubleValue(-0.0));
+  absl::string_view src{encoded};
+  ASSERT_TRUE(
+      FieldValueOrderedCode::ReadIncreasing(&src, &kDatabaseId, &decoded));
+  EXPECT_EQ(FieldValue::Type::Integer, decoded.type());
+  EXPECT_EQ(0, decoded.integer_value());
+
+  encoded = EncodeIncreasing(FieldValue::DoubleValue(-1.25));
+  src = encoded;
+  ASSERT_TRUE(
+      FieldValueOrderedCode::ReadIncreasing(&src, &kDatabaseId, &decoded));
+  EXPECT_EQ(FieldValue::Type::Double, decoded.type());
+  EXPECT_EQ(-1.25, decoded.double_value());
+}
+
+TEST(FieldValueOrderedCode, RejectsInvalidInput) {
+  FieldValue decoded;
+  absl::string_view src;
+  EXPECT_FALSE(
+      FieldValueOrderedCode::ReadIncreasing(&src, &kDatabaseId, &decoded));
+
+  // References to another database can't be decoded.
+  std::string encoded =
+      EncodeIncreasing(Reference("a/b", &kOtherDatabaseId));
+  src = encoded;
+  EXPECT_FALSE(
+      FieldValueOrderedCode::ReadIncreasing(&src, &kDatabaseId, &decoded));
+
+  // Nor can truncated values.
+  encoded = EncodeIncreasing(FieldValue::ObjectValue(
+      {{"a", FieldValue::ArrayValue({FieldValue::StringValue("b")})}}));
+  for (size_t size = 0; size < encoded.size(); ++size) {
+    src = absl::string_view{encoded.data(), size};
+    EXPECT_FALSE(
+        FieldValueOrderedCode::ReadIncreasing(&src, &kDatabaseId, &decoded));
+  }
+
+  // Nor unknown types.
+  encoded = "\x7f";
+  src = encoded;
+  EXPECT_FALSE(
+      FieldValueOrderedCode::ReadIncreasing(&src, &kDatabaseId, &decoded));
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
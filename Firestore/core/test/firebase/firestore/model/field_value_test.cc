@@ -17,7 +17,13 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <limits.h>
+#include <math.h>
 
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -34,6 +40,18 @@ const uint8_t* Bytes(const char* value) {
   return reinterpret_cast<const uint8_t*>(value);
 }
 
+/** Returns the number of fields two objects share without copying them. */
+size_t CountSharedFields(const FieldValue& lhs, const FieldValue& rhs) {
+  size_t shared = 0;
+  for (const auto& kv : lhs.object_value()) {
+    auto found = rhs.object_value().find(kv.first);
+    if (found != rhs.object_value().end() && &*found == &kv) {
+      shared++;
+    }
+  }
+  return shared;
+}
+
 }  // namespace
 
 TEST(FieldValue, NullType) {
@@ -210,6 +228,32 @@ TEST(FieldValue, ObjectType) {
   EXPECT_FALSE(large < small);
 }
 
+TEST(FieldValue, ObjectFromFields) {
+  FieldValue::FieldList fields{{"c", FieldValue::NullValue()},
+                               {"a", FieldValue::TrueValue()},
+                               {"b", FieldValue::IntegerValue(1)}};
+  const FieldValue from_fields = FieldValue::FromFields(&fields);
+  EXPECT_TRUE(fields.empty());
+  const FieldValue from_std_map =
+      FieldValue::ObjectValue(std::map<std::string, FieldValue>{
+          {"a", FieldValue::TrueValue()},
+          {"b", FieldValue::IntegerValue(1)},
+          {"c", FieldValue::NullValue()}});
+  EXPECT_EQ(Type::Object, from_fields.type());
+  EXPECT_EQ(from_std_map, from_fields);
+
+  // Fields are kept sorted by name regardless of the input order.
+  std::vector<std::string> names;
+  for (const auto& kv : from_fields.object_value()) {
+    names.push_back(kv.first);
+  }
+  EXPECT_EQ((std::vector<std::string>{"a", "b", "c"}), names);
+
+  FieldValue::FieldList duplicates{{"a", FieldValue::TrueValue()},
+                                   {"a", FieldValue::FalseValue()}};
+  EXPECT_ANY_THROW(FieldValue::FromFields(&duplicates));
+}
+
 TEST(FieldValue, Copy) {
   FieldValue clone = FieldValue::TrueValue();
   const FieldValue null_value = FieldValue::NullValue();
@@ -442,6 +486,36 @@ TEST(FieldValue, Move) {
   EXPECT_EQ(FieldValue::NullValue(), clone);
 }
 
+TEST(FieldValue, CopySharesContents) {
+  const FieldValue blob_value = FieldValue::BlobValue(Bytes("abc"), 4);
+  FieldValue blob_clone = blob_value;
+  EXPECT_EQ(blob_value.blob_value().data(), blob_clone.blob_value().data());
+  EXPECT_EQ(blob_value, blob_clone);
+
+  const FieldValue array_value = FieldValue::ArrayValue(
+      std::vector<FieldValue>{FieldValue::TrueValue(),
+                              FieldValue::StringValue("abc")});
+  FieldValue array_clone = array_value;
+  EXPECT_EQ(&array_value.array_value(), &array_clone.array_value());
+  EXPECT_EQ(array_value, array_clone);
+
+  const FieldValue object_value =
+      FieldValue::ObjectValue(std::map<std::string, FieldValue>{
+          {"a", FieldValue::TrueValue()}, {"b", array_value}});
+  FieldValue object_clone = object_value;
+  EXPECT_EQ(&object_value.object_value(), &object_clone.object_value());
+  EXPECT_EQ(object_value, object_clone);
+
+  // Nested values are shared too.
+  const auto& nested = *object_clone.object_value().find("b");
+  EXPECT_EQ("b", nested.first);
+  EXPECT_EQ(&array_value.array_value(), &nested.second.array_value());
+
+  // Reassigning a clone leaves the original untouched.
+  object_clone = FieldValue::NullValue();
+  EXPECT_EQ(2u, object_value.object_value().size());
+}
+
 TEST(FieldValue, CompareMixedType) {
   const FieldValue null_value = FieldValue::NullValue();
   const FieldValue true_value = FieldValue::TrueValue();
@@ -495,6 +569,370 @@ TEST(FieldValue, CompareWithOperator) {
   EXPECT_FALSE(small == large);
 }
 
+TEST(FieldValue, ThreeWayCompare) {
+  using util::ComparisonResult;
+  const FieldValue one = FieldValue::IntegerValue(1);
+  const FieldValue two = FieldValue::DoubleValue(2.0);
+  EXPECT_EQ(ComparisonResult::Ascending, one.Compare(two));
+  EXPECT_EQ(ComparisonResult::Descending, two.Compare(one));
+  EXPECT_EQ(ComparisonResult::Same, one.Compare(FieldValue::DoubleValue(1.0)));
+  EXPECT_EQ(ComparisonResult::Ascending,
+            FieldValue::NullValue().Compare(FieldValue::FalseValue()));
+
+  const FieldValue short_array =
+      FieldValue::ArrayValue(std::vector<FieldValue>{one});
+  const FieldValue long_array =
+      FieldValue::ArrayValue(std::vector<FieldValue>{one, one});
+  EXPECT_EQ(ComparisonResult::Ascending, short_array.Compare(long_array));
+  EXPECT_EQ(ComparisonResult::Descending, long_array.Compare(short_array));
+
+  const FieldValue a = FieldValue::ObjectValue(
+      std::map<std::string, FieldValue>{{"a", one}, {"b", two}});
+  const FieldValue b = FieldValue::ObjectValue(
+      std::map<std::string, FieldValue>{{"a", one}, {"c", one}});
+  EXPECT_EQ(ComparisonResult::Ascending, a.Compare(b));
+  EXPECT_EQ(ComparisonResult::Descending, b.Compare(a));
+  EXPECT_EQ(ComparisonResult::Same, a.Compare(a));
+}
+
+TEST(FieldValue, Equals) {
+  // Equality agrees with comparison for numbers of mixed types and NaN.
+  EXPECT_EQ(FieldValue::IntegerValue(1), FieldValue::DoubleValue(1.0));
+  EXPECT_NE(FieldValue::IntegerValue(1), FieldValue::DoubleValue(1.5));
+  EXPECT_EQ(FieldValue::NanValue(), FieldValue::DoubleValue(NAN));
+  EXPECT_NE(FieldValue::NullValue(), FieldValue::FalseValue());
+  EXPECT_NE(FieldValue::StringValue("a"), FieldValue::StringValue("ab"));
+
+  const FieldValue array = FieldValue::ArrayValue(std::vector<FieldValue>{
+      FieldValue::IntegerValue(1), FieldValue::StringValue("a")});
+  EXPECT_EQ(array, FieldValue::ArrayValue(std::vector<FieldValue>{
+                       FieldValue::DoubleValue(1.0),
+                       FieldValue::StringValue("a")}));
+  EXPECT_NE(array, FieldValue::ArrayValue(std::vector<FieldValue>{
+                       FieldValue::IntegerValue(1)}));
+
+  const FieldValue object = FieldValue::ObjectValue(
+      std::map<std::string, FieldValue>{{"a", array}, {"b", array}});
+  EXPECT_EQ(object,
+            FieldValue::ObjectValue(std::map<std::string, FieldValue>{
+                {"a", array}, {"b", array}}));
+  EXPECT_NE(object,
+            FieldValue::ObjectValue(std::map<std::string, FieldValue>{
+                {"a", array}, {"c", array}}));
+  EXPECT_NE(object, FieldValue::ObjectValue(
+                        std::map<std::string, FieldValue>{{"a", array}}));
+}
+
+TEST(FieldValue, HashIsConsistentWithEquals) {
+  const HashFieldValue hash;
+  EXPECT_EQ(hash(FieldValue::IntegerValue(1)),
+            hash(FieldValue::DoubleValue(1.0)));
+  EXPECT_EQ(hash(FieldValue::DoubleValue(0.0)),
+            hash(FieldValue::DoubleValue(-0.0)));
+  EXPECT_EQ(hash(FieldValue::NanValue()), hash(FieldValue::DoubleValue(NAN)));
+  EXPECT_EQ(hash(FieldValue::IntegerValue(LLONG_MIN)),
+            hash(FieldValue::DoubleValue(static_cast<double>(LLONG_MIN))));
+  EXPECT_EQ(hash(FieldValue::ServerTimestampValue(Timestamp(1, 2))),
+            hash(FieldValue::ServerTimestampValue(Timestamp(1, 2),
+                                                  Timestamp(3, 4))));
+  EXPECT_EQ(hash(FieldValue::BlobValue(Bytes("abc"), 3)),
+            hash(FieldValue::BlobValue(Bytes("abc"), 3)));
+  EXPECT_EQ(hash(FieldValue::GeoPointValue({0.0, 1.0})),
+            hash(FieldValue::GeoPointValue({-0.0, 1.0})));
+
+  // Structurally identical trees hash the same however they were built.
+  const FieldValue object = FieldValue::ObjectValue(
+      {{"a", FieldValue::ArrayValue({FieldValue::IntegerValue(1)})},
+       {"b", FieldValue::StringValue("b")}});
+  FieldValue::FieldList fields{
+      {"b", FieldValue::StringValue("b")},
+      {"a", FieldValue::ArrayValue({FieldValue::DoubleValue(1.0)})}};
+  const FieldValue rebuilt = FieldValue::FromFields(&fields);
+  EXPECT_EQ(object, rebuilt);
+  EXPECT_EQ(hash(object), hash(rebuilt));
+
+  // Containers cache their hash; hashing again gives the same answer.
+  EXPECT_EQ(hash(object), hash(object));
+  const FieldValue copy = object;
+  EXPECT_EQ(hash(object), hash(copy));
+}
+
+TEST(FieldValue, HashDistinguishesValues) {
+  const HashFieldValue hash;
+  EXPECT_NE(hash(FieldValue::NullValue()), hash(FieldValue::FalseValue()));
+  EXPECT_NE(hash(FieldValue::TrueValue()), hash(FieldValue::FalseValue()));
+  EXPECT_NE(hash(FieldValue::IntegerValue(1)),
+            hash(FieldValue::IntegerValue(2)));
+  EXPECT_NE(hash(FieldValue::StringValue("a")),
+            hash(FieldValue::StringValue("b")));
+  EXPECT_NE(hash(FieldValue::ArrayValue({})),
+            hash(FieldValue::ObjectValue({})));
+  EXPECT_NE(hash(FieldValue::ObjectValue({{"a", FieldValue::TrueValue()}})),
+            hash(FieldValue::ObjectValue({{"b", FieldValue::TrueValue()}})));
+}
+
+TEST(FieldValue, HashSpreadsSimilarValues) {
+  // Small nested arrays, e.g. [[0, 31]] and [[1, 0]], differ only slightly.
+  std::unordered_set<size_t> hashes;
+  for (int64_t i = 0; i < 64; i++) {
+    for (int64_t j = 0; j < 64; j++) {
+      FieldValue pair = FieldValue::ArrayValue(
+          {FieldValue::IntegerValue(i), FieldValue::IntegerValue(j)});
+      hashes.insert(FieldValue::ArrayValue({pair}).Hash());
+      hashes.insert(FieldValue::ObjectValue({{"a", pair}}).Hash());
+    }
+  }
+  EXPECT_EQ(2u * 64 * 64, hashes.size());
+}
+
+TEST(FieldValue, EqualsAfterHashing) {
+  const FieldValue lhs = FieldValue::ArrayValue(
+      {FieldValue::StringValue("a"), FieldValue::StringValue("b")});
+  const FieldValue same = FieldValue::ArrayValue(
+      {FieldValue::StringValue("a"), FieldValue::StringValue("b")});
+  const FieldValue different = FieldValue::ArrayValue(
+      {FieldValue::StringValue("a"), FieldValue::StringValue("c")});
+  lhs.Hash();
+  same.Hash();
+  different.Hash();
+  EXPECT_EQ(lhs, same);
+  EXPECT_NE(lhs, different);
+}
+
+TEST(FieldValue, UnorderedSet) {
+  const std::map<std::string, FieldValue> fields{
+      {"a", FieldValue::StringValue("a")}};
+  std::unordered_set<FieldValue, HashFieldValue> values;
+  values.insert(FieldValue::IntegerValue(1));
+  values.insert(FieldValue::DoubleValue(1.0));
+  values.insert(FieldValue::StringValue("a"));
+  values.insert(FieldValue::ObjectValue(fields));
+  values.insert(FieldValue::ObjectValue(fields));
+  EXPECT_EQ(3u, values.size());
+  EXPECT_EQ(1u, values.count(FieldValue::DoubleValue(1.0)));
+  EXPECT_EQ(1u, values.count(FieldValue::ObjectValue(fields)));
+}
+
+TEST(FieldValue, GetByPath) {
+  const FieldValue value = FieldValue::ObjectValue(
+      {{"a", FieldValue::ObjectValue({{"b", FieldValue::IntegerValue(1)}})},
+       {"c", FieldValue::StringValue("c")}});
+
+  EXPECT_EQ(&value, value.Get(FieldPath::EmptyPath()));
+  EXPECT_EQ(FieldValue::StringValue("c"), *value.Get(FieldPath{"c"}));
+  EXPECT_EQ(FieldValue::IntegerValue(1), *value.Get(FieldPath{"a", "b"}));
+  EXPECT_EQ(nullptr, value.Get(FieldPath{"b"}));
+  EXPECT_EQ(nullptr, value.Get(FieldPath{"a", "c"}));
+  // Paths through non-object values don't exist.
+  EXPECT_EQ(nullptr, value.Get(FieldPath{"c", "d"}));
+}
+
+TEST(FieldValue, SetByPath) {
+  const FieldValue untouched =
+      FieldValue::ObjectValue({{"x", FieldValue::IntegerValue(1)}});
+  const FieldValue value = FieldValue::ObjectValue(
+      {{"a", FieldValue::ObjectValue({{"b", FieldValue::IntegerValue(1)}})},
+       {"c", FieldValue::StringValue("c")},
+       {"u", untouched}});
+
+  const FieldValue updated =
+      value.Set(FieldPath{"a", "b"}, FieldValue::IntegerValue(2));
+  EXPECT_EQ(FieldValue::ObjectValue(
+                {{"a", FieldValue::ObjectValue(
+                           {{"b", FieldValue::IntegerValue(2)}})},
+                 {"c", FieldValue::StringValue("c")},
+                 {"u", untouched}}),
+            updated);
+  // The original is unchanged and untouched subtrees are shared.
+  EXPECT_EQ(FieldValue::IntegerValue(1), *value.Get(FieldPath{"a", "b"}));
+  EXPECT_EQ(&untouched.object_value(),
+            &updated.Get(FieldPath{"u"})->object_value());
+
+  // Intermediate objects are created, replacing non-object values.
+  EXPECT_EQ(FieldValue::ObjectValue(
+                {{"d", FieldValue::ObjectValue(
+                           {{"e", FieldValue::TrueValue()}})}}),
+            FieldValue::ObjectValue({}).Set(FieldPath{"d", "e"},
+                                            FieldValue::TrueValue()));
+  EXPECT_EQ(FieldValue::ObjectValue(
+                {{"c", FieldValue::ObjectValue(
+                           {{"e", FieldValue::TrueValue()}})}}),
+            FieldValue::ObjectValue({{"c", FieldValue::StringValue("c")}})
+                .Set(FieldPath{"c", "e"}, FieldValue::TrueValue()));
+
+  // New fields are inserted in order.
+  const FieldValue inserted =
+      value.Set(FieldPath{"b"}, FieldValue::NullValue());
+  ASSERT_EQ(4u, inserted.object_value().size());
+  EXPECT_EQ("b", std::next(inserted.object_value().begin())->first);
+}
+
+TEST(FieldValue, DeleteByPath) {
+  const FieldValue value = FieldValue::ObjectValue(
+      {{"a", FieldValue::ObjectValue({{"b", FieldValue::IntegerValue(1)},
+                                      {"c", FieldValue::IntegerValue(2)}})},
+       {"d", FieldValue::StringValue("d")}});
+
+  EXPECT_EQ(FieldValue::ObjectValue(
+                {{"a", FieldValue::ObjectValue(
+                           {{"b", FieldValue::IntegerValue(1)},
+                            {"c", FieldValue::IntegerValue(2)}})}}),
+            value.Delete(FieldPath{"d"}));
+  EXPECT_EQ(FieldValue::ObjectValue(
+                {{"a", FieldValue::ObjectValue(
+                           {{"c", FieldValue::IntegerValue(2)}})},
+                 {"d", FieldValue::StringValue("d")}}),
+            value.Delete(FieldPath{"a", "b"}));
+
+  // Deleting a missing field leaves the value as it was, sharing its contents.
+  const FieldValue same = value.Delete(FieldPath{"a", "x"});
+  EXPECT_EQ(value, same);
+  EXPECT_EQ(&value.object_value(), &same.object_value());
+  EXPECT_EQ(&value.object_value(),
+            &value.Delete(FieldPath{"d", "x"}).object_value());
+}
+
+TEST(FieldValue, SetReplacesEqualValues) {
+  // Integer 1 and Double 1.0 are equal, but Set() must still store the Double.
+  const FieldValue value = FieldValue::ObjectValue(
+      {{"a", FieldValue::IntegerValue(1)},
+       {"b", FieldValue::ObjectValue({{"c", FieldValue::IntegerValue(1)}})}});
+
+  const FieldValue updated =
+      value.Set(FieldPath{"a"}, FieldValue::DoubleValue(1.0));
+  EXPECT_EQ(Type::Double, updated.Get(FieldPath{"a"})->type());
+  const FieldValue nested =
+      value.Set(FieldPath{"b", "c"}, FieldValue::DoubleValue(1.0));
+  EXPECT_EQ(Type::Double, nested.Get(FieldPath{"b", "c"})->type());
+}
+
+TEST(FieldValue, SetAndDeleteCopyOnlyThePathInWideObjects) {
+  std::map<std::string, FieldValue> fields;
+  for (int i = 0; i < 500; i++) {
+    fields[std::to_string(i)] = FieldValue::IntegerValue(i);
+  }
+  const FieldValue value = FieldValue::ObjectValue(fields);
+
+  const FieldValue updated =
+      value.Set(FieldPath{"250"}, FieldValue::IntegerValue(-1));
+  EXPECT_EQ(FieldValue::IntegerValue(-1), *updated.Get(FieldPath{"250"}));
+  EXPECT_EQ(FieldValue::IntegerValue(250), *value.Get(FieldPath{"250"}));
+  // Only the few tree nodes on the way to the field were copied.
+  EXPECT_LE(450u, CountSharedFields(value, updated));
+
+  const FieldValue deleted = value.Delete(FieldPath{"250"});
+  EXPECT_EQ(499u, deleted.object_value().size());
+  EXPECT_EQ(nullptr, deleted.Get(FieldPath{"250"}));
+  EXPECT_LE(450u, CountSharedFields(value, deleted));
+}
+
+TEST(FieldValue, ByteSize) {
+  // These match the encodings in remote/serializer_test.cc.
+  EXPECT_EQ(2u, FieldValue::NullValue().ByteSize());
+  EXPECT_EQ(2u, FieldValue::TrueValue().ByteSize());
+  EXPECT_EQ(2u, FieldValue::IntegerValue(0).ByteSize());
+  EXPECT_EQ(2u, FieldValue::IntegerValue(100).ByteSize());
+  EXPECT_EQ(11u, FieldValue::IntegerValue(-1).ByteSize());
+  EXPECT_EQ(10u, FieldValue::IntegerValue(LLONG_MAX).ByteSize());
+  EXPECT_EQ(3u, FieldValue::StringValue("").ByteSize());
+  EXPECT_EQ(10u, FieldValue::StringValue("abc def").ByteSize());
+  EXPECT_EQ(2u, FieldValue::ObjectValue({}).ByteSize());
+  FieldValue nested = FieldValue::ObjectValue(
+      {{"e", FieldValue::IntegerValue(LLONG_MAX)}});
+  EXPECT_EQ(91u, FieldValue::ObjectValue(
+                     {{"b", FieldValue::TrueValue()},
+                      {"i", FieldValue::IntegerValue(1)},
+                      {"n", FieldValue::NullValue()},
+                      {"o", FieldValue::ObjectValue(
+                                {{"d", FieldValue::IntegerValue(100)},
+                                 {"nested", nested}})},
+                      {"s", FieldValue::StringValue("foo")}})
+                     .ByteSize());
+
+  // TEXT_FORMAT_PROTO: 'double_value: 1.5'
+  EXPECT_EQ(9u, FieldValue::DoubleValue(1.5).ByteSize());
+  // TEXT_FORMAT_PROTO: 'timestamp_value: {seconds: 1 nanos: 2}'
+  EXPECT_EQ(6u, FieldValue::TimestampValue({1, 2}).ByteSize());
+  // TEXT_FORMAT_PROTO: 'timestamp_value: {}'
+  EXPECT_EQ(2u, FieldValue::TimestampValue({0, 0}).ByteSize());
+  // TEXT_FORMAT_PROTO: 'geo_point_value: {latitude: 1.5 longitude: -2}'
+  EXPECT_EQ(20u, FieldValue::GeoPointValue({1.5, -2}).ByteSize());
+  // TEXT_FORMAT_PROTO: 'bytes_value: "\001\002"'
+  const uint8_t blob[] = {1, 2};
+  EXPECT_EQ(5u, FieldValue::BlobValue(blob, 2).ByteSize());
+  // TEXT_FORMAT_PROTO: 'array_value: {values: {integer_value: 1}
+  //                                   values: {string_value: "a"}}'
+  EXPECT_EQ(12u, FieldValue::ArrayValue({FieldValue::IntegerValue(1),
+                                         FieldValue::StringValue("a")})
+                     .ByteSize());
+  // TEXT_FORMAT_PROTO:
+  //   'reference_value: "projects/p/databases/d/documents/a/b"'
+  const DatabaseId database_id("p", "d");
+  EXPECT_EQ(38u, FieldValue::ReferenceValue(DocumentKey::FromPathString("a/b"),
+                                            &database_id)
+                     .ByteSize());
+}
+
+TEST(FieldValue, MemoryUsage) {
+  EXPECT_EQ(sizeof(FieldValue), FieldValue::IntegerValue(1).MemoryUsage());
+  EXPECT_EQ(sizeof(FieldValue), FieldValue::StringValue("a").MemoryUsage());
+  EXPECT_LT(sizeof(FieldValue), FieldValue::ObjectValue({}).MemoryUsage());
+
+  const std::string long_string(1000, 'a');
+  const FieldValue string_value = FieldValue::StringValue(long_string);
+  EXPECT_LT(sizeof(FieldValue) + 1000, string_value.MemoryUsage());
+
+  const FieldValue array = FieldValue::ArrayValue({string_value});
+  size_t array_usage = array.MemoryUsage();
+  EXPECT_LT(string_value.MemoryUsage(), array_usage);
+
+  // The same contents appear twice in this object, and are counted twice
+  // unless given a set of what has been counted.
+  const FieldValue object =
+      FieldValue::ObjectValue({{"a", array}, {"b", array}});
+  size_t object_usage = object.MemoryUsage();
+  EXPECT_LT(2 * array_usage, object_usage);
+
+  util::CountedAllocations counted;
+  size_t deduplicated_usage = object.MemoryUsage(&counted);
+  EXPECT_LT(array_usage, deduplicated_usage);
+  EXPECT_GT(object_usage, deduplicated_usage);
+  EXPECT_EQ(sizeof(FieldValue), array.MemoryUsage(&counted));
+}
+
+TEST(FieldValue, SmallObjectMemoryUsageIsProportionalToFields) {
+  using Entry = FieldValue::Map::value_type;
+  const FieldValue one =
+      FieldValue::ObjectValue({{"a", FieldValue::TrueValue()}});
+  const FieldValue two = one.Set(FieldPath{"b"}, FieldValue::TrueValue());
+  const FieldValue four = two.Set(FieldPath{"c"}, FieldValue::TrueValue())
+                              .Set(FieldPath{"d"}, FieldValue::TrueValue());
+
+  // Each field costs its entry, not room for Map::kFixedSize of them.
+  EXPECT_GT(4 * sizeof(Entry), one.MemoryUsage());
+  EXPECT_EQ(one.MemoryUsage() + sizeof(Entry), two.MemoryUsage());
+  EXPECT_EQ(one.MemoryUsage() + 3 * sizeof(Entry), four.MemoryUsage());
+}
+
+TEST(FieldValue, ObjectInArena) {
+  auto arena = std::make_shared<util::Arena>();
+  FieldValue::FieldList fields{{"b", FieldValue::IntegerValue(2)},
+                               {"a", FieldValue::IntegerValue(1)}};
+  const FieldValue value = FieldValue::FromFields(&fields, arena);
+
+  EXPECT_EQ(FieldValue::ObjectValue({{"a", FieldValue::IntegerValue(1)},
+                                     {"b", FieldValue::IntegerValue(2)}}),
+            value);
+  size_t allocated = arena->bytes_allocated();
+  EXPECT_LT(0u, allocated);
+
+  // Values derived from it are built on the heap.
+  const FieldValue updated =
+      value.Set(FieldPath{"c"}, FieldValue::IntegerValue(3));
+  EXPECT_EQ(3u, updated.object_value().size());
+  EXPECT_EQ(allocated, arena->bytes_allocated());
+}
+
 }  //  namespace model
 }  //  namespace firestore
 }  //  namespace firebase
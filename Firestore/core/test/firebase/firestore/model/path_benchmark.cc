@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+const char kResourcePath[] = "rooms/eros/messages/4fa92b7c/reactions/thumbs";
+const char kFieldPath[] = "metadata.author.profile.displayName";
+const char kEscapedFieldPath[] = "metadata.`author.id`.`na\\`me`";
+
+}  // namespace
+
+void BM_ResourcePathFromString(benchmark::State& state) {
+  for (auto _ : state) {
+    ResourcePath path = ResourcePath::FromString(kResourcePath);
+    benchmark::DoNotOptimize(path);
+  }
+}
+BENCHMARK(BM_ResourcePathFromString);
+
+void BM_FieldPathFromServerFormat(benchmark::State& state) {
+  for (auto _ : state) {
+    FieldPath path = FieldPath::FromServerFormat(kFieldPath);
+    benchmark::DoNotOptimize(path);
+  }
+}
+BENCHMARK(BM_FieldPathFromServerFormat);
+
+void BM_FieldPathFromServerFormatEscaped(benchmark::State& state) {
+  for (auto _ : state) {
+    FieldPath path = FieldPath::FromServerFormat(kEscapedFieldPath);
+    benchmark::DoNotOptimize(path);
+  }
+}
+BENCHMARK(BM_FieldPathFromServerFormatEscaped);
+
+void BM_ResourcePathCanonicalString(benchmark::State& state) {
+  const ResourcePath path = ResourcePath::FromString(kResourcePath);
+  for (auto _ : state) {
+    // A fresh copy of the segments, so that the string isn't cached yet.
+    ResourcePath copy{path.begin(), path.end()};
+    benchmark::DoNotOptimize(copy.CanonicalString());
+  }
+}
+BENCHMARK(BM_ResourcePathCanonicalString);
+
+void BM_FieldPathCanonicalString(benchmark::State& state) {
+  const FieldPath path = FieldPath::FromServerFormat(kEscapedFieldPath);
+  for (auto _ : state) {
+    FieldPath copy{path.begin(), path.end()};
+    benchmark::DoNotOptimize(copy.CanonicalString());
+  }
+}
+BENCHMARK(BM_FieldPathCanonicalString);
+
+void BM_FieldPathCanonicalStringCached(benchmark::State& state) {
+  const FieldPath path = FieldPath::FromServerFormat(kEscapedFieldPath);
+  for (auto _ : state) {
+    // Only the first iteration builds the string.
+    benchmark::DoNotOptimize(path.CanonicalString());
+  }
+}
+BENCHMARK(BM_FieldPathCanonicalStringCached);
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
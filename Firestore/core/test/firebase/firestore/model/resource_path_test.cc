@@ -18,6 +18,7 @@
 
 #include <initializer_list>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -72,6 +73,56 @@ TEST(ResourcePath, Comparison) {
   EXPECT_TRUE(ab > a);
 }
 
+TEST(ResourcePath, DerivedPathsShareSegments) {
+  const ResourcePath collection = ResourcePath{}.Append("rooms");
+  const ResourcePath document = collection.Append("Eros");
+  const ResourcePath subcollection = document.Append("messages");
+  EXPECT_EQ(ResourcePath({"rooms", "Eros", "messages"}), subcollection);
+
+  // A chain of appends fills the same storage in place.
+  EXPECT_EQ(collection.begin().base(), subcollection.begin().base());
+  EXPECT_EQ((document.begin() + 1).base(), (subcollection.begin() + 1).base());
+
+  // Popping segments never copies them.
+  EXPECT_EQ((subcollection.begin() + 1).base(),
+            subcollection.PopFirst().begin().base());
+  EXPECT_EQ(subcollection.begin().base(),
+            subcollection.PopLast().begin().base());
+
+  // Once the slot after a path is taken, appending to it copies the path into
+  // new storage, though the segments themselves are still shared.
+  const ResourcePath sibling = collection.Append("Zeus");
+  EXPECT_NE(collection.begin().base(), sibling.begin().base());
+  EXPECT_EQ(&collection[0], &sibling[0]);
+  EXPECT_EQ(ResourcePath({"rooms", "Zeus"}), sibling);
+  EXPECT_EQ(ResourcePath({"rooms", "Eros"}), document);
+
+  EXPECT_TRUE(collection.IsPrefixOf(sibling));
+  EXPECT_FALSE(document.IsPrefixOf(sibling));
+}
+
+TEST(ResourcePath, ConcurrentAppends) {
+  const ResourcePath collection = ResourcePath{}.Append("rooms");
+  std::vector<ResourcePath> results(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); i++) {
+    threads.emplace_back([&collection, &results, i] {
+      results[i] = collection.Append(std::to_string(i));
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Exactly one of the appends was made in place, and none clobbered another.
+  int in_place = 0;
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_EQ(ResourcePath({"rooms", std::to_string(i)}), results[i]);
+    in_place += results[i].begin().base() == collection.begin().base();
+  }
+  EXPECT_EQ(1, in_place);
+}
+
 TEST(ResourcePath, Parsing) {
   const auto parse = [](const std::pair<std::string, size_t> expected) {
     const auto path = ResourcePath::FromString(expected.first);
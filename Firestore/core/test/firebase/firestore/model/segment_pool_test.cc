@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/segment_pool.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(SegmentPool, InternsEqualSegments) {
+  SegmentPool pool;
+  auto first = pool.Intern("messages");
+  auto second = pool.Intern("messages");
+  auto other = pool.Intern("users");
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, other);
+  EXPECT_EQ("messages", *first);
+  EXPECT_EQ(2u, pool.size());
+
+  EXPECT_EQ(3u, pool.lookup_count());
+  EXPECT_EQ(1u, pool.hit_count());
+  EXPECT_DOUBLE_EQ(1.0 / 3, pool.hit_rate());
+  EXPECT_LE(sizeof(std::string), pool.bytes_saved());
+}
+
+TEST(SegmentPool, ForgetsUnusedSegments) {
+  SegmentPool pool;
+  std::weak_ptr<const std::string> weak_segment = pool.Intern("messages");
+  EXPECT_TRUE(weak_segment.expired());
+
+  // A segment interned again after it expired is a new one.
+  auto segment = pool.Intern("messages");
+  EXPECT_EQ("messages", *segment);
+  EXPECT_EQ(0u, pool.hit_count());
+
+  // Segments leave the pool as soon as they're no longer used.
+  for (int i = 0; i < 1000; i++) {
+    pool.Intern(std::to_string(i));
+  }
+  EXPECT_EQ(1u, pool.size());
+  EXPECT_EQ(segment, pool.Intern("messages"));
+}
+
+TEST(SegmentPool, SegmentsOutliveThePool) {
+  std::shared_ptr<const std::string> segment;
+  {
+    SegmentPool pool;
+    segment = pool.Intern("messages");
+  }
+  EXPECT_EQ("messages", *segment);
+  segment.reset();
+}
+
+TEST(SegmentPool, PathsInternSegmentsOnlyWhenEnabled) {
+  const ResourcePath before = ResourcePath::FromString("rooms/Eros");
+  const ResourcePath before2 = ResourcePath::FromString("rooms/Zeus");
+  EXPECT_NE(&before[0], &before2[0]);
+
+  SegmentPool pool;
+  SegmentPool::SetDefault(&pool);
+  const ResourcePath first = ResourcePath::FromString("rooms/Eros");
+  const ResourcePath second = ResourcePath{"rooms", "Zeus"};
+  const FieldPath field_path = FieldPath::FromServerFormat("rooms.name");
+  SegmentPool::SetDefault(nullptr);
+
+  EXPECT_EQ(&first[0], &second[0]);
+  EXPECT_EQ(&first[0], &field_path[0]);
+  EXPECT_EQ(2u, pool.hit_count());
+
+  // Interned segments outlive the pool's default status.
+  EXPECT_EQ(before, first);
+  EXPECT_LT(first, second);
+}
+
+TEST(SegmentPool, ConcurrentInterning) {
+  SegmentPool pool;
+  std::vector<std::shared_ptr<const std::string>> results(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); i++) {
+    threads.emplace_back([&pool, &results, i] {
+      for (int j = 0; j < 100; j++) {
+        pool.Intern(std::to_string(j));
+      }
+      results[i] = pool.Intern("messages");
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& result : results) {
+    EXPECT_EQ(results[0], result);
+  }
+  EXPECT_EQ(808u, pool.lookup_count());
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/remote/document_view.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::FieldPath;
+using model::FieldValue;
+
+namespace {
+
+const int kDocuments = 100;
+
+/**
+ * Encodes a batch of objects, each with the given number of 100-byte string
+ * fields and a nested "meta.rank" integer field that a query might filter on.
+ */
+std::vector<std::vector<uint8_t>> MakeEncodedObjects(int fields) {
+  std::vector<std::vector<uint8_t>> result;
+  for (int i = 0; i < kDocuments; i++) {
+    std::map<std::string, FieldValue> object;
+    for (int j = 0; j < fields; j++) {
+      object["field" + std::to_string(j)] =
+          FieldValue::StringValue(std::string(100, 'a' + j % 26));
+    }
+    object["meta"] =
+        FieldValue::ObjectValue({{"rank", FieldValue::IntegerValue(i)}});
+
+    std::vector<uint8_t> bytes;
+    Serializer::EncodeFieldValue(FieldValue::ObjectValue(object), &bytes);
+    result.push_back(std::move(bytes));
+  }
+  return result;
+}
+
+}  // namespace
+
+void BM_FilterByDecoding(benchmark::State& state) {
+  std::vector<std::vector<uint8_t>> objects =
+      MakeEncodedObjects(state.range(0));
+  const FieldPath path{"meta", "rank"};
+  for (auto _ : state) {
+    int matches = 0;
+    for (const std::vector<uint8_t>& bytes : objects) {
+      FieldValue value = Serializer::DecodeFieldValue(bytes);
+      const FieldValue* rank = value.Get(path);
+      if (rank != nullptr && rank->integer_value() % 10 == 0) {
+        matches++;
+      }
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * kDocuments);
+}
+BENCHMARK(BM_FilterByDecoding)->Arg(10)->Arg(100);
+
+void BM_FilterByView(benchmark::State& state) {
+  std::vector<std::vector<uint8_t>> objects =
+      MakeEncodedObjects(state.range(0));
+  const FieldPath path{"meta", "rank"};
+  for (auto _ : state) {
+    int matches = 0;
+    for (const std::vector<uint8_t>& bytes : objects) {
+      FieldValueView value{bytes.data(), bytes.size()};
+      FieldValueView rank;
+      if (value.Get(path, &rank) && rank.integer_value() % 10 == 0) {
+        matches++;
+      }
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * kDocuments);
+}
+BENCHMARK(BM_FilterByView)->Arg(10)->Arg(100);
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* NB: As in serializer_test.cc, proto bytes were created with protoc from the
+ * TEXT_FORMAT_PROTO given alongside them.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/document_view.h"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::FieldPath;
+using model::FieldValue;
+using Type = FieldValue::Type;
+
+namespace {
+
+std::vector<uint8_t> Encode(const FieldValue& value) {
+  std::vector<uint8_t> bytes;
+  Serializer::EncodeFieldValue(value, &bytes);
+  return bytes;
+}
+
+FieldValueView View(const std::vector<uint8_t>& bytes) {
+  return FieldValueView{bytes.data(), bytes.size()};
+}
+
+/** Checks that the given string_view points into the given bytes. */
+bool PointsInto(absl::string_view view, const std::vector<uint8_t>& bytes) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(view.data());
+  return data >= bytes.data() &&
+         data + view.size() <= bytes.data() + bytes.size();
+}
+
+FieldValue TestObject() {
+  FieldValue nested = FieldValue::ObjectValue(
+      {{"e", FieldValue::IntegerValue(std::numeric_limits<int64_t>::max())}});
+  return FieldValue::ObjectValue(
+      {{"b", FieldValue::TrueValue()},
+       {"i", FieldValue::IntegerValue(1)},
+       {"n", FieldValue::NullValue()},
+       {"o", FieldValue::ObjectValue({{"d", FieldValue::IntegerValue(100)},
+                                      {"nested", nested}})},
+       {"s", FieldValue::StringValue("foo")}});
+}
+
+}  // namespace
+
+TEST(FieldValueView, DefaultIsNull) {
+  FieldValueView view;
+  EXPECT_EQ(Type::Null, view.type());
+  EXPECT_EQ(FieldValue::NullValue(), view.ToFieldValue());
+}
+
+TEST(FieldValueView, ViewsScalars) {
+  std::vector<uint8_t> bytes = Encode(FieldValue::NullValue());
+  EXPECT_EQ(Type::Null, View(bytes).type());
+
+  bytes = Encode(FieldValue::TrueValue());
+  EXPECT_EQ(Type::Boolean, View(bytes).type());
+  EXPECT_TRUE(View(bytes).boolean_value());
+
+  bytes = Encode(FieldValue::FalseValue());
+  EXPECT_FALSE(View(bytes).boolean_value());
+
+  for (int64_t value : {int64_t{0}, int64_t{-100},
+                        std::numeric_limits<int64_t>::min(),
+                        std::numeric_limits<int64_t>::max()}) {
+    bytes = Encode(FieldValue::IntegerValue(value));
+    EXPECT_EQ(Type::Integer, View(bytes).type());
+    EXPECT_EQ(value, View(bytes).integer_value());
+  }
+
+  bytes = Encode(FieldValue::StringValue("abc def"));
+  FieldValueView view = View(bytes);
+  EXPECT_EQ(Type::String, view.type());
+  EXPECT_EQ("abc def", view.string_value());
+  EXPECT_TRUE(PointsInto(view.string_value(), bytes));
+}
+
+TEST(FieldValueView, ViewsDoublesAndBlobs) {
+  // TEXT_FORMAT_PROTO: 'double_value: 1.5'
+  std::vector<uint8_t> bytes{0x19, 0x00, 0x00, 0x00, 0x00,
+                             0x00, 0x00, 0xf8, 0x3f};
+  EXPECT_EQ(Type::Double, View(bytes).type());
+  EXPECT_EQ(1.5, View(bytes).double_value());
+
+  // TEXT_FORMAT_PROTO: 'bytes_value: "\001\002"'
+  bytes = {0x92, 0x01, 0x02, 0x01, 0x02};
+  FieldValueView view = View(bytes);
+  EXPECT_EQ(Type::Blob, view.type());
+  EXPECT_EQ(absl::string_view("\x01\x02", 2), view.blob_value());
+  EXPECT_TRUE(PointsInto(view.blob_value(), bytes));
+}
+
+TEST(FieldValueView, ViewsTimestampsAndGeoPoints) {
+  // TEXT_FORMAT_PROTO: 'timestamp_value: {seconds: 1 nanos: 2}'
+  std::vector<uint8_t> bytes{0x52, 0x04, 0x08, 0x01, 0x10, 0x02};
+  EXPECT_EQ(Type::Timestamp, View(bytes).type());
+  EXPECT_EQ(model::Timestamp(1, 2), View(bytes).timestamp_value());
+
+  // TEXT_FORMAT_PROTO: 'geo_point_value: {latitude: 1.5 longitude: -2}'
+  bytes = {0x42, 0x12, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+           0xf8, 0x3f, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+           0x00, 0xc0};
+  EXPECT_EQ(Type::GeoPoint, View(bytes).type());
+  EXPECT_EQ(GeoPoint(1.5, -2), View(bytes).geo_point_value());
+}
+
+TEST(FieldValueView, ViewsReferences) {
+  // TEXT_FORMAT_PROTO:
+  //   'reference_value: "projects/p/databases/d/documents/a/b"'
+  std::string name = "projects/p/databases/d/documents/a/b";
+  std::vector<uint8_t> bytes{0x2a, static_cast<uint8_t>(name.size())};
+  bytes.insert(bytes.end(), name.begin(), name.end());
+  FieldValueView view = View(bytes);
+  EXPECT_EQ(Type::Reference, view.type());
+  EXPECT_EQ(name, view.reference_value());
+  EXPECT_TRUE(PointsInto(view.reference_value(), bytes));
+}
+
+TEST(FieldValueView, ViewsArrays) {
+  // TEXT_FORMAT_PROTO: 'array_value: {values: {integer_value: 1}
+  //                                   values: {string_value: "a"}}'
+  std::vector<uint8_t> bytes{0x4a, 0x0a, 0x0a, 0x02, 0x10, 0x01, 0x0a,
+                             0x04, 0x8a, 0x01, 0x01, 0x61};
+  FieldValueView view = View(bytes);
+  EXPECT_EQ(Type::Array, view.type());
+  std::vector<FieldValueView> elements = view.array_value();
+  ASSERT_EQ(2u, elements.size());
+  EXPECT_EQ(1, elements[0].integer_value());
+  EXPECT_EQ("a", elements[1].string_value());
+
+  // TEXT_FORMAT_PROTO: 'array_value: {}'
+  bytes = {0x4a, 0x00};
+  EXPECT_TRUE(View(bytes).array_value().empty());
+}
+
+TEST(FieldValueView, GetsFields) {
+  std::vector<uint8_t> bytes = Encode(TestObject());
+  FieldValueView view = View(bytes);
+  EXPECT_EQ(Type::Object, view.type());
+
+  FieldValueView field;
+  ASSERT_TRUE(view.GetField("i", &field));
+  EXPECT_EQ(1, field.integer_value());
+  ASSERT_TRUE(view.GetField("s", &field));
+  EXPECT_EQ("foo", field.string_value());
+  EXPECT_TRUE(PointsInto(field.string_value(), bytes));
+  EXPECT_FALSE(view.GetField("x", &field));
+  EXPECT_FALSE(view.GetField("", &field));
+
+  ASSERT_TRUE(view.Get(FieldPath::FromServerFormat("o.nested.e"), &field));
+  EXPECT_EQ(std::numeric_limits<int64_t>::max(), field.integer_value());
+  ASSERT_TRUE(view.Get(FieldPath::FromServerFormat("o.d"), &field));
+  EXPECT_EQ(100, field.integer_value());
+  EXPECT_FALSE(view.Get(FieldPath::FromServerFormat("o.x"), &field));
+  EXPECT_FALSE(view.Get(FieldPath::FromServerFormat("i.x"), &field));
+
+  ASSERT_TRUE(view.Get(FieldPath::EmptyPath(), &field));
+  EXPECT_EQ(TestObject(), field.ToFieldValue());
+}
+
+TEST(FieldValueView, DecodesToFieldValues) {
+  for (const FieldValue& value :
+       {FieldValue::NullValue(), FieldValue::TrueValue(),
+        FieldValue::IntegerValue(-1), FieldValue::StringValue("foo"),
+        FieldValue::ObjectValue({}), TestObject()}) {
+    std::vector<uint8_t> bytes = Encode(value);
+    EXPECT_EQ(value, View(bytes).ToFieldValue());
+  }
+
+  std::vector<uint8_t> bytes = Encode(TestObject());
+  FieldValueView field;
+  ASSERT_TRUE(View(bytes).GetField("o", &field));
+  FieldValue object = TestObject();
+  EXPECT_EQ(*object.Get(FieldPath::FromServerFormat("o")),
+            field.ToFieldValue());
+}
+
+TEST(FieldValueView, LastValueWinsAndUnknownFieldsAreSkipped) {
+  // TEXT_FORMAT_PROTO: 'integer_value: 1 boolean_value: true'
+  std::vector<uint8_t> bytes{0x10, 0x01, 0x08, 0x01};
+  EXPECT_EQ(Type::Boolean, View(bytes).type());
+  EXPECT_TRUE(View(bytes).boolean_value());
+
+  // An unknown field 100 (varint 7) followed by 'integer_value: 2'.
+  bytes = {0xa0, 0x06, 0x07, 0x10, 0x02};
+  EXPECT_EQ(Type::Integer, View(bytes).type());
+  EXPECT_EQ(2, View(bytes).integer_value());
+}
+
+TEST(FieldValueView, LastMapEntryWins) {
+  // TEXT_FORMAT_PROTO: 'map_value: {
+  //   fields: {key: "a", value: {integer_value: 1}}
+  //   fields: {key: "a", value: {integer_value: 2}}}'
+  std::vector<uint8_t> bytes{0x32, 0x12, 0x0a, 0x07, 0x0a, 0x01, 'a',
+                             0x12, 0x02, 0x10, 0x01, 0x0a, 0x07, 0x0a,
+                             0x01, 'a',  0x12, 0x02, 0x10, 0x02};
+  FieldValueView field;
+  ASSERT_TRUE(View(bytes).GetField("a", &field));
+  EXPECT_EQ(2, field.integer_value());
+}
+
+TEST(DocumentView, GetsNameAndFields) {
+  // Build a Document from its name and the fields of TestObject(), which
+  // share the layout of MapValue's fields.
+  //
+  // TEXT_FORMAT_PROTO (for google.firestore.v1beta1.Document):
+  // 'name: "projects/p/databases/d/documents/rooms/eros"
+  //  fields: {key: "b", value: {boolean_value: true}}
+  //  ...'
+  std::string name = "projects/p/databases/d/documents/rooms/eros";
+  std::vector<uint8_t> bytes{0x0a, static_cast<uint8_t>(name.size())};
+  bytes.insert(bytes.end(), name.begin(), name.end());
+  std::vector<uint8_t> object = Encode(TestObject());
+  // Skip the map_value tag and length to get to the entries, whose tag (1) is
+  // replaced with Document's fields tag (2).
+  for (size_t i = 2; i < object.size();) {
+    ASSERT_EQ(0x0a, object[i]);
+    size_t entry_size = object[i + 1] + 2u;
+    bytes.push_back(0x12);
+    bytes.insert(bytes.end(), object.begin() + i + 1,
+                 object.begin() + i + entry_size);
+    i += entry_size;
+  }
+
+  DocumentView document{bytes.data(), bytes.size()};
+  EXPECT_EQ(name, document.name());
+  EXPECT_TRUE(PointsInto(document.name(), bytes));
+
+  FieldValueView field;
+  ASSERT_TRUE(document.Get(FieldPath::FromServerFormat("b"), &field));
+  EXPECT_TRUE(field.boolean_value());
+  ASSERT_TRUE(document.Get(FieldPath::FromServerFormat("o.nested.e"), &field));
+  EXPECT_EQ(std::numeric_limits<int64_t>::max(), field.integer_value());
+  ASSERT_TRUE(document.Get(FieldPath::FromServerFormat("o.nested"), &field));
+  EXPECT_EQ(Type::Object, field.type());
+  EXPECT_FALSE(document.Get(FieldPath::FromServerFormat("x"), &field));
+  EXPECT_FALSE(document.Get(FieldPath::FromServerFormat("s.x"), &field));
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
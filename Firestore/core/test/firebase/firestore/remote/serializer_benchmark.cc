@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::FieldValue;
+using util::Arena;
+
+namespace {
+
+/**
+ * Encodes an object with the given number of child objects, each of which has
+ * ten integer fields.
+ */
+std::vector<uint8_t> MakeEncodedObject(int children) {
+  std::map<std::string, FieldValue> root;
+  for (int i = 0; i < children; i++) {
+    std::map<std::string, FieldValue> child;
+    for (int j = 0; j < 10; j++) {
+      child["field" + std::to_string(j)] = FieldValue::IntegerValue(j);
+    }
+    root["child" + std::to_string(i)] = FieldValue::ObjectValue(child);
+  }
+
+  std::vector<uint8_t> bytes;
+  Serializer::EncodeFieldValue(FieldValue::ObjectValue(root), &bytes);
+  return bytes;
+}
+
+}  // namespace
+
+void BM_DecodeOnHeap(benchmark::State& state) {
+  std::vector<uint8_t> bytes = MakeEncodedObject(state.range(0));
+  for (auto _ : state) {
+    FieldValue value = Serializer::DecodeFieldValue(bytes);
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_DecodeOnHeap)->Arg(10)->Arg(1000);
+
+void BM_DecodeInArena(benchmark::State& state) {
+  std::vector<uint8_t> bytes = MakeEncodedObject(state.range(0));
+  for (auto _ : state) {
+    FieldValue value = Serializer::DecodeFieldValue(
+        bytes.data(), bytes.size(), std::make_shared<Arena>());
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_DecodeInArena)->Arg(10)->Arg(1000);
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
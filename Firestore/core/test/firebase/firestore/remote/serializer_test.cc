@@ -39,13 +39,19 @@
 #include <pb.h>
 #include <pb_encode.h>
 #include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
+#include "Firestore/core/src/firebase/firestore/util/shared_bytes.h"
 #include "gtest/gtest.h"
 
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::remote::Serializer;
+using firebase::firestore::util::Arena;
+using firebase::firestore::util::SharedBytes;
 
 TEST(Serializer, CanLinkToNanopb) {
   // This test doesn't actually do anything interesting as far as actually using
@@ -193,6 +199,25 @@ TEST_F(SerializerTest, WritesStringModelToBytes) {
   }
 }
 
+TEST_F(SerializerTest, WritesBlobModelToBytes) {
+  struct TestCase {
+    std::vector<uint8_t> value;
+    std::vector<uint8_t> bytes;
+  };
+
+  std::vector<TestCase> cases{
+      // TEXT_FORMAT_PROTO: 'bytes_value: ""'
+      {{}, {0x92, 0x01, 0x00}},
+      // TEXT_FORMAT_PROTO: 'bytes_value: "\001\002\003"'
+      {{0x01, 0x02, 0x03}, {0x92, 0x01, 0x03, 0x01, 0x02, 0x03}}};
+
+  for (const TestCase& test : cases) {
+    FieldValue model =
+        FieldValue::BlobValue(test.value.data(), test.value.size());
+    ExpectRoundTrip(model, test.bytes, FieldValue::Type::Blob);
+  }
+}
+
 TEST_F(SerializerTest, WritesEmptyMapToBytes) {
   FieldValue model = FieldValue::ObjectValue({});
   // TEXT_FORMAT_PROTO: 'map_value: {}'
@@ -228,10 +253,11 @@ TEST_F(SerializerTest, WritesNestedObjectsToBytes) {
    * - https://developers.google.com/protocol-buffers/docs/proto#maps-features
    *
    * In reality, the map items are serialized by protoc in whatever order you
-   * provide them in. Since FieldValue::ObjectValue is currently backed by a
-   * std::map (and not an unordered_map) this implies ~alpha ordering. So we
-   * need to provide the text format input in alpha ordering for things to match
-   * up.
+   * provide them in. Since FieldValue::ObjectValue is currently backed by an
+   * immutable::SortedMap (an array sorted by key up to Map::kFixedSize fields,
+   * and a tree beyond that, but never an unordered_map) this implies ~alpha
+   * ordering. So we need to provide the text format input in alpha ordering
+   * for things to match up.
    *
    * This is... not ideal. Nothing stops libprotobuf from changing this
    * behaviour (since it's not guaranteed) nor does anything stop us from
@@ -273,6 +299,78 @@ TEST_F(SerializerTest, WritesNestedObjectsToBytes) {
   ExpectRoundTrip(model, bytes, FieldValue::Type::Object);
 }
 
+TEST_F(SerializerTest, DecodesIntoArena) {
+  FieldValue model = FieldValue::ObjectValue(
+      {{"a", FieldValue::ObjectValue({{"b", FieldValue::IntegerValue(1)}})},
+       {"s", FieldValue::StringValue("foo")}});
+  std::vector<uint8_t> bytes;
+  serializer.EncodeFieldValue(model, &bytes);
+
+  auto arena = std::make_shared<Arena>();
+  std::weak_ptr<Arena> weak_arena = arena;
+  FieldValue decoded = serializer.DecodeFieldValue(bytes.data(), bytes.size(),
+                                                   arena);
+  EXPECT_EQ(model, decoded);
+  // Both objects, and their fields, are in the arena.
+  using array_type = FieldValue::Map::array_type::array_type;
+  EXPECT_LE(2 * sizeof(array_type) + 3 * sizeof(array_type::value_type),
+            arena->bytes_allocated());
+
+  // The decoded value keeps the arena alive until it's gone.
+  arena.reset();
+  EXPECT_FALSE(weak_arena.expired());
+  EXPECT_EQ(model, decoded);
+  decoded = FieldValue::NullValue();
+  EXPECT_TRUE(weak_arena.expired());
+}
+
+TEST_F(SerializerTest, DecodesSmallObjectsIntoFewArenaBlocks) {
+  FieldValue::FieldList points;
+  for (int i = 0; i < 50; i++) {
+    points.emplace_back(
+        "p" + std::to_string(i),
+        FieldValue::ObjectValue({{"lat", FieldValue::IntegerValue(i)},
+                                 {"lng", FieldValue::IntegerValue(-i)}}));
+  }
+  FieldValue model = FieldValue::FromFields(&points);
+  std::vector<uint8_t> bytes;
+  serializer.EncodeFieldValue(model, &bytes);
+
+  auto arena = std::make_shared<Arena>();
+  FieldValue decoded = serializer.DecodeFieldValue(bytes.data(), bytes.size(),
+                                                   arena);
+  EXPECT_EQ(model, decoded);
+  // Each point takes a small slice of a shared block, rather than a block of
+  // its own.
+  EXPECT_GT(10u, arena->block_count());
+}
+
+TEST_F(SerializerTest, DecodesBlobsWithoutCopying) {
+  const uint8_t blob[] = {0x01, 0x02, 0x03};
+  FieldValue model = FieldValue::ObjectValue(
+      {{"b", FieldValue::BlobValue(blob, sizeof(blob))}});
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  serializer.EncodeFieldValue(model, buffer.get());
+  std::weak_ptr<std::vector<uint8_t>> weak_buffer = buffer;
+
+  FieldValue decoded = serializer.DecodeFieldValue(
+      SharedBytes::Wrap(buffer, buffer->capacity(), buffer->data(),
+                        buffer->size()));
+  EXPECT_EQ(model, decoded);
+
+  // The blob points into the buffer, and keeps it alive until it's gone.
+  const SharedBytes& decoded_blob =
+      decoded.object_value().begin()->second.blob_value();
+  EXPECT_LE(buffer->data(), decoded_blob.data());
+  EXPECT_GE(buffer->data() + buffer->size(), decoded_blob.end());
+
+  buffer.reset();
+  EXPECT_FALSE(weak_buffer.expired());
+  EXPECT_EQ(model, decoded);
+  decoded = FieldValue::NullValue();
+  EXPECT_TRUE(weak_buffer.expired());
+}
+
 // TODO(rsgowman): Test [en|de]coding multiple protos into the same output
 // vector.
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/arena.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(ArenaTest, AllocatesAlignedMemory) {
+  Arena arena{64};
+  for (size_t alignment : {1, 2, 4, 8, 16}) {
+    arena.Allocate(1, 1);
+    void* memory = arena.Allocate(3, alignment);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(memory) % alignment);
+  }
+}
+
+TEST(ArenaTest, AllocatesFromBlocks) {
+  Arena arena{64};
+  EXPECT_EQ(0u, arena.block_count());
+
+  char* first = static_cast<char*>(arena.Allocate(8, 1));
+  char* second = static_cast<char*>(arena.Allocate(8, 1));
+  EXPECT_EQ(first + 8, second);
+  EXPECT_EQ(1u, arena.block_count());
+
+  // Filling the block starts another.
+  for (int i = 0; i < 6; i++) {
+    arena.Allocate(8, 1);
+  }
+  EXPECT_EQ(1u, arena.block_count());
+  arena.Allocate(8, 1);
+  EXPECT_EQ(2u, arena.block_count());
+  EXPECT_EQ(72u, arena.bytes_allocated());
+
+  // Large allocations get blocks of their own, without disturbing the current
+  // block.
+  char* before = static_cast<char*>(arena.Allocate(1, 1));
+  arena.Allocate(100, 1);
+  EXPECT_EQ(3u, arena.block_count());
+  char* after = static_cast<char*>(arena.Allocate(1, 1));
+  EXPECT_EQ(before + 1, after);
+}
+
+TEST(ArenaAllocatorTest, AllocatesFromArenaOrHeap) {
+  auto arena = std::make_shared<Arena>();
+  std::vector<int, ArenaAllocator<int>> in_arena{ArenaAllocator<int>{arena}};
+  in_arena.assign({1, 2, 3});
+  EXPECT_EQ(1u, arena->block_count());
+  EXPECT_LE(3 * sizeof(int), arena->bytes_allocated());
+
+  std::vector<int, ArenaAllocator<int>> on_heap{1, 2, 3};
+  EXPECT_EQ(nullptr, on_heap.get_allocator().arena());
+  EXPECT_EQ(in_arena, on_heap);
+  EXPECT_NE(in_arena.get_allocator(), on_heap.get_allocator());
+}
+
+TEST(ArenaAllocatorTest, CopiesAreMadeOnTheHeap) {
+  auto arena = std::make_shared<Arena>();
+  std::vector<std::string, ArenaAllocator<std::string>> original{
+      ArenaAllocator<std::string>{arena}};
+  original.emplace_back("foo");
+
+  auto copy = original;
+  EXPECT_EQ(nullptr, copy.get_allocator().arena());
+  EXPECT_EQ(original, copy);
+
+  auto moved = std::move(original);
+  EXPECT_EQ(arena, moved.get_allocator().arena());
+}
+
+TEST(ArenaAllocatorTest, KeepsArenaAlive) {
+  std::weak_ptr<Arena> weak_arena;
+  std::shared_ptr<std::string> value;
+  {
+    auto arena = std::make_shared<Arena>();
+    weak_arena = arena;
+    ArenaAllocator<std::string> allocator{arena};
+    value = std::allocate_shared<std::string>(allocator, "foo");
+  }
+  EXPECT_FALSE(weak_arena.expired());
+  EXPECT_EQ("foo", *value);
+
+  value.reset();
+  EXPECT_TRUE(weak_arena.expired());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -49,6 +49,14 @@ TEST(Comparison, ReverseOrder) {
   ASSERT_SAME(ReverseOrder(ComparisonResult::Same));
 }
 
+TEST(Comparison, ComparisonResultFromInt) {
+  ASSERT_ASCENDING(ComparisonResultFromInt(-10));
+  ASSERT_ASCENDING(ComparisonResultFromInt(-1));
+  ASSERT_SAME(ComparisonResultFromInt(0));
+  ASSERT_DESCENDING(ComparisonResultFromInt(1));
+  ASSERT_DESCENDING(ComparisonResultFromInt(42));
+}
+
 TEST(Comparison, StringCompare) {
   ASSERT_ASCENDING(Compare<absl::string_view>("", "a"));
   ASSERT_ASCENDING(Compare<absl::string_view>("a", "b"));
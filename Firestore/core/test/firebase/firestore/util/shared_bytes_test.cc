@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/shared_bytes.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(SharedBytesTest, CopiesAreShallow) {
+  const uint8_t bytes[] = {1, 2, 3};
+  SharedBytes original{bytes, sizeof(bytes)};
+  EXPECT_NE(bytes, original.data());
+  EXPECT_EQ(3u, original.size());
+
+  SharedBytes copy = original;
+  EXPECT_EQ(original.data(), copy.data());
+  EXPECT_EQ(original, copy);
+  EXPECT_EQ((std::vector<uint8_t>{1, 2, 3}),
+            std::vector<uint8_t>(copy.begin(), copy.end()));
+}
+
+TEST(SharedBytesTest, TakesOverVectors) {
+  std::vector<uint8_t> bytes{1, 2, 3};
+  const uint8_t* data = bytes.data();
+  SharedBytes shared{std::move(bytes)};
+  EXPECT_EQ(data, shared.data());
+  EXPECT_EQ(3u, shared.size());
+}
+
+TEST(SharedBytesTest, EmptyBytesHaveNoStorage) {
+  SharedBytes empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(nullptr, empty.data());
+  EXPECT_EQ(0u, empty.HeapMemoryUsage());
+  EXPECT_EQ(empty, SharedBytes(std::vector<uint8_t>{}));
+}
+
+TEST(SharedBytesTest, SlicesShareTheOwner) {
+  std::weak_ptr<std::vector<uint8_t>> weak_buffer;
+  SharedBytes slice;
+  {
+    auto buffer = std::make_shared<std::vector<uint8_t>>(
+        std::vector<uint8_t>{1, 2, 3, 4, 5});
+    weak_buffer = buffer;
+    SharedBytes whole = SharedBytes::Wrap(buffer, buffer->capacity(),
+                                          buffer->data(), buffer->size());
+    slice = whole.Slice(1, 3);
+    EXPECT_EQ(buffer->data() + 1, slice.data());
+  }
+  EXPECT_FALSE(weak_buffer.expired());
+  EXPECT_EQ(3u, slice.size());
+  EXPECT_EQ(2, slice[0]);
+  EXPECT_EQ(4, slice[2]);
+
+  slice = SharedBytes{};
+  EXPECT_TRUE(weak_buffer.expired());
+}
+
+TEST(SharedBytesTest, Compare) {
+  const uint8_t bytes[] = {1, 2, 3};
+  SharedBytes abc{bytes, 3};
+  SharedBytes ab{bytes, 2};
+  SharedBytes bc{bytes + 1, 2};
+  EXPECT_EQ(ComparisonResult::Same, abc.Compare(abc));
+  EXPECT_EQ(ComparisonResult::Ascending, ab.Compare(abc));
+  EXPECT_EQ(ComparisonResult::Descending, abc.Compare(ab));
+  EXPECT_EQ(ComparisonResult::Ascending, abc.Compare(bc));
+  EXPECT_EQ(ComparisonResult::Ascending, SharedBytes{}.Compare(ab));
+  EXPECT_NE(ab, bc);
+}
+
+TEST(SharedBytesTest, HeapMemoryUsage) {
+  const uint8_t bytes[] = {1, 2, 3};
+  SharedBytes original{bytes, sizeof(bytes)};
+  SharedBytes copy = original;
+  EXPECT_LT(3u, original.HeapMemoryUsage());
+
+  CountedAllocations counted;
+  size_t usage = original.HeapMemoryUsage(&counted);
+  EXPECT_EQ(original.HeapMemoryUsage(), usage);
+  EXPECT_EQ(0u, copy.HeapMemoryUsage(&counted));
+}
+
+TEST(SharedBytesTest, SlicesCountTheWholeBuffer) {
+  auto buffer = std::make_shared<std::vector<uint8_t>>(1000);
+  SharedBytes whole = SharedBytes::Wrap(buffer, buffer->capacity(),
+                                        buffer->data(), buffer->size());
+  SharedBytes head = whole.Slice(0, 10);
+  SharedBytes tail = whole.Slice(990, 10);
+  EXPECT_LT(1000u, head.HeapMemoryUsage());
+  EXPECT_EQ(whole.HeapMemoryUsage(), head.HeapMemoryUsage());
+
+  CountedAllocations counted;
+  EXPECT_EQ(whole.HeapMemoryUsage(), head.HeapMemoryUsage(&counted));
+  EXPECT_EQ(0u, tail.HeapMemoryUsage(&counted));
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -18,6 +18,7 @@ ExternalProject_Add(
   Firestore
   DEPENDS
     FirebaseCore
+    benchmark
     googletest
     leveldb
     grpc
@@ -67,6 +67,46 @@ function(cc_test name)
   target_link_libraries(${name} ${cct_DEPENDS})
 endfunction()
 
+# cc_benchmark(
+#   target
+#   SOURCES sources...
+#   DEPENDS libraries...
+# )
+#
+# Defines a new benchmark executable target with the given target name,
+# sources, and dependencies. Implicitly adds DEPENDS on benchmark and
+# benchmark_main. Benchmarks are built along with everything else but are not
+# registered with CTest; run them directly, or build the run_${name} target
+# (or the benchmarks target, which runs all of them). The run targets also
+# write the results as JSON to ${PROJECT_BINARY_DIR}/benchmarks/${name}.json,
+# for tracking performance over time.
+function(cc_benchmark name)
+  set(multi DEPENDS SOURCES)
+  cmake_parse_arguments(ccb "" "" "${multi}" ${ARGN})
+
+  list(APPEND ccb_DEPENDS benchmark benchmark_main)
+
+  add_executable(${name} ${ccb_SOURCES})
+  add_objc_flags(${name} ccb)
+
+  target_link_libraries(${name} ${ccb_DEPENDS})
+
+  set(output_dir ${PROJECT_BINARY_DIR}/benchmarks)
+  add_custom_target(
+    run_${name}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${output_dir}
+    COMMAND ${name}
+      --benchmark_out=${output_dir}/${name}.json
+      --benchmark_out_format=json
+    DEPENDS ${name}
+    USES_TERMINAL
+  )
+  if(NOT TARGET benchmarks)
+    add_custom_target(benchmarks)
+  endif()
+  add_dependencies(benchmarks run_${name})
+endfunction()
+
 # add_objc_flags(target sources...)
 #
 # Adds OBJC_FLAGS to the compile options of the given target if any of the